@@ -0,0 +1,45 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CONTAINERS_IDCURSOR_H_
+#define CONTAINERS_IDCURSOR_H_
+
+#include <cstdint>
+
+namespace mqttsn {
+
+// Moves a rolling cursor over 16-bit identifiers to the next one not in use; false if
+// all of them are. ID=0 is invalid and ID=UINT16_MAX can be considered invalid. The
+// cursor holds the last issued identifier and always moves past it first, so a freed
+// identifier is issued again only after the cursor has wrapped around.
+template<typename IsUsed>
+bool advanceIdCursor(uint32_t usedCount, IsUsed isUsed, uint16_t& currentId, bool allowMaxValue = true)
+{
+    uint16_t maxValue = allowMaxValue ? UINT16_MAX : UINT16_MAX - 1;
+
+    if (usedCount >= maxValue) {
+        return false;
+    }
+
+    do {
+        currentId = (currentId == 0 || currentId >= maxValue) ? 1 : currentId + 1;
+    } while (isUsed(currentId));
+
+    return true;
+}
+
+} /* namespace mqttsn */
+
+#endif /* CONTAINERS_IDCURSOR_H_ */
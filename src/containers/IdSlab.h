@@ -0,0 +1,143 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CONTAINERS_IDSLAB_H_
+#define CONTAINERS_IDSLAB_H_
+
+#include "IdCursor.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace mqttsn {
+
+// Storage of values indexed by a 16-bit identifier. Slots live in pages of
+// PAGE_SIZE entries allocated on first use and released once empty, so lookups
+// are two array accesses and references stay valid until the value is erased.
+// An occupancy bitmap drives iteration in identifier order and the search for
+// free identifiers.
+template<typename T>
+class IdSlab
+{
+    protected:
+        static constexpr uint32_t ID_COUNT = uint32_t(UINT16_MAX) + 1;
+        static constexpr uint32_t PAGE_BITS = 8;
+        static constexpr uint32_t PAGE_SIZE = uint32_t(1) << PAGE_BITS;
+        static constexpr uint32_t WORD_BITS = 64;
+
+        using Page = std::array<T, PAGE_SIZE>;
+
+        std::array<std::unique_ptr<Page>, ID_COUNT / PAGE_SIZE> pages;
+        std::array<uint16_t, ID_COUNT / PAGE_SIZE> pageCounts = {};
+        std::array<uint64_t, ID_COUNT / WORD_BITS> occupied = {};
+        uint32_t count = 0;
+
+    protected:
+        T& slot(uint16_t id)
+        {
+            std::unique_ptr<Page>& page = pages[id >> PAGE_BITS];
+            if (!page) {
+                page.reset(new Page());
+            }
+
+            return (*page)[id & (PAGE_SIZE - 1)];
+        }
+
+    public:
+        IdSlab() {};
+
+        bool contains(uint16_t id) const { return (occupied[id / WORD_BITS] >> (id % WORD_BITS)) & 1; }
+
+        T* find(uint16_t id) { return contains(id) ? &(*pages[id >> PAGE_BITS])[id & (PAGE_SIZE - 1)] : nullptr; }
+        const T* find(uint16_t id) const { return contains(id) ? &(*pages[id >> PAGE_BITS])[id & (PAGE_SIZE - 1)] : nullptr; }
+
+        // stores the value under the identifier, replacing any previous one
+        T& insert(uint16_t id, const T& value)
+        {
+            if (!contains(id)) {
+                occupied[id / WORD_BITS] |= uint64_t(1) << (id % WORD_BITS);
+                pageCounts[id >> PAGE_BITS]++;
+                count++;
+            }
+
+            T& stored = slot(id);
+            stored = value;
+
+            return stored;
+        }
+
+        bool erase(uint16_t id)
+        {
+            if (!contains(id)) {
+                return false;
+            }
+
+            // release the resources held by the value, or the whole page once it is empty
+            if (--pageCounts[id >> PAGE_BITS] == 0) {
+                pages[id >> PAGE_BITS].reset();
+            }
+            else {
+                slot(id) = T();
+            }
+
+            occupied[id / WORD_BITS] &= ~(uint64_t(1) << (id % WORD_BITS));
+            count--;
+
+            return true;
+        }
+
+        void clear()
+        {
+            for (auto& page : pages) {
+                page.reset();
+            }
+
+            occupied.fill(0);
+            pageCounts.fill(0);
+            count = 0;
+        }
+
+        uint32_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // all valid identifiers are in use; ID=0 is invalid and ID=UINT16_MAX can be considered invalid
+        bool isFull(bool allowMaxValue = true) const { return count >= (allowMaxValue ? UINT16_MAX : UINT16_MAX - 1); }
+
+        // smallest used identifier not below the given one, or -1 if there is none
+        int32_t nextId(uint32_t id) const
+        {
+            while (id < ID_COUNT) {
+                uint64_t word = occupied[id / WORD_BITS] >> (id % WORD_BITS);
+                if (word != 0) {
+                    return id + __builtin_ctzll(word);
+                }
+
+                // continue at the start of the next word
+                id = (id / WORD_BITS + 1) * WORD_BITS;
+            }
+
+            return -1;
+        }
+
+        // moves the current identifier to the next available one; false if all identifiers are in use
+        bool setNextAvailableId(uint16_t& currentId, bool allowMaxValue = true) const
+        {
+            return advanceIdCursor(count, [this](uint16_t id) { return contains(id); }, currentId, allowMaxValue);
+        }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CONTAINERS_IDSLAB_H_ */
@@ -0,0 +1,108 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "IdentifierBitmap.h"
+
+namespace mqttsn {
+
+bool IdentifierBitmap::insert(uint64_t identifier)
+{
+    uint64_t chunkIndex = identifier / CHUNK_BITS;
+
+    // identifiers behind the window are considered seen
+    if (chunkIndex < horizonChunkIndex) {
+        return false;
+    }
+
+    if (chunks.empty()) {
+        firstChunkIndex = chunkIndex;
+    }
+
+    // extend the sequence down or up to the chunk of the identifier
+    while (chunkIndex < firstChunkIndex) {
+        chunks.emplace_front();
+        chunks.front().fill(0);
+        firstChunkIndex--;
+    }
+
+    while (chunkIndex >= firstChunkIndex + chunks.size()) {
+        chunks.emplace_back();
+        chunks.back().fill(0);
+    }
+
+    uint64_t bit = identifier % CHUNK_BITS;
+    uint64_t& word = chunks[chunkIndex - firstChunkIndex][bit / WORD_BITS];
+    uint64_t mask = uint64_t(1) << (bit % WORD_BITS);
+
+    if (word & mask) {
+        return false;
+    }
+
+    word |= mask;
+    count++;
+
+    if (windowSize > 0) {
+        evictChunks(identifier);
+    }
+
+    return true;
+}
+
+bool IdentifierBitmap::contains(uint64_t identifier) const
+{
+    uint64_t chunkIndex = identifier / CHUNK_BITS;
+
+    if (chunkIndex < horizonChunkIndex) {
+        return true;
+    }
+
+    if (chunks.empty() || chunkIndex < firstChunkIndex || chunkIndex >= firstChunkIndex + chunks.size()) {
+        return false;
+    }
+
+    uint64_t bit = identifier % CHUNK_BITS;
+    return chunks[chunkIndex - firstChunkIndex][bit / WORD_BITS] & (uint64_t(1) << (bit % WORD_BITS));
+}
+
+void IdentifierBitmap::evictChunks(uint64_t highestIdentifier)
+{
+    if (highestIdentifier < windowSize) {
+        return;
+    }
+
+    // release chunks lying entirely before the window
+    uint64_t windowStartChunk = (highestIdentifier - windowSize) / CHUNK_BITS;
+
+    if (windowStartChunk <= horizonChunkIndex) {
+        return;
+    }
+
+    horizonChunkIndex = windowStartChunk;
+
+    while (!chunks.empty() && firstChunkIndex < horizonChunkIndex) {
+        chunks.pop_front();
+        firstChunkIndex++;
+    }
+}
+
+void IdentifierBitmap::clear()
+{
+    chunks.clear();
+    firstChunkIndex = 0;
+    horizonChunkIndex = 0;
+    count = 0;
+}
+
+} /* namespace mqttsn */
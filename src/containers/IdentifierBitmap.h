@@ -0,0 +1,68 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CONTAINERS_IDENTIFIERBITMAP_H_
+#define CONTAINERS_IDENTIFIERBITMAP_H_
+
+#include <array>
+#include <cstdint>
+#include <deque>
+
+namespace mqttsn {
+
+// Set of increasing identifiers stored as a sequence of fixed size bit chunks.
+// When a window size is given, chunks falling entirely behind the highest
+// identifier minus the window are released; identifiers behind the window are
+// reported as already seen by insert and contains, and as expired by isExpired.
+class IdentifierBitmap
+{
+    protected:
+        static constexpr unsigned CHUNK_BITS = 4096;
+        static constexpr unsigned WORD_BITS = 64;
+
+        using Chunk = std::array<uint64_t, CHUNK_BITS / WORD_BITS>;
+
+        std::deque<Chunk> chunks;
+        uint64_t firstChunkIndex = 0;
+
+        // chunks before this index were released
+        uint64_t horizonChunkIndex = 0;
+
+        uint64_t windowSize;
+        uint64_t count = 0;
+
+    protected:
+        void evictChunks(uint64_t highestIdentifier);
+
+    public:
+        IdentifierBitmap(uint64_t windowSize = 0) : windowSize(windowSize) {};
+
+        // returns true if the identifier was not seen before
+        bool insert(uint64_t identifier);
+        bool contains(uint64_t identifier) const;
+
+        // true if the identifier lies in a released chunk, so whether it was seen is unknown
+        bool isExpired(uint64_t identifier) const { return identifier / CHUNK_BITS < horizonChunkIndex; }
+
+        // number of distinct identifiers inserted, including evicted ones
+        uint64_t size() const { return count; }
+
+        void clear();
+        void setWindowSize(uint64_t windowSize) { this->windowSize = windowSize; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CONTAINERS_IDENTIFIERBITMAP_H_ */
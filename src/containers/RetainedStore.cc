@@ -0,0 +1,248 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "RetainedStore.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mqttsn {
+
+void RetainedStore::linkFront(uint16_t topicId, Entry& entry)
+{
+    entry.prev = -1;
+    entry.next = head;
+
+    if (head != -1) {
+        entries.find(head)->prev = topicId;
+    }
+
+    head = topicId;
+
+    if (tail == -1) {
+        tail = topicId;
+    }
+}
+
+void RetainedStore::unlink(Entry& entry)
+{
+    if (entry.prev != -1) {
+        entries.find(entry.prev)->next = entry.next;
+    }
+    else {
+        head = entry.next;
+    }
+
+    if (entry.next != -1) {
+        entries.find(entry.next)->prev = entry.prev;
+    }
+    else {
+        tail = entry.prev;
+    }
+
+    entry.prev = -1;
+    entry.next = -1;
+}
+
+void RetainedStore::remove(uint16_t topicId)
+{
+    Entry* entry = entries.find(topicId);
+
+    unlink(*entry);
+    usedBytes -= entry->size;
+    entries.erase(topicId);
+}
+
+void RetainedStore::compact()
+{
+    // move the live payloads to the front of the arena in offset order
+    std::vector<std::pair<size_t, uint16_t>> live;
+    live.reserve(entries.size());
+
+    for (int32_t topicId = entries.nextId(0); topicId != -1; topicId = entries.nextId(topicId + 1)) {
+        const Entry* entry = entries.find(topicId);
+        if (entry->size > 0) {
+            live.emplace_back(entry->offset, topicId);
+        }
+    }
+
+    std::sort(live.begin(), live.end());
+
+    size_t position = 0;
+    for (const auto& item : live) {
+        Entry* entry = entries.find(item.second);
+
+        if (entry->offset != position) {
+            std::memmove(arena.data() + position, arena.data() + entry->offset, entry->size);
+            entry->offset = position;
+        }
+
+        position += entry->size;
+    }
+
+    arenaEnd = position;
+}
+
+bool RetainedStore::isExpired(const Entry& entry, double now) const
+{
+    return timeToLive > 0 && (now - entry.storedTime) >= timeToLive;
+}
+
+void RetainedStore::setLimits(size_t byteBudget, size_t maxMessageSize, double timeToLive)
+{
+    this->byteBudget = byteBudget;
+    this->maxMessageSize = maxMessageSize;
+    this->timeToLive = timeToLive;
+}
+
+bool RetainedStore::put(uint16_t topicId, const RetainMessageInfo& info, const std::string& data, double now,
+                        std::vector<uint16_t>& evictedIds)
+{
+    size_t size = data.size();
+
+    if ((maxMessageSize > 0 && size > maxMessageSize) || (byteBudget > 0 && size > byteBudget)) {
+        rejections++;
+        return false;
+    }
+
+    // the previous payload of the topic becomes dead space in the arena
+    Entry* entry = entries.find(topicId);
+    if (entry != nullptr) {
+        unlink(*entry);
+        usedBytes -= entry->size;
+        entry->size = 0;
+    }
+
+    if (byteBudget > 0 && usedBytes + size > byteBudget) {
+        // reclaim expired messages first, then the least recently used ones
+        expire(now, evictedIds);
+
+        while (usedBytes + size > byteBudget && tail != -1) {
+            uint16_t victimId = tail;
+            remove(victimId);
+
+            evictions++;
+            evictedIds.push_back(victimId);
+        }
+    }
+
+    // compact once the dead space outweighs the live payloads or the budget would be crossed
+    if ((arenaEnd - usedBytes) > (usedBytes + size) || (byteBudget > 0 && arenaEnd + size > byteBudget)) {
+        compact();
+    }
+
+    if (arena.size() < arenaEnd + size) {
+        size_t capacity = std::max(arenaEnd + size, arena.size() * 2);
+        arena.resize(byteBudget > 0 ? std::min(capacity, byteBudget) : capacity);
+    }
+
+    if (entry == nullptr) {
+        entry = &entries.insert(topicId, Entry());
+    }
+
+    if (size > 0) {
+        std::memcpy(arena.data() + arenaEnd, data.data(), size);
+    }
+
+    entry->info = info;
+    entry->offset = arenaEnd;
+    entry->size = size;
+    entry->storedTime = now;
+    linkFront(topicId, *entry);
+
+    arenaEnd += size;
+    usedBytes += size;
+    peakBytes = std::max(peakBytes, usedBytes);
+
+    return true;
+}
+
+const RetainMessageInfo* RetainedStore::find(uint16_t topicId, double now)
+{
+    Entry* entry = entries.find(topicId);
+    if (entry == nullptr || isExpired(*entry, now)) {
+        return nullptr;
+    }
+
+    // mark as most recently used
+    if (head != topicId) {
+        unlink(*entry);
+        linkFront(topicId, *entry);
+    }
+
+    return &entry->info;
+}
+
+void RetainedStore::readData(uint16_t topicId, std::string& data) const
+{
+    const Entry* entry = entries.find(topicId);
+    if (entry == nullptr || entry->size == 0) {
+        data.clear();
+        return;
+    }
+
+    data.assign(arena.data() + entry->offset, entry->size);
+}
+
+const RetainMessageInfo* RetainedStore::peek(uint16_t topicId) const
+{
+    const Entry* entry = entries.find(topicId);
+    return entry != nullptr ? &entry->info : nullptr;
+}
+
+bool RetainedStore::erase(uint16_t topicId)
+{
+    if (!entries.contains(topicId)) {
+        return false;
+    }
+
+    remove(topicId);
+    return true;
+}
+
+void RetainedStore::clear()
+{
+    entries.clear();
+
+    arenaEnd = 0;
+    usedBytes = 0;
+
+    head = -1;
+    tail = -1;
+}
+
+void RetainedStore::expire(double now, std::vector<uint16_t>& expiredIds)
+{
+    if (timeToLive <= 0) {
+        return;
+    }
+
+    for (int32_t topicId = entries.nextId(0); topicId != -1; topicId = entries.nextId(topicId + 1)) {
+        const Entry* entry = entries.find(topicId);
+
+        // entries being replaced are not linked and keep their slot
+        if (entry->prev == -1 && head != topicId) {
+            continue;
+        }
+
+        if (isExpired(*entry, now)) {
+            remove(topicId);
+
+            expirations++;
+            expiredIds.push_back(topicId);
+        }
+    }
+}
+
+} /* namespace mqttsn */
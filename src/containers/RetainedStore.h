@@ -0,0 +1,113 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CONTAINERS_RETAINEDSTORE_H_
+#define CONTAINERS_RETAINEDSTORE_H_
+
+#include "containers/IdSlab.h"
+#include "types/shared/QoS.h"
+#include "types/shared/TopicIdType.h"
+#include "types/server/RetainMessageInfo.h"
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// Retained messages indexed by topic ID. Payloads live in one contiguous arena
+// bounded by a byte budget; space is reclaimed by compacting the live payloads.
+// When the budget is exceeded, expired messages are evicted first and then the
+// least recently used ones.
+class RetainedStore
+{
+    protected:
+        struct Entry {
+            RetainMessageInfo info;
+            size_t offset = 0;
+            size_t size = 0;
+            double storedTime = 0;
+
+            // least recently used list links, -1 marks the list ends
+            int32_t prev = -1;
+            int32_t next = -1;
+        };
+
+        IdSlab<Entry> entries;
+        std::vector<char> arena;
+
+        size_t byteBudget = 0;
+        size_t maxMessageSize = 0;
+        double timeToLive = 0;
+
+        // arena bytes written so far and bytes held by stored payloads
+        size_t arenaEnd = 0;
+        size_t usedBytes = 0;
+        size_t peakBytes = 0;
+
+        // most and least recently used topic IDs
+        int32_t head = -1;
+        int32_t tail = -1;
+
+        // statistics
+        uint64_t evictions = 0;
+        uint64_t expirations = 0;
+        uint64_t rejections = 0;
+
+    protected:
+        void linkFront(uint16_t topicId, Entry& entry);
+        void unlink(Entry& entry);
+        void remove(uint16_t topicId);
+        void compact();
+        bool isExpired(const Entry& entry, double now) const;
+
+    public:
+        RetainedStore() {};
+
+        // a zero budget, message size or time to live means no limit
+        void setLimits(size_t byteBudget, size_t maxMessageSize, double timeToLive);
+
+        // stores or replaces the message of a topic; returns false if the payload cannot be retained.
+        // Topics whose message was evicted to make room are appended to evictedIds
+        bool put(uint16_t topicId, const RetainMessageInfo& info, const std::string& data, double now,
+                 std::vector<uint16_t>& evictedIds);
+
+        // returns nullptr if the topic has no live message; a hit marks the message as recently used
+        const RetainMessageInfo* find(uint16_t topicId, double now);
+        void readData(uint16_t topicId, std::string& data) const;
+
+        // lookup and iteration in topic ID order that leave the recency and expiry untouched
+        const RetainMessageInfo* peek(uint16_t topicId) const;
+        int32_t nextId(uint32_t topicId) const { return entries.nextId(topicId); }
+
+        bool contains(uint16_t topicId) const { return entries.contains(topicId); }
+        bool erase(uint16_t topicId);
+        void clear();
+
+        // removes the expired messages and appends their topic IDs to expiredIds
+        void expire(double now, std::vector<uint16_t>& expiredIds);
+
+        uint32_t size() const { return entries.size(); }
+        bool isFull() const { return entries.isFull(false); }
+
+        size_t getUsedBytes() const { return usedBytes; }
+        size_t getPeakBytes() const { return peakBytes; }
+        size_t getArenaBytes() const { return arena.size(); }
+        uint64_t getEvictions() const { return evictions; }
+        uint64_t getExpirations() const { return expirations; }
+        uint64_t getRejections() const { return rejections; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CONTAINERS_RETAINEDSTORE_H_ */
@@ -0,0 +1,106 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CONTAINERS_SPSCQUEUE_H_
+#define CONTAINERS_SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace mqttsn {
+
+// Bounded queue between exactly one producer thread and one consumer thread. The
+// capacity is rounded up to a power of two. Head and tail sit on their own cache
+// lines, and each side keeps a cached copy of the other side's index so that the
+// shared index is only read again when the queue looks full or empty.
+template<typename T>
+class SpscQueue
+{
+    protected:
+        static constexpr size_t CACHE_LINE = 64;
+
+        size_t mask;
+        std::unique_ptr<T[]> slots;
+
+        // consumer side
+        alignas(CACHE_LINE) std::atomic<size_t> head{0};
+        size_t cachedTail = 0;
+
+        // producer side
+        alignas(CACHE_LINE) std::atomic<size_t> tail{0};
+        size_t cachedHead = 0;
+
+    protected:
+        static size_t roundCapacity(size_t capacity)
+        {
+            size_t rounded = 2;
+            while (rounded < capacity) {
+                rounded <<= 1;
+            }
+
+            return rounded;
+        }
+
+    public:
+        SpscQueue(size_t capacity) : mask(roundCapacity(capacity) - 1), slots(new T[mask + 1]) {};
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // producer only; false when the queue is full, leaving the value untouched
+        bool push(T&& value)
+        {
+            size_t currentTail = tail.load(std::memory_order_relaxed);
+
+            if (currentTail - cachedHead > mask) {
+                cachedHead = head.load(std::memory_order_acquire);
+
+                if (currentTail - cachedHead > mask) {
+                    return false;
+                }
+            }
+
+            slots[currentTail & mask] = std::move(value);
+            tail.store(currentTail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // consumer only; false when the queue is empty
+        bool pop(T& value)
+        {
+            size_t currentHead = head.load(std::memory_order_relaxed);
+
+            if (currentHead == cachedTail) {
+                cachedTail = tail.load(std::memory_order_acquire);
+
+                if (currentHead == cachedTail) {
+                    return false;
+                }
+            }
+
+            value = std::move(slots[currentHead & mask]);
+            head.store(currentHead + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        size_t capacity() const { return mask + 1; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CONTAINERS_SPSCQUEUE_H_ */
@@ -0,0 +1,561 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "BrokerCore.h"
+#include "WireCodec.h"
+#include <algorithm>
+
+namespace mqttsn {
+
+BrokerCore::BrokerCore(BrokerTransport& transport, const BrokerClock& clock, const BrokerConfig& config, TopicRegistry* sharedRegistry) :
+        config(config), transport(transport), clock(clock),
+        ownedRegistry(sharedRegistry == nullptr ? new LocalTopicRegistry(config.maximumTopics) : nullptr),
+        registry(sharedRegistry != nullptr ? *sharedRegistry : *ownedRegistry), topics(1)
+{
+}
+
+void BrokerCore::addPredefinedTopic(const std::string& topicName, uint16_t topicId)
+{
+    registry.addPredefinedTopic(topicName, topicId);
+}
+
+void BrokerCore::publish(uint16_t topicId, QoS qos, const std::string& data, bool retain)
+{
+    if (registry.getTopicName(topicId) != nullptr) {
+        dispatch(topicId, qos, data, retain);
+    }
+}
+
+void BrokerCore::handleDatagram(EndpointId endpoint, const uint8_t* data, size_t length)
+{
+    CorePacket packet;
+
+    if (!WireCodec::decode(data, length, packet)) {
+        stats.malformedPackets++;
+        return;
+    }
+
+    handlePacket(endpoint, packet);
+}
+
+void BrokerCore::handlePacket(EndpointId endpoint, const CorePacket& packet)
+{
+    stats.receivedPackets++;
+
+    if (packet.msgType == MsgType::SEARCHGW) {
+        CorePacket gwInfo;
+        gwInfo.msgType = MsgType::GWINFO;
+        gwInfo.gatewayId = config.gatewayId;
+        send(endpoint, gwInfo);
+        return;
+    }
+
+    if (packet.msgType == MsgType::CONNECT) {
+        processConnect(endpoint, packet);
+        return;
+    }
+
+    // every other message requires a connected session
+    auto it = sessions.find(endpoint);
+    if (it == sessions.end() || !it->second.connected) {
+        // except QoS -1 publications, which name a predefined or short topic and need no connection
+        if (packet.msgType == MsgType::PUBLISH && packet.getQoS() == QoS::QOS_MINUS_ONE &&
+            packet.getTopicIdType() != TopicIdType::NORMAL_TOPIC_ID) {
+            processPublishWithoutSession(packet);
+        }
+        return;
+    }
+
+    Session& session = it->second;
+    session.lastSeen = clock.now();
+
+    switch (packet.msgType) {
+        case MsgType::REGISTER:
+            processRegister(endpoint, session, packet);
+            break;
+
+        case MsgType::SUBSCRIBE:
+            processSubscribe(endpoint, session, packet);
+            break;
+
+        case MsgType::UNSUBSCRIBE:
+            processUnsubscribe(endpoint, session, packet);
+            break;
+
+        case MsgType::PUBLISH:
+            processPublish(endpoint, session, packet);
+            break;
+
+        case MsgType::PUBREL:
+            processPubRel(endpoint, session, packet);
+            break;
+
+        case MsgType::PUBACK:
+            processPubAck(endpoint, session, packet);
+            break;
+
+        case MsgType::PUBREC:
+            processPubRec(endpoint, packet);
+            break;
+
+        case MsgType::PUBCOMP:
+            processPubComp(endpoint, session, packet);
+            break;
+
+        case MsgType::PINGREQ: {
+            CorePacket pingResp;
+            pingResp.msgType = MsgType::PINGRESP;
+            send(endpoint, pingResp);
+            break;
+        }
+
+        case MsgType::DISCONNECT:
+            processDisconnect(endpoint, session);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void BrokerCore::tick()
+{
+    double now = clock.now();
+
+    for (auto it = outboundMessages.begin(); it != outboundMessages.end();) {
+        OutboundMessage& message = it->second;
+
+        if (now - message.sentTime < config.retransmissionInterval) {
+            ++it;
+            continue;
+        }
+
+        if (message.retransmissions >= config.retransmissionCounter) {
+            auto session = sessions.find(message.endpoint);
+            if (session != sessions.end()) {
+                session->second.outboundCount--;
+            }
+
+            stats.droppedMessages++;
+            it = outboundMessages.erase(it);
+            continue;
+        }
+
+        // a PUBLISH is retransmitted with the DUP flag; a PUBREL has no flags
+        if (message.packet.msgType == MsgType::PUBLISH) {
+            message.packet.flags |= 1 << Flag::DUP;
+        }
+
+        message.sentTime = now;
+        message.retransmissions++;
+        stats.retransmittedMessages++;
+
+        send(message.endpoint, message.packet);
+        ++it;
+    }
+
+    for (auto it = sessions.begin(); it != sessions.end(); ++it) {
+        Session& session = it->second;
+
+        if (session.connected && session.keepAlive > 0 && now - session.lastSeen > session.keepAlive * config.keepAliveFactor) {
+            session.connected = false;
+            stats.expiredSessions++;
+        }
+    }
+}
+
+void BrokerCore::send(EndpointId endpoint, const CorePacket& packet)
+{
+    WireCodec::encode(packet, encodeBuffer);
+    transport.send(endpoint, encodeBuffer.data(), encodeBuffer.size());
+    stats.sentPackets++;
+}
+
+void BrokerCore::sendAck(EndpointId endpoint, MsgType msgType, uint16_t topicId, uint16_t msgId, ReturnCode returnCode)
+{
+    CorePacket ack;
+    ack.msgType = msgType;
+    ack.topicId = topicId;
+    ack.msgId = msgId;
+    ack.returnCode = returnCode;
+    send(endpoint, ack);
+}
+
+void BrokerCore::processConnect(EndpointId endpoint, const CorePacket& packet)
+{
+    CorePacket connAck;
+    connAck.msgType = MsgType::CONNACK;
+
+    if (packet.getWill()) {
+        connAck.returnCode = ReturnCode::REJECTED_NOT_SUPPORTED;
+        send(endpoint, connAck);
+        return;
+    }
+
+    Session& session = sessions[endpoint];
+
+    // a new client on the same endpoint never inherits the previous session
+    if (packet.getCleanSession() || session.clientId != packet.text) {
+        clearSession(endpoint, session);
+    }
+
+    session.clientId = packet.text;
+    session.connected = true;
+    session.keepAlive = packet.duration;
+    session.lastSeen = clock.now();
+
+    connAck.returnCode = ReturnCode::ACCEPTED;
+    send(endpoint, connAck);
+}
+
+void BrokerCore::processRegister(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    uint16_t topicId = registry.getOrCreateTopicId(packet.text);
+    sendAck(endpoint, MsgType::REGACK, topicId, packet.msgId, topicId > 0 ? ReturnCode::ACCEPTED : ReturnCode::REJECTED_CONGESTION);
+}
+
+void BrokerCore::processSubscribe(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    CorePacket subAck;
+    subAck.msgType = MsgType::SUBACK;
+    subAck.msgId = packet.msgId;
+
+    QoS qos = packet.getQoS() == QoS::QOS_MINUS_ONE ? QoS::QOS_ZERO : packet.getQoS();
+    TopicIdType topicIdType = packet.getTopicIdType();
+    uint16_t topicId = 0;
+
+    if (topicIdType == TopicIdType::PRE_DEFINED_TOPIC_ID) {
+        topicId = registry.isPredefined(packet.topicId) ? packet.topicId : 0;
+        subAck.returnCode = topicId > 0 ? ReturnCode::ACCEPTED : ReturnCode::REJECTED_INVALID_TOPIC_ID;
+    }
+    else if (packet.text.find_first_of("+#") != std::string::npos) {
+        subAck.returnCode = ReturnCode::REJECTED_NOT_SUPPORTED;
+    }
+    else {
+        topicId = registry.getOrCreateTopicId(packet.text);
+        subAck.returnCode = topicId > 0 ? ReturnCode::ACCEPTED : ReturnCode::REJECTED_CONGESTION;
+    }
+
+    if (subAck.returnCode != ReturnCode::ACCEPTED) {
+        send(endpoint, subAck);
+        return;
+    }
+
+    // a repeated subscription only updates the granted QoS
+    std::vector<Subscriber>& subscribers = getTopic(topicId).subscribers;
+    auto it = std::find_if(subscribers.begin(), subscribers.end(), [endpoint](const Subscriber& s) { return s.endpoint == endpoint; });
+
+    if (it != subscribers.end()) {
+        it->qos = qos;
+    }
+    else {
+        subscribers.push_back(Subscriber{endpoint, qos});
+        session.topicIds.insert(topicId);
+
+        if (subscribers.size() == 1 && relay != nullptr) {
+            relay->subscriptionChanged(topicId, true);
+        }
+    }
+
+    // short topics are identified by their name, so their SUBACK carries no topic ID
+    subAck.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID);
+    subAck.topicId = topicIdType == TopicIdType::SHORT_TOPIC_ID ? 0 : topicId;
+    send(endpoint, subAck);
+
+    const Topic& topic = getTopic(topicId);
+    if (topic.hasRetained) {
+        deliver(endpoint, session, topicId, std::min(qos, topic.retainedQoS), topic.retainedData, true);
+    }
+}
+
+void BrokerCore::processUnsubscribe(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    uint16_t topicId = packet.getTopicIdType() == TopicIdType::PRE_DEFINED_TOPIC_ID ? packet.topicId : registry.findTopicId(packet.text);
+
+    if (topicId > 0 && session.topicIds.erase(topicId) > 0) {
+        removeSubscriber(topicId, endpoint);
+    }
+
+    CorePacket unsubAck;
+    unsubAck.msgType = MsgType::UNSUBACK;
+    unsubAck.msgId = packet.msgId;
+    send(endpoint, unsubAck);
+}
+
+void BrokerCore::processPublish(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    QoS qos = packet.getQoS() == QoS::QOS_MINUS_ONE ? QoS::QOS_ZERO : packet.getQoS();
+    uint16_t topicId = resolvePublishTopic(packet);
+
+    if (topicId == 0) {
+        if (qos != QoS::QOS_ZERO) {
+            sendAck(endpoint, MsgType::PUBACK, packet.topicId, packet.msgId, ReturnCode::REJECTED_INVALID_TOPIC_ID);
+        }
+        return;
+    }
+
+    // a retransmitted QoS 2 publication only repeats the PUBREC, so it is not refused
+    bool duplicate = qos == QoS::QOS_TWO && session.inboundMessages.count(packet.msgId) > 0;
+    if (relay != nullptr && relay->isCongested() && !duplicate) {
+        stats.rejectedMessages++;
+        if (qos != QoS::QOS_ZERO) {
+            sendAck(endpoint, MsgType::PUBACK, packet.topicId, packet.msgId, ReturnCode::REJECTED_CONGESTION);
+        }
+        return;
+    }
+
+    stats.publishedMessages++;
+
+    if (qos == QoS::QOS_TWO) {
+        // a duplicate only repeats the PUBREC; the message is dispatched once on PUBREL
+        session.inboundMessages.emplace(packet.msgId, InboundMessage{topicId, qos, packet.getRetain(), packet.data});
+
+        CorePacket pubRec;
+        pubRec.msgType = MsgType::PUBREC;
+        pubRec.msgId = packet.msgId;
+        send(endpoint, pubRec);
+        return;
+    }
+
+    accept(topicId, qos, packet.data, packet.getRetain());
+
+    if (qos == QoS::QOS_ONE) {
+        sendAck(endpoint, MsgType::PUBACK, packet.topicId, packet.msgId, ReturnCode::ACCEPTED);
+    }
+}
+
+void BrokerCore::processPublishWithoutSession(const CorePacket& packet)
+{
+    uint16_t topicId = resolvePublishTopic(packet);
+    if (topicId == 0) {
+        return;
+    }
+
+    if (relay != nullptr && relay->isCongested()) {
+        stats.rejectedMessages++;
+        return;
+    }
+
+    stats.publishedMessages++;
+    accept(topicId, QoS::QOS_ZERO, packet.data, packet.getRetain());
+}
+
+void BrokerCore::processPubRel(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    auto it = session.inboundMessages.find(packet.msgId);
+    if (it != session.inboundMessages.end()) {
+        InboundMessage message = std::move(it->second);
+        session.inboundMessages.erase(it);
+
+        accept(message.topicId, message.qos, message.data, message.retain);
+    }
+
+    CorePacket pubComp;
+    pubComp.msgType = MsgType::PUBCOMP;
+    pubComp.msgId = packet.msgId;
+    send(endpoint, pubComp);
+}
+
+void BrokerCore::processPubAck(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    auto it = outboundMessages.find(getOutboundKey(endpoint, packet.msgId));
+
+    if (it != outboundMessages.end() && it->second.packet.msgType == MsgType::PUBLISH) {
+        outboundMessages.erase(it);
+        session.outboundCount--;
+    }
+}
+
+void BrokerCore::processPubComp(EndpointId endpoint, Session& session, const CorePacket& packet)
+{
+    auto it = outboundMessages.find(getOutboundKey(endpoint, packet.msgId));
+
+    if (it != outboundMessages.end() && it->second.packet.msgType == MsgType::PUBREL) {
+        outboundMessages.erase(it);
+        session.outboundCount--;
+    }
+}
+
+void BrokerCore::processPubRec(EndpointId endpoint, const CorePacket& packet)
+{
+    auto it = outboundMessages.find(getOutboundKey(endpoint, packet.msgId));
+    if (it == outboundMessages.end()) {
+        return;
+    }
+
+    // the PUBLISH is acknowledged; from now on the PUBREL is retransmitted until the PUBCOMP
+    OutboundMessage& message = it->second;
+    message.packet = CorePacket();
+    message.packet.msgType = MsgType::PUBREL;
+    message.packet.msgId = packet.msgId;
+    message.sentTime = clock.now();
+    message.retransmissions = 0;
+
+    send(endpoint, message.packet);
+}
+
+void BrokerCore::processDisconnect(EndpointId endpoint, Session& session)
+{
+    session.connected = false;
+
+    CorePacket disconnect;
+    disconnect.msgType = MsgType::DISCONNECT;
+    send(endpoint, disconnect);
+}
+
+BrokerCore::Topic& BrokerCore::getTopic(uint16_t topicId)
+{
+    // topics registered by another core sharing the registry are not known here yet
+    if (topics.size() <= topicId) {
+        topics.resize(topicId + 1);
+    }
+
+    return topics[topicId];
+}
+
+uint16_t BrokerCore::resolvePublishTopic(const CorePacket& packet)
+{
+    switch (packet.getTopicIdType()) {
+        case TopicIdType::SHORT_TOPIC_ID: {
+            // the two characters of a short topic travel in the topic ID field
+            std::string topicName{(char) (packet.topicId >> 8), (char) (packet.topicId & 0xFF)};
+            return registry.getOrCreateTopicId(topicName);
+        }
+
+        case TopicIdType::PRE_DEFINED_TOPIC_ID:
+            return registry.isPredefined(packet.topicId) ? packet.topicId : 0;
+
+        default:
+            return registry.getTopicName(packet.topicId) != nullptr ? packet.topicId : 0;
+    }
+}
+
+void BrokerCore::removeSubscriber(uint16_t topicId, EndpointId endpoint)
+{
+    std::vector<Subscriber>& subscribers = getTopic(topicId).subscribers;
+
+    for (size_t i = 0; i < subscribers.size(); i++) {
+        if (subscribers[i].endpoint == endpoint) {
+            // the order of the subscribers does not matter
+            subscribers[i] = subscribers.back();
+            subscribers.pop_back();
+
+            if (subscribers.empty() && relay != nullptr) {
+                relay->subscriptionChanged(topicId, false);
+            }
+            return;
+        }
+    }
+}
+
+void BrokerCore::accept(uint16_t topicId, QoS qos, const std::string& data, bool retain)
+{
+    if (config.localDelivery) {
+        dispatch(topicId, qos, data, retain);
+    }
+
+    if (relay != nullptr) {
+        relay->relay(topicId, qos, data, retain);
+    }
+}
+
+void BrokerCore::dispatch(uint16_t topicId, QoS qos, const std::string& data, bool retain)
+{
+    if (retain) {
+        storeRetained(topicId, qos, data);
+    }
+
+    for (const Subscriber& subscriber : getTopic(topicId).subscribers) {
+        auto it = sessions.find(subscriber.endpoint);
+
+        if (it != sessions.end() && it->second.connected) {
+            deliver(subscriber.endpoint, it->second, topicId, std::min(qos, subscriber.qos), data, false);
+        }
+    }
+}
+
+void BrokerCore::deliver(EndpointId endpoint, Session& session, uint16_t topicId, QoS qos, const std::string& data, bool retain)
+{
+    const std::string& topicName = *registry.getTopicName(topicId);
+
+    CorePacket publish;
+    publish.msgType = MsgType::PUBLISH;
+    publish.data = data;
+
+    if (registry.isPredefined(topicId)) {
+        publish.setFlags(qos, TopicIdType::PRE_DEFINED_TOPIC_ID, retain);
+        publish.topicId = topicId;
+    }
+    else if (topicName.size() == 2) {
+        publish.setFlags(qos, TopicIdType::SHORT_TOPIC_ID, retain);
+        publish.topicId = (uint16_t) (((uint8_t) topicName[0] << 8) | (uint8_t) topicName[1]);
+    }
+    else {
+        publish.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID, retain);
+        publish.topicId = topicId;
+    }
+
+    if (qos != QoS::QOS_ZERO) {
+        // message ID 0 is reserved
+        session.nextMsgId = session.nextMsgId == UINT16_MAX ? 1 : session.nextMsgId + 1;
+        publish.msgId = session.nextMsgId;
+
+        // a message still waiting under the wrapped around ID is replaced
+        auto result = outboundMessages.emplace(getOutboundKey(endpoint, publish.msgId),
+                                               OutboundMessage{endpoint, publish, clock.now(), 0});
+        if (result.second) {
+            session.outboundCount++;
+        }
+        else {
+            result.first->second = OutboundMessage{endpoint, publish, clock.now(), 0};
+        }
+    }
+
+    send(endpoint, publish);
+    stats.deliveredMessages++;
+}
+
+void BrokerCore::storeRetained(uint16_t topicId, QoS qos, const std::string& data)
+{
+    Topic& topic = getTopic(topicId);
+
+    // an empty retained message clears the retained one
+    topic.hasRetained = !data.empty();
+    topic.retainedQoS = qos;
+    topic.retainedData = data;
+}
+
+void BrokerCore::clearSession(EndpointId endpoint, Session& session)
+{
+    for (uint16_t topicId : session.topicIds) {
+        removeSubscriber(topicId, endpoint);
+    }
+
+    session.topicIds.clear();
+    session.inboundMessages.clear();
+
+    // the scan over all outbound messages is skipped for sessions without any
+    for (auto it = outboundMessages.begin(); session.outboundCount > 0 && it != outboundMessages.end();) {
+        if (it->second.endpoint == endpoint) {
+            it = outboundMessages.erase(it);
+            session.outboundCount--;
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,186 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_BROKERCORE_H_
+#define CORE_BROKERCORE_H_
+
+#include "BrokerTransport.h"
+#include "CorePacket.h"
+#include "TopicRegistry.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace mqttsn {
+
+struct BrokerConfig {
+    uint8_t gatewayId = 1;
+    double retransmissionInterval = 10; // seconds before an unacknowledged PUBLISH or PUBREL is sent again
+    int retransmissionCounter = 3; // retransmissions before the message is dropped
+    double keepAliveFactor = 1.5; // a silent client is disconnected after this many keep alive periods
+    uint16_t maximumTopics = UINT16_MAX - 1;
+    bool localDelivery = true; // false when the relay gets every publication delivered back, as from an upstream broker
+};
+
+struct BrokerStats {
+    uint64_t receivedPackets = 0;
+    uint64_t malformedPackets = 0;
+    uint64_t sentPackets = 0;
+    uint64_t publishedMessages = 0;
+    uint64_t deliveredMessages = 0;
+    uint64_t retransmittedMessages = 0;
+    uint64_t droppedMessages = 0;
+    uint64_t rejectedMessages = 0; // publications refused while the relay is congested
+    uint64_t expiredSessions = 0;
+};
+
+// MQTT-SN broker logic without any simulation dependency: sessions, topic registration,
+// subscriptions, QoS 0/1/2 publish and delivery with retransmissions, and retained
+// messages. Datagrams come in through handleDatagram and go out through the transport;
+// time is read from the clock and retransmissions and keep alives are checked by tick.
+// Topic names and IDs live in a registry that several cores may share; publishes accepted
+// from clients are also handed to the relay, if any, so that other cores can deliver them.
+// Will messages, sleeping clients and wildcard subscriptions are not supported.
+//
+// This is a standalone subset broker for the native tools (gateway, benchmarks); it is not
+// the logic of the MqttSNServer module, which the simulation keeps using unchanged.
+class BrokerCore
+{
+    protected:
+        struct Subscriber {
+            EndpointId endpoint;
+            QoS qos;
+        };
+
+        struct Topic {
+            std::vector<Subscriber> subscribers;
+            bool hasRetained = false;
+            QoS retainedQoS = QoS::QOS_ZERO;
+            std::string retainedData;
+        };
+
+        // QoS 2 message received from a publisher and waiting for its PUBREL
+        struct InboundMessage {
+            uint16_t topicId;
+            QoS qos;
+            bool retain;
+            std::string data;
+        };
+
+        // QoS 1/2 message sent to a subscriber and waiting for its acknowledgment
+        struct OutboundMessage {
+            EndpointId endpoint;
+            CorePacket packet;
+            double sentTime;
+            int retransmissions;
+        };
+
+        struct Session {
+            std::string clientId;
+            bool connected = false;
+            uint16_t keepAlive = 0;
+            double lastSeen = 0;
+            uint16_t nextMsgId = 0;
+            size_t outboundCount = 0;
+            std::unordered_set<uint16_t> topicIds;
+            std::unordered_map<uint16_t, InboundMessage> inboundMessages;
+        };
+
+        BrokerConfig config;
+        BrokerTransport& transport;
+        const BrokerClock& clock;
+
+        std::unordered_map<EndpointId, Session> sessions;
+
+        std::unique_ptr<TopicRegistry> ownedRegistry;
+        TopicRegistry& registry;
+        BrokerRelay* relay = nullptr;
+
+        // subscribers and retained message per topic ID, grown on demand
+        std::vector<Topic> topics;
+
+        // outbound messages keyed by endpoint and message ID
+        std::unordered_map<uint64_t, OutboundMessage> outboundMessages;
+
+        BrokerStats stats;
+
+        // reused encoding buffer
+        std::vector<uint8_t> encodeBuffer;
+
+    protected:
+        static uint64_t getOutboundKey(EndpointId endpoint, uint16_t msgId) { return (endpoint << 16) | msgId; }
+
+        void send(EndpointId endpoint, const CorePacket& packet);
+        void sendAck(EndpointId endpoint, MsgType msgType, uint16_t topicId, uint16_t msgId, ReturnCode returnCode);
+
+        // incoming packet type methods
+        void processConnect(EndpointId endpoint, const CorePacket& packet);
+        void processRegister(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processSubscribe(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processUnsubscribe(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processPublish(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processPublishWithoutSession(const CorePacket& packet);
+        void processPubRel(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processPubAck(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processPubRec(EndpointId endpoint, const CorePacket& packet);
+        void processPubComp(EndpointId endpoint, Session& session, const CorePacket& packet);
+        void processDisconnect(EndpointId endpoint, Session& session);
+
+        // topic methods
+        Topic& getTopic(uint16_t topicId);
+        uint16_t resolvePublishTopic(const CorePacket& packet);
+        void removeSubscriber(uint16_t topicId, EndpointId endpoint);
+
+        // delivery methods
+        void accept(uint16_t topicId, QoS qos, const std::string& data, bool retain);
+        void dispatch(uint16_t topicId, QoS qos, const std::string& data, bool retain);
+        void deliver(EndpointId endpoint, Session& session, uint16_t topicId, QoS qos, const std::string& data, bool retain);
+        void storeRetained(uint16_t topicId, QoS qos, const std::string& data);
+
+        // session methods
+        void clearSession(EndpointId endpoint, Session& session);
+
+    public:
+        // without a shared registry the core owns one limited to the configured maximum topics
+        BrokerCore(BrokerTransport& transport, const BrokerClock& clock, const BrokerConfig& config = BrokerConfig(),
+                   TopicRegistry* sharedRegistry = nullptr);
+
+        void setRelay(BrokerRelay* relay) { this->relay = relay; }
+
+        // topics known to every client under a fixed ID
+        void addPredefinedTopic(const std::string& topicName, uint16_t topicId);
+
+        void handleDatagram(EndpointId endpoint, const uint8_t* data, size_t length);
+        void handlePacket(EndpointId endpoint, const CorePacket& packet);
+
+        // delivers a message accepted elsewhere, e.g. by another core; it is not relayed again
+        void publish(uint16_t topicId, QoS qos, const std::string& data, bool retain);
+
+        // retransmits or drops unacknowledged messages and expires silent sessions
+        void tick();
+
+        TopicRegistry& getTopicRegistry() { return registry; }
+
+        const BrokerStats& getStats() const { return stats; }
+        size_t getSessionCount() const { return sessions.size(); }
+        size_t getTopicCount() const { return registry.size(); }
+        size_t getOutboundCount() const { return outboundMessages.size(); }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_BROKERCORE_H_ */
@@ -0,0 +1,65 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_BROKERTRANSPORT_H_
+#define CORE_BROKERTRANSPORT_H_
+
+#include "types/shared/QoS.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mqttsn {
+
+// opaque client address; adapters map their own addresses to it, e.g. IPv4 address and port
+typedef uint64_t EndpointId;
+
+// Datagram output of the broker core
+class BrokerTransport
+{
+    public:
+        virtual ~BrokerTransport() {};
+
+        virtual void send(EndpointId endpoint, const uint8_t* data, size_t length) = 0;
+};
+
+// Time source of the broker core, in seconds
+class BrokerClock
+{
+    public:
+        virtual ~BrokerClock() {};
+
+        virtual double now() const = 0;
+};
+
+// Hand-off of publishes accepted by a broker core, to the other cores sharing its topic
+// registry or to an upstream broker
+class BrokerRelay
+{
+    public:
+        virtual ~BrokerRelay() {};
+
+        virtual void relay(uint16_t topicId, QoS qos, const std::string& data, bool retain) = 0;
+
+        // a topic of the core got its first subscriber or lost its last one
+        virtual void subscriptionChanged(uint16_t topicId, bool subscribed) {};
+
+        // while true, the core refuses new publications from its clients
+        virtual bool isCongested() const { return false; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_BROKERTRANSPORT_H_ */
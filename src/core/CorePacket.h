@@ -0,0 +1,59 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_COREPACKET_H_
+#define CORE_COREPACKET_H_
+
+#include <cstdint>
+#include <string>
+#include "types/shared/MsgType.h"
+#include "types/shared/QoS.h"
+#include "types/shared/ReturnCode.h"
+#include "types/shared/TopicIdType.h"
+#include "types/shared/Flag.h"
+
+namespace mqttsn {
+
+// Decoded MQTT-SN packet of the broker core. One flat structure covers every message
+// type; the codec only reads and writes the fields that belong to the type.
+struct CorePacket {
+    MsgType msgType = MsgType::PINGREQ;
+    uint8_t flags = 0;
+    uint8_t gatewayId = 0;
+    uint16_t topicId = 0;
+    uint16_t msgId = 0;
+    uint16_t duration = 0;
+    ReturnCode returnCode = ReturnCode::ACCEPTED;
+
+    // client ID, topic name or gateway address depending on the message type
+    std::string text;
+    std::string data;
+
+    QoS getQoS() const { return (QoS) ((flags >> Flag::QUALITY_OF_SERVICE) & 0b11); }
+    TopicIdType getTopicIdType() const { return (TopicIdType) ((flags >> Flag::TOPIC_ID_TYPE) & 0b11); }
+    bool getRetain() const { return (flags >> Flag::RETAIN) & 1; }
+    bool getDup() const { return (flags >> Flag::DUP) & 1; }
+    bool getWill() const { return (flags >> Flag::WILL) & 1; }
+    bool getCleanSession() const { return (flags >> Flag::CLEAN_SESSION) & 1; }
+
+    void setFlags(QoS qos, TopicIdType topicIdType, bool retain = false, bool dup = false)
+    {
+        flags = (qos << Flag::QUALITY_OF_SERVICE) | (topicIdType << Flag::TOPIC_ID_TYPE) | (retain << Flag::RETAIN) | (dup << Flag::DUP);
+    }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_COREPACKET_H_ */
@@ -0,0 +1,411 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "MqttBridge.h"
+#include "MqttCodec.h"
+#include <algorithm>
+
+namespace mqttsn {
+
+MqttBridge::MqttBridge(BrokerCore& core, UpstreamTransport& transport, const BrokerClock& clock, const BridgeConfig& config) :
+        core(core), registry(core.getTopicRegistry()), transport(transport), clock(clock), config(config),
+        connections(std::max(1, config.connections))
+{
+}
+
+uint16_t MqttBridge::nextPacketId(Connection& connection)
+{
+    // packet ID 0 is not allowed and IDs still waiting for an acknowledgment are skipped
+    do {
+        connection.nextPacketId = connection.nextPacketId == UINT16_MAX ? 1 : connection.nextPacketId + 1;
+    } while (connection.inflight.count(connection.nextPacketId) > 0 || connection.subscriptionPacketIds.count(connection.nextPacketId) > 0);
+
+    return connection.nextPacketId;
+}
+
+void MqttBridge::connectionOpened(int connection)
+{
+    Connection& upstream = connections[connection];
+    upstream.open = true;
+    upstream.connected = false;
+
+    MqttPacket connect;
+    connect.type = MqttPacketType::MQTT_CONNECT;
+    connect.clientId = config.clientId + "-" + std::to_string(connection);
+    connect.keepAlive = config.keepAlive;
+    connect.cleanSession = false;
+    send(upstream, connect);
+}
+
+void MqttBridge::connectionClosed(int connection)
+{
+    Connection& upstream = connections[connection];
+
+    if (upstream.connected) {
+        stats.reconnections++;
+    }
+
+    upstream.open = false;
+    upstream.connected = false;
+    upstream.input.clear();
+    upstream.output.clear();
+    upstream.subscriptionPacketIds.clear();
+}
+
+bool MqttBridge::handleStream(int connection, const uint8_t* data, size_t length)
+{
+    Connection& upstream = connections[connection];
+    upstream.input.insert(upstream.input.end(), data, data + length);
+
+    size_t offset = 0;
+    bool valid = true;
+
+    while (valid && offset < upstream.input.size()) {
+        MqttPacket packet;
+        size_t consumed = 0;
+
+        MqttCodec::DecodeResult result = MqttCodec::decode(upstream.input.data() + offset, upstream.input.size() - offset, packet, consumed);
+        if (result == MqttCodec::INCOMPLETE) {
+            break;
+        }
+
+        if (result == MqttCodec::MALFORMED) {
+            stats.malformedPackets++;
+            valid = false;
+            break;
+        }
+
+        offset += consumed;
+        valid = handlePacket(upstream, packet);
+    }
+
+    upstream.input.erase(upstream.input.begin(), upstream.input.begin() + std::min(offset, upstream.input.size()));
+    return valid;
+}
+
+void MqttBridge::tick()
+{
+    double now = clock.now();
+    bool sendBatch = now - lastSubscriptionBatch >= config.subscriptionBatchInterval;
+
+    if (sendBatch) {
+        lastSubscriptionBatch = now;
+    }
+
+    for (Connection& connection : connections) {
+        if (!connection.connected) {
+            continue;
+        }
+
+        if (sendBatch) {
+            sendSubscriptionChanges(connection);
+        }
+
+        if (config.keepAlive > 0 && now - connection.lastSent >= config.keepAlive / 2.0) {
+            MqttPacket pingReq;
+            pingReq.type = MqttPacketType::MQTT_PINGREQ;
+            send(connection, pingReq);
+        }
+    }
+}
+
+void MqttBridge::flush()
+{
+    for (size_t i = 0; i < connections.size(); i++) {
+        Connection& connection = connections[i];
+
+        if (connection.open && !connection.output.empty()) {
+            transport.write(i, connection.output.data(), connection.output.size());
+            connection.output.clear();
+        }
+    }
+}
+
+void MqttBridge::relay(uint16_t topicId, QoS qos, const std::string& data, bool retain)
+{
+    const std::string* topicName = registry.getTopicName(topicId);
+    if (topicName == nullptr) {
+        return;
+    }
+
+    Connection& connection = getConnection(topicId);
+
+    Publication publication;
+    publication.topic = *topicName;
+    publication.qos = qos == QoS::QOS_ONE ? 1 : qos == QoS::QOS_TWO ? 2 : 0;
+    publication.retain = retain;
+    publication.payload = data;
+
+    // publications queue behind older ones of the same connection, so the order per topic holds
+    connection.queue.push_back(std::move(publication));
+    queuedCount++;
+
+    sendQueued(connection);
+}
+
+void MqttBridge::subscriptionChanged(uint16_t topicId, bool subscribed)
+{
+    Connection& connection = getConnection(topicId);
+
+    // a change undone within the same batch cancels out
+    if (subscribed) {
+        if (connection.pendingUnsubscriptions.erase(topicId) == 0 && connection.subscribedTopicIds.count(topicId) == 0) {
+            connection.pendingSubscriptions.insert(topicId);
+        }
+    }
+    else {
+        if (connection.pendingSubscriptions.erase(topicId) == 0 && connection.subscribedTopicIds.count(topicId) > 0) {
+            connection.pendingUnsubscriptions.insert(topicId);
+        }
+    }
+}
+
+size_t MqttBridge::getInflightCount() const
+{
+    size_t count = 0;
+    for (const Connection& connection : connections) {
+        count += connection.inflight.size();
+    }
+
+    return count;
+}
+
+void MqttBridge::send(Connection& connection, const MqttPacket& packet)
+{
+    MqttCodec::append(packet, connection.output);
+    connection.lastSent = clock.now();
+}
+
+void MqttBridge::sendPublication(Connection& connection, uint16_t packetId, Publication& publication, bool dup)
+{
+    MqttPacket packet;
+
+    if (publication.released) {
+        packet.type = MqttPacketType::MQTT_PUBREL;
+        packet.packetId = packetId;
+        send(connection, packet);
+        return;
+    }
+
+    packet.type = MqttPacketType::MQTT_PUBLISH;
+    packet.qos = publication.qos;
+    packet.dup = dup;
+    packet.retain = publication.retain;
+    packet.packetId = packetId;
+    packet.topic = publication.topic;
+    packet.payload = publication.payload;
+    send(connection, packet);
+
+    if (!dup) {
+        stats.forwardedPublications++;
+    }
+}
+
+void MqttBridge::sendQueued(Connection& connection)
+{
+    while (connection.connected && !connection.queue.empty()) {
+        Publication& publication = connection.queue.front();
+
+        // QoS 0 publications take no window slot, but wait behind the ones that do
+        if (publication.qos > 0 && (int) connection.inflight.size() >= config.maxInflight) {
+            break;
+        }
+
+        if (publication.qos == 0) {
+            sendPublication(connection, 0, publication, false);
+        }
+        else {
+            uint16_t packetId = nextPacketId(connection);
+            publication.sequence = connection.nextSequence++;
+
+            Publication& inflight = connection.inflight.emplace(packetId, std::move(publication)).first->second;
+            sendPublication(connection, packetId, inflight, false);
+        }
+
+        connection.queue.pop_front();
+        queuedCount--;
+    }
+}
+
+void MqttBridge::sendSubscriptionChanges(Connection& connection)
+{
+    // brokers bound the packet size, so large batches are split
+    const size_t maxFilters = 256;
+
+    auto sendChanges = [&](std::unordered_set<uint16_t>& topicIds, MqttPacketType type) {
+        std::vector<std::string> topicFilters;
+
+        for (uint16_t topicId : topicIds) {
+            const std::string* topicName = registry.getTopicName(topicId);
+            if (topicName == nullptr) {
+                continue;
+            }
+
+            topicFilters.push_back(*topicName);
+
+            if (type == MqttPacketType::MQTT_SUBSCRIBE) {
+                connection.subscribedTopicIds.insert(topicId);
+            }
+            else {
+                connection.subscribedTopicIds.erase(topicId);
+            }
+        }
+
+        topicIds.clear();
+
+        for (size_t first = 0; first < topicFilters.size(); first += maxFilters) {
+            size_t last = std::min(first + maxFilters, topicFilters.size());
+
+            MqttPacket part;
+            part.type = type;
+            part.packetId = nextPacketId(connection);
+            part.topicFilters.assign(topicFilters.begin() + first, topicFilters.begin() + last);
+            if (type == MqttPacketType::MQTT_SUBSCRIBE) {
+                part.qosLevels.assign(last - first, config.subscriptionQoS);
+            }
+
+            connection.subscriptionPacketIds.insert(part.packetId);
+            send(connection, part);
+
+            if (type == MqttPacketType::MQTT_SUBSCRIBE) {
+                stats.subscribePackets++;
+            }
+            else {
+                stats.unsubscribePackets++;
+            }
+        }
+    };
+
+    sendChanges(connection.pendingSubscriptions, MqttPacketType::MQTT_SUBSCRIBE);
+    sendChanges(connection.pendingUnsubscriptions, MqttPacketType::MQTT_UNSUBSCRIBE);
+}
+
+bool MqttBridge::handlePacket(Connection& connection, const MqttPacket& packet)
+{
+    switch (packet.type) {
+        case MqttPacketType::MQTT_CONNACK:
+            if (packet.returnCode != 0) {
+                return false;
+            }
+            handleConnAck(connection, packet);
+            break;
+
+        case MqttPacketType::MQTT_PUBACK:
+        case MqttPacketType::MQTT_PUBCOMP:
+            completePublication(connection, packet.packetId);
+            break;
+
+        case MqttPacketType::MQTT_PUBREC: {
+            auto it = connection.inflight.find(packet.packetId);
+            if (it != connection.inflight.end()) {
+                it->second.released = true;
+                sendPublication(connection, packet.packetId, it->second, false);
+            }
+            break;
+        }
+
+        case MqttPacketType::MQTT_PUBLISH:
+            handleUpstreamPublish(connection, packet);
+            break;
+
+        case MqttPacketType::MQTT_PUBREL: {
+            connection.receivedPacketIds.erase(packet.packetId);
+
+            MqttPacket pubComp;
+            pubComp.type = MqttPacketType::MQTT_PUBCOMP;
+            pubComp.packetId = packet.packetId;
+            send(connection, pubComp);
+            break;
+        }
+
+        case MqttPacketType::MQTT_SUBACK:
+            connection.subscriptionPacketIds.erase(packet.packetId);
+            stats.rejectedSubscriptions += std::count(packet.qosLevels.begin(), packet.qosLevels.end(), 0x80);
+            break;
+
+        case MqttPacketType::MQTT_UNSUBACK:
+            connection.subscriptionPacketIds.erase(packet.packetId);
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void MqttBridge::handleConnAck(Connection& connection, const MqttPacket& packet)
+{
+    connection.connected = true;
+
+    // without the previous session every subscription is made again
+    if (!packet.sessionPresent) {
+        connection.pendingSubscriptions.insert(connection.subscribedTopicIds.begin(), connection.subscribedTopicIds.end());
+        connection.subscribedTopicIds.clear();
+        connection.receivedPacketIds.clear();
+    }
+
+    sendSubscriptionChanges(connection);
+
+    // publications of the previous connection go first, in their original order and with DUP
+    std::vector<std::pair<uint64_t, uint16_t>> order;
+    for (const auto& inflight : connection.inflight) {
+        order.emplace_back(inflight.second.sequence, inflight.first);
+    }
+
+    std::sort(order.begin(), order.end());
+    for (const auto& entry : order) {
+        sendPublication(connection, entry.second, connection.inflight[entry.second], true);
+    }
+
+    sendQueued(connection);
+}
+
+void MqttBridge::handleUpstreamPublish(Connection& connection, const MqttPacket& packet)
+{
+    stats.receivedPublications++;
+
+    // a repeated QoS 2 delivery is only acknowledged again
+    bool duplicate = packet.qos == 2 && !connection.receivedPacketIds.insert(packet.packetId).second;
+
+    if (!duplicate) {
+        uint16_t topicId = registry.findTopicId(packet.topic);
+
+        if (topicId > 0) {
+            QoS qos = packet.qos == 1 ? QoS::QOS_ONE : packet.qos == 2 ? QoS::QOS_TWO : QoS::QOS_ZERO;
+            core.publish(topicId, qos, packet.payload, packet.retain);
+        }
+        else {
+            stats.unknownTopicPublications++;
+        }
+    }
+
+    if (packet.qos > 0) {
+        MqttPacket ack;
+        ack.type = packet.qos == 1 ? MqttPacketType::MQTT_PUBACK : MqttPacketType::MQTT_PUBREC;
+        ack.packetId = packet.packetId;
+        send(connection, ack);
+    }
+}
+
+void MqttBridge::completePublication(Connection& connection, uint16_t packetId)
+{
+    if (connection.inflight.erase(packetId) > 0) {
+        stats.acknowledgedPublications++;
+        sendQueued(connection);
+    }
+}
+
+} /* namespace mqttsn */
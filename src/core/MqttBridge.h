@@ -0,0 +1,168 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_MQTTBRIDGE_H_
+#define CORE_MQTTBRIDGE_H_
+
+#include "BrokerCore.h"
+#include "MqttPacket.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace mqttsn {
+
+struct BridgeConfig {
+    std::string clientId = "mqttsn-bridge"; // upstream connection i connects as clientId-i
+    int connections = 1; // upstream connections the client sessions are multiplexed over
+    uint16_t keepAlive = 60; // seconds
+    int maxInflight = 32; // unacknowledged QoS 1/2 publications per upstream connection
+    size_t maxQueued = 10000; // publications waiting for a window before clients are refused with REJECTED_CONGESTION
+    double subscriptionBatchInterval = 0.05; // seconds during which subscription changes are collected into one packet
+    uint8_t subscriptionQoS = 1; // QoS requested for upstream subscriptions
+};
+
+struct BridgeStats {
+    uint64_t forwardedPublications = 0;
+    uint64_t acknowledgedPublications = 0;
+    uint64_t receivedPublications = 0;
+    uint64_t unknownTopicPublications = 0;
+    uint64_t subscribePackets = 0;
+    uint64_t unsubscribePackets = 0;
+    uint64_t rejectedSubscriptions = 0;
+    uint64_t malformedPackets = 0;
+    uint64_t reconnections = 0;
+};
+
+// Byte stream output of the bridge, one stream per upstream connection
+class UpstreamTransport
+{
+    public:
+        virtual ~UpstreamTransport() {};
+
+        virtual void write(int connection, const uint8_t* data, size_t length) = 0;
+};
+
+// Aggregating MQTT-SN to MQTT bridge. It relays the publications a broker core accepts from
+// its clients to an upstream MQTT 3.1.1 broker over a few shared connections, and hands what
+// the upstream broker delivers back to the core, which then only serves the MQTT-SN side
+// (localDelivery off). Each topic is bound to one connection by its ID, which keeps the
+// order per topic and never subscribes a topic twice.
+//
+// QoS 1/2 publications are pipelined up to maxInflight per connection and wait in a queue
+// beyond it; once maxQueued publications wait, the core refuses new ones. The first
+// subscriber of a topic and the last one leaving it are collected for
+// subscriptionBatchInterval and sent as one SUBSCRIBE and one UNSUBSCRIBE per connection.
+// Packets are buffered per connection and written by flush, once per event loop pass.
+// The connections are opened and closed by the owner, which reports it to the bridge.
+class MqttBridge : public BrokerRelay
+{
+    protected:
+        struct Publication {
+            std::string topic;
+            uint8_t qos;
+            bool retain;
+            std::string payload;
+
+            // a released QoS 2 publication got its PUBREC; the PUBREL is what gets sent again
+            bool released = false;
+            uint64_t sequence = 0;
+        };
+
+        struct Connection {
+            bool open = false;
+            bool connected = false;
+            double lastSent = 0;
+            uint16_t nextPacketId = 0;
+            uint64_t nextSequence = 0;
+
+            std::vector<uint8_t> input;
+            std::vector<uint8_t> output;
+
+            std::deque<Publication> queue;
+            std::unordered_map<uint16_t, Publication> inflight;
+
+            // QoS 2 deliveries received from upstream and waiting for their PUBREL
+            std::unordered_set<uint16_t> receivedPacketIds;
+
+            // SUBSCRIBE and UNSUBSCRIBE packets waiting for their acknowledgment
+            std::unordered_set<uint16_t> subscriptionPacketIds;
+
+            // topics subscribed upstream, and the changes not sent yet
+            std::unordered_set<uint16_t> subscribedTopicIds;
+            std::unordered_set<uint16_t> pendingSubscriptions;
+            std::unordered_set<uint16_t> pendingUnsubscriptions;
+        };
+
+        BrokerCore& core;
+        TopicRegistry& registry;
+        UpstreamTransport& transport;
+        const BrokerClock& clock;
+        BridgeConfig config;
+
+        std::vector<Connection> connections;
+        size_t queuedCount = 0;
+        double lastSubscriptionBatch = 0;
+
+        BridgeStats stats;
+
+    protected:
+        Connection& getConnection(uint16_t topicId) { return connections[topicId % connections.size()]; }
+        uint16_t nextPacketId(Connection& connection);
+
+        void send(Connection& connection, const MqttPacket& packet);
+        void sendPublication(Connection& connection, uint16_t packetId, Publication& publication, bool dup);
+        void sendQueued(Connection& connection);
+        void sendSubscriptionChanges(Connection& connection);
+
+        bool handlePacket(Connection& connection, const MqttPacket& packet);
+        void handleConnAck(Connection& connection, const MqttPacket& packet);
+        void handleUpstreamPublish(Connection& connection, const MqttPacket& packet);
+        void completePublication(Connection& connection, uint16_t packetId);
+
+    public:
+        MqttBridge(BrokerCore& core, UpstreamTransport& transport, const BrokerClock& clock, const BridgeConfig& config = BridgeConfig());
+
+        // the transport of a connection is up, so the bridge sends its CONNECT
+        void connectionOpened(int connection);
+
+        // the upstream session persists, so in-flight publications are sent again after the next CONNACK
+        void connectionClosed(int connection);
+
+        // false when the stream is malformed or the connection was refused; the owner then closes it
+        bool handleStream(int connection, const uint8_t* data, size_t length);
+
+        // sends the collected subscription changes and keep alive pings
+        void tick();
+
+        // writes what each connection buffered since the last flush
+        void flush();
+
+        // broker relay
+        virtual void relay(uint16_t topicId, QoS qos, const std::string& data, bool retain) override;
+        virtual void subscriptionChanged(uint16_t topicId, bool subscribed) override;
+        virtual bool isCongested() const override { return queuedCount >= config.maxQueued; }
+
+        bool isConnected(int connection) const { return connections[connection].connected; }
+        size_t getQueuedCount() const { return queuedCount; }
+        size_t getInflightCount() const;
+        const BridgeStats& getStats() const { return stats; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_MQTTBRIDGE_H_ */
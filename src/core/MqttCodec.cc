@@ -0,0 +1,249 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "MqttCodec.h"
+#include <algorithm>
+
+namespace mqttsn {
+
+void MqttCodec::writeUint16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back((uint8_t) (value >> 8));
+    buffer.push_back((uint8_t) value);
+}
+
+void MqttCodec::writeString(std::vector<uint8_t>& buffer, const std::string& value)
+{
+    writeUint16(buffer, (uint16_t) value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+MqttCodec::DecodeResult MqttCodec::decode(const uint8_t* data, size_t length, MqttPacket& packet, size_t& consumed)
+{
+    if (length < 2) {
+        return INCOMPLETE;
+    }
+
+    size_t remainingLength = 0;
+    size_t headerLength = 1;
+
+    for (int shift = 0;; shift += 7) {
+        if (headerLength >= length) {
+            return INCOMPLETE;
+        }
+
+        if (shift > 21) {
+            return MALFORMED;
+        }
+
+        uint8_t octet = data[headerLength++];
+        remainingLength |= (size_t) (octet & 0x7F) << shift;
+
+        if ((octet & 0x80) == 0) {
+            break;
+        }
+    }
+
+    if (length - headerLength < remainingLength) {
+        return INCOMPLETE;
+    }
+
+    uint8_t type = data[0] >> 4;
+    uint8_t flags = data[0] & 0x0F;
+    const uint8_t* body = data + headerLength;
+    size_t offset = 0;
+
+    auto readString = [&](std::string& field) {
+        if (remainingLength - offset < 2) {
+            return false;
+        }
+
+        size_t size = readUint16(body + offset);
+        if (remainingLength - offset - 2 < size) {
+            return false;
+        }
+
+        field.assign(reinterpret_cast<const char*>(body) + offset + 2, size);
+        offset += 2 + size;
+        return true;
+    };
+
+    packet = MqttPacket();
+    packet.type = (MqttPacketType) type;
+
+    switch (type) {
+        case MqttPacketType::MQTT_CONNECT: {
+            std::string protocolName;
+            if (!readString(protocolName) || protocolName != "MQTT" || remainingLength - offset < 4) return MALFORMED;
+
+            // protocol level, connect flags and keep alive; will and credentials are not supported
+            uint8_t connectFlags = body[offset + 1];
+            packet.cleanSession = (connectFlags >> 1) & 1;
+            packet.keepAlive = readUint16(body + offset + 2);
+            offset += 4;
+
+            if ((connectFlags & 0xFC) != 0 || !readString(packet.clientId)) return MALFORMED;
+            break;
+        }
+
+        case MqttPacketType::MQTT_CONNACK:
+            if (remainingLength != 2) return MALFORMED;
+            packet.sessionPresent = body[0] & 1;
+            packet.returnCode = body[1];
+            offset = 2;
+            break;
+
+        case MqttPacketType::MQTT_PUBLISH:
+            packet.dup = (flags >> 3) & 1;
+            packet.qos = (flags >> 1) & 0b11;
+            packet.retain = flags & 1;
+
+            if (packet.qos > 2 || !readString(packet.topic)) return MALFORMED;
+
+            if (packet.qos > 0) {
+                if (remainingLength - offset < 2) return MALFORMED;
+                packet.packetId = readUint16(body + offset);
+                offset += 2;
+            }
+
+            packet.payload.assign(reinterpret_cast<const char*>(body) + offset, remainingLength - offset);
+            offset = remainingLength;
+            break;
+
+        case MqttPacketType::MQTT_PUBACK:
+        case MqttPacketType::MQTT_PUBREC:
+        case MqttPacketType::MQTT_PUBREL:
+        case MqttPacketType::MQTT_PUBCOMP:
+        case MqttPacketType::MQTT_UNSUBACK:
+            if (remainingLength != 2) return MALFORMED;
+            packet.packetId = readUint16(body);
+            offset = 2;
+            break;
+
+        case MqttPacketType::MQTT_SUBSCRIBE:
+        case MqttPacketType::MQTT_UNSUBSCRIBE:
+            if (remainingLength < 2) return MALFORMED;
+            packet.packetId = readUint16(body);
+            offset = 2;
+
+            while (offset < remainingLength) {
+                packet.topicFilters.emplace_back();
+                if (!readString(packet.topicFilters.back())) return MALFORMED;
+
+                if (type == MqttPacketType::MQTT_SUBSCRIBE) {
+                    if (offset == remainingLength) return MALFORMED;
+                    packet.qosLevels.push_back(body[offset++]);
+                }
+            }
+
+            if (packet.topicFilters.empty()) return MALFORMED;
+            break;
+
+        case MqttPacketType::MQTT_SUBACK:
+            if (remainingLength < 3) return MALFORMED;
+            packet.packetId = readUint16(body);
+            packet.qosLevels.assign(body + 2, body + remainingLength);
+            offset = remainingLength;
+            break;
+
+        case MqttPacketType::MQTT_PINGREQ:
+        case MqttPacketType::MQTT_PINGRESP:
+        case MqttPacketType::MQTT_DISCONNECT:
+            break;
+
+        default:
+            return MALFORMED;
+    }
+
+    if (offset != remainingLength) {
+        return MALFORMED;
+    }
+
+    consumed = headerLength + remainingLength;
+    return COMPLETE;
+}
+
+void MqttCodec::append(const MqttPacket& packet, std::vector<uint8_t>& buffer)
+{
+    std::vector<uint8_t> body;
+    uint8_t flags = 0;
+
+    switch (packet.type) {
+        case MqttPacketType::MQTT_CONNECT:
+            writeString(body, "MQTT");
+            body.push_back(4);
+            body.push_back(packet.cleanSession ? 0x02 : 0x00);
+            writeUint16(body, packet.keepAlive);
+            writeString(body, packet.clientId);
+            break;
+
+        case MqttPacketType::MQTT_CONNACK:
+            body.push_back(packet.sessionPresent ? 1 : 0);
+            body.push_back(packet.returnCode);
+            break;
+
+        case MqttPacketType::MQTT_PUBLISH:
+            flags = (packet.dup << 3) | (packet.qos << 1) | packet.retain;
+            writeString(body, packet.topic);
+            if (packet.qos > 0) {
+                writeUint16(body, packet.packetId);
+            }
+            body.insert(body.end(), packet.payload.begin(), packet.payload.end());
+            break;
+
+        case MqttPacketType::MQTT_PUBREL:
+        case MqttPacketType::MQTT_SUBSCRIBE:
+        case MqttPacketType::MQTT_UNSUBSCRIBE:
+            // these types carry the reserved flags 0b0010
+            flags = 0b0010;
+            writeUint16(body, packet.packetId);
+
+            for (size_t i = 0; i < packet.topicFilters.size(); i++) {
+                writeString(body, packet.topicFilters[i]);
+                if (packet.type == MqttPacketType::MQTT_SUBSCRIBE) {
+                    body.push_back(i < packet.qosLevels.size() ? packet.qosLevels[i] : 0);
+                }
+            }
+            break;
+
+        case MqttPacketType::MQTT_PUBACK:
+        case MqttPacketType::MQTT_PUBREC:
+        case MqttPacketType::MQTT_PUBCOMP:
+        case MqttPacketType::MQTT_UNSUBACK:
+            writeUint16(body, packet.packetId);
+            break;
+
+        case MqttPacketType::MQTT_SUBACK:
+            writeUint16(body, packet.packetId);
+            body.insert(body.end(), packet.qosLevels.begin(), packet.qosLevels.end());
+            break;
+
+        default:
+            break;
+    }
+
+    buffer.push_back((uint8_t) ((packet.type << 4) | flags));
+
+    size_t remainingLength = std::min(body.size(), MAX_REMAINING_LENGTH);
+    do {
+        uint8_t octet = remainingLength & 0x7F;
+        remainingLength >>= 7;
+        buffer.push_back(remainingLength > 0 ? octet | 0x80 : octet);
+    } while (remainingLength > 0);
+
+    buffer.insert(buffer.end(), body.begin(), body.end());
+}
+
+} /* namespace mqttsn */
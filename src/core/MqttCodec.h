@@ -0,0 +1,52 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_MQTTCODEC_H_
+#define CORE_MQTTCODEC_H_
+
+#include "MqttPacket.h"
+#include <cstddef>
+
+namespace mqttsn {
+
+// Encoder and decoder of the MQTT 3.1.1 wire format over a byte stream. A fixed header
+// octet is followed by the remaining length in one to four 7-bit groups.
+class MqttCodec
+{
+    public:
+        enum DecodeResult {
+            COMPLETE,
+            INCOMPLETE,
+            MALFORMED
+        };
+
+    protected:
+        static constexpr size_t MAX_REMAINING_LENGTH = 268435455;
+
+        static uint16_t readUint16(const uint8_t* data) { return (uint16_t) ((data[0] << 8) | data[1]); }
+        static void writeUint16(std::vector<uint8_t>& buffer, uint16_t value);
+        static void writeString(std::vector<uint8_t>& buffer, const std::string& value);
+
+    public:
+        // decodes the first packet of the stream; consumed is only set when it is complete
+        static DecodeResult decode(const uint8_t* data, size_t length, MqttPacket& packet, size_t& consumed);
+
+        // appends the encoded packet, so that several packets go out in one write
+        static void append(const MqttPacket& packet, std::vector<uint8_t>& buffer);
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_MQTTCODEC_H_ */
@@ -0,0 +1,74 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_MQTTPACKET_H_
+#define CORE_MQTTPACKET_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// MQTT 3.1.1 control packet types
+enum MqttPacketType : uint8_t {
+    MQTT_CONNECT = 1,
+    MQTT_CONNACK = 2,
+    MQTT_PUBLISH = 3,
+    MQTT_PUBACK = 4,
+    MQTT_PUBREC = 5,
+    MQTT_PUBREL = 6,
+    MQTT_PUBCOMP = 7,
+    MQTT_SUBSCRIBE = 8,
+    MQTT_SUBACK = 9,
+    MQTT_UNSUBSCRIBE = 10,
+    MQTT_UNSUBACK = 11,
+    MQTT_PINGREQ = 12,
+    MQTT_PINGRESP = 13,
+    MQTT_DISCONNECT = 14
+};
+
+// Decoded MQTT packet of the bridge; like CorePacket, one flat structure covers every type
+struct MqttPacket {
+    MqttPacketType type = MqttPacketType::MQTT_PINGREQ;
+
+    // PUBLISH header flags
+    uint8_t qos = 0;
+    bool dup = false;
+    bool retain = false;
+
+    uint16_t packetId = 0;
+
+    // CONNECT
+    std::string clientId;
+    uint16_t keepAlive = 0;
+    bool cleanSession = true;
+
+    // CONNACK
+    bool sessionPresent = false;
+    uint8_t returnCode = 0;
+
+    // PUBLISH
+    std::string topic;
+    std::string payload;
+
+    // filters of SUBSCRIBE and UNSUBSCRIBE; requested QoS of SUBSCRIBE or return codes of SUBACK
+    std::vector<std::string> topicFilters;
+    std::vector<uint8_t> qosLevels;
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_MQTTPACKET_H_ */
@@ -0,0 +1,132 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "SharedTopicRegistry.h"
+
+namespace mqttsn {
+
+SharedTopicRegistry::SharedTopicRegistry(uint16_t maximumTopics) :
+        maximumTopics(maximumTopics),
+        topicNames(new std::atomic<const std::string*>[TOPIC_CAPACITY]),
+        slots(new std::atomic<uint16_t>[SLOT_CAPACITY]),
+        predefinedTopics(TOPIC_CAPACITY, false)
+{
+    for (size_t i = 0; i < TOPIC_CAPACITY; i++) {
+        topicNames[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    for (size_t i = 0; i < SLOT_CAPACITY; i++) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+SharedTopicRegistry::~SharedTopicRegistry()
+{
+    for (size_t i = 0; i < TOPIC_CAPACITY; i++) {
+        delete topicNames[i].load(std::memory_order_relaxed);
+    }
+}
+
+size_t SharedTopicRegistry::hashName(const std::string& topicName)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : topicName) {
+        hash = (hash ^ (uint8_t) c) * 1099511628211ULL;
+    }
+
+    return (size_t) hash;
+}
+
+uint16_t SharedTopicRegistry::findTopicId(const std::string& topicName) const
+{
+    for (size_t index = hashName(topicName) & (SLOT_CAPACITY - 1);; index = (index + 1) & (SLOT_CAPACITY - 1)) {
+        uint16_t topicId = slots[index].load(std::memory_order_acquire);
+
+        if (topicId == 0) {
+            return 0;
+        }
+
+        if (*topicNames[topicId].load(std::memory_order_acquire) == topicName) {
+            return topicId;
+        }
+    }
+}
+
+void SharedTopicRegistry::insert(const std::string& topicName, uint16_t topicId)
+{
+    topicNames[topicId].store(new std::string(topicName), std::memory_order_release);
+
+    // at most half of the slots are ever used, so the probe always ends
+    size_t index = hashName(topicName) & (SLOT_CAPACITY - 1);
+    while (slots[index].load(std::memory_order_relaxed) != 0) {
+        index = (index + 1) & (SLOT_CAPACITY - 1);
+    }
+
+    slots[index].store(topicId, std::memory_order_release);
+    topicCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint16_t SharedTopicRegistry::getOrCreateTopicId(const std::string& topicName)
+{
+    if (topicName.empty()) {
+        return 0;
+    }
+
+    // the lock free lookup serves every topic but the first registration
+    uint16_t topicId = findTopicId(topicName);
+    if (topicId > 0) {
+        return topicId;
+    }
+
+    std::lock_guard<std::mutex> lock(writerMutex);
+
+    // another writer may have registered it in the meantime
+    topicId = findTopicId(topicName);
+    if (topicId > 0 || topicCount.load(std::memory_order_relaxed) >= maximumTopics) {
+        return topicId;
+    }
+
+    while (nextTopicId < TOPIC_CAPACITY - 1 && topicNames[nextTopicId].load(std::memory_order_relaxed) != nullptr) {
+        nextTopicId++;
+    }
+
+    if (nextTopicId >= TOPIC_CAPACITY - 1) {
+        return 0;
+    }
+
+    insert(topicName, nextTopicId);
+
+    return nextTopicId;
+}
+
+const std::string* SharedTopicRegistry::getTopicName(uint16_t topicId) const
+{
+    return topicNames[topicId].load(std::memory_order_acquire);
+}
+
+void SharedTopicRegistry::addPredefinedTopic(const std::string& topicName, uint16_t topicId)
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+
+    if (topicName.empty() || topicId == 0 || topicId == UINT16_MAX || getTopicName(topicId) != nullptr || findTopicId(topicName) > 0) {
+        return;
+    }
+
+    insert(topicName, topicId);
+    predefinedTopics[topicId] = true;
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,68 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_SHAREDTOPICREGISTRY_H_
+#define CORE_SHAREDTOPICREGISTRY_H_
+
+#include "TopicRegistry.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace mqttsn {
+
+// Topic registry shared by the broker shards of one process. Writers are serialized by
+// a mutex; readers never lock. A new topic is published by storing its name before the
+// hash slot that points to it, both with release semantics, so a reader that finds the
+// slot also sees the name. Topics are never removed, hence no name is ever reclaimed
+// while a reader may still hold it. Predefined topics must be added before the readers start.
+class SharedTopicRegistry : public TopicRegistry
+{
+    protected:
+        static constexpr size_t TOPIC_CAPACITY = size_t(1) << 16;
+        static constexpr size_t SLOT_CAPACITY = TOPIC_CAPACITY * 2;
+
+        uint16_t maximumTopics;
+
+        // topic names indexed by ID and open addressing slots holding IDs, 0 meaning empty
+        std::unique_ptr<std::atomic<const std::string*>[]> topicNames;
+        std::unique_ptr<std::atomic<uint16_t>[]> slots;
+        std::vector<bool> predefinedTopics;
+
+        std::mutex writerMutex;
+        std::atomic<size_t> topicCount{0};
+        uint16_t nextTopicId = 1;
+
+    protected:
+        static size_t hashName(const std::string& topicName);
+        void insert(const std::string& topicName, uint16_t topicId);
+
+    public:
+        SharedTopicRegistry(uint16_t maximumTopics = UINT16_MAX - 1);
+        ~SharedTopicRegistry();
+
+        virtual uint16_t findTopicId(const std::string& topicName) const override;
+        virtual uint16_t getOrCreateTopicId(const std::string& topicName) override;
+        virtual const std::string* getTopicName(uint16_t topicId) const override;
+
+        virtual bool isPredefined(uint16_t topicId) const override { return predefinedTopics[topicId]; }
+        virtual void addPredefinedTopic(const std::string& topicName, uint16_t topicId) override;
+
+        virtual size_t size() const override { return topicCount.load(std::memory_order_relaxed); }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_SHAREDTOPICREGISTRY_H_ */
@@ -0,0 +1,80 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "TopicRegistry.h"
+
+namespace mqttsn {
+
+uint16_t LocalTopicRegistry::findTopicId(const std::string& topicName) const
+{
+    auto it = topicIds.find(topicName);
+    return it != topicIds.end() ? it->second : 0;
+}
+
+uint16_t LocalTopicRegistry::getOrCreateTopicId(const std::string& topicName)
+{
+    if (topicName.empty()) {
+        return 0;
+    }
+
+    uint16_t topicId = findTopicId(topicName);
+    if (topicId > 0 || topicIds.size() >= maximumTopics) {
+        return topicId;
+    }
+
+    // topics are never removed, so the only gaps are left below predefined topics
+    while (nextTopicId < topicNames.size() && !topicNames[nextTopicId].empty()) {
+        nextTopicId++;
+    }
+
+    topicId = nextTopicId;
+    if (topicId == topicNames.size()) {
+        topicNames.emplace_back();
+        predefinedTopics.push_back(false);
+    }
+
+    topicNames[topicId] = topicName;
+    topicIds[topicName] = topicId;
+
+    return topicId;
+}
+
+const std::string* LocalTopicRegistry::getTopicName(uint16_t topicId) const
+{
+    return topicId < topicNames.size() && !topicNames[topicId].empty() ? &topicNames[topicId] : nullptr;
+}
+
+bool LocalTopicRegistry::isPredefined(uint16_t topicId) const
+{
+    return topicId < predefinedTopics.size() && predefinedTopics[topicId];
+}
+
+void LocalTopicRegistry::addPredefinedTopic(const std::string& topicName, uint16_t topicId)
+{
+    if (topicName.empty() || topicId == 0 || topicId == UINT16_MAX || getTopicName(topicId) != nullptr || findTopicId(topicName) > 0) {
+        return;
+    }
+
+    if (topicNames.size() <= topicId) {
+        topicNames.resize(topicId + 1);
+        predefinedTopics.resize(topicId + 1, false);
+    }
+
+    topicNames[topicId] = topicName;
+    topicIds[topicName] = topicId;
+    predefinedTopics[topicId] = true;
+}
+
+} /* namespace mqttsn */
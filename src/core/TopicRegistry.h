@@ -0,0 +1,74 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_TOPICREGISTRY_H_
+#define CORE_TOPICREGISTRY_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mqttsn {
+
+// Mapping between topic names and topic IDs. IDs start at 1 and topics are never removed,
+// so an ID keeps naming the same topic for the lifetime of the registry.
+class TopicRegistry
+{
+    public:
+        virtual ~TopicRegistry() {};
+
+        // 0 when the topic is unknown
+        virtual uint16_t findTopicId(const std::string& topicName) const = 0;
+
+        // 0 when the registry is full
+        virtual uint16_t getOrCreateTopicId(const std::string& topicName) = 0;
+
+        // nullptr when the ID is not assigned
+        virtual const std::string* getTopicName(uint16_t topicId) const = 0;
+
+        virtual bool isPredefined(uint16_t topicId) const = 0;
+        virtual void addPredefinedTopic(const std::string& topicName, uint16_t topicId) = 0;
+
+        virtual size_t size() const = 0;
+};
+
+// Registry owned by a single broker
+class LocalTopicRegistry : public TopicRegistry
+{
+    protected:
+        uint16_t maximumTopics;
+
+        std::unordered_map<std::string, uint16_t> topicIds;
+        std::vector<std::string> topicNames;
+        std::vector<bool> predefinedTopics;
+        uint16_t nextTopicId = 1;
+
+    public:
+        LocalTopicRegistry(uint16_t maximumTopics = UINT16_MAX - 1) : maximumTopics(maximumTopics), topicNames(1), predefinedTopics(1) {};
+
+        virtual uint16_t findTopicId(const std::string& topicName) const override;
+        virtual uint16_t getOrCreateTopicId(const std::string& topicName) override;
+        virtual const std::string* getTopicName(uint16_t topicId) const override;
+
+        virtual bool isPredefined(uint16_t topicId) const override;
+        virtual void addPredefinedTopic(const std::string& topicName, uint16_t topicId) override;
+
+        virtual size_t size() const override { return topicIds.size(); }
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_TOPICREGISTRY_H_ */
@@ -0,0 +1,273 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "WireCodec.h"
+
+namespace mqttsn {
+
+void WireCodec::writeUint16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back((uint8_t) (value >> 8));
+    buffer.push_back((uint8_t) value);
+}
+
+bool WireCodec::decode(const uint8_t* data, size_t length, CorePacket& packet)
+{
+    if (length < 2) {
+        return false;
+    }
+
+    // the length field covers the whole packet, itself included
+    size_t headerLength = 2;
+    size_t packetLength = data[0];
+
+    if (packetLength == 0x01) {
+        if (length < 4) {
+            return false;
+        }
+
+        headerLength = 4;
+        packetLength = readUint16(data + 1);
+    }
+
+    if (packetLength != length || packetLength < headerLength) {
+        return false;
+    }
+
+    packet.msgType = (MsgType) data[headerLength - 1];
+
+    const uint8_t* body = data + headerLength;
+    size_t bodyLength = packetLength - headerLength;
+
+    auto readText = [&](size_t offset, std::string& field) {
+        field.assign(reinterpret_cast<const char*>(body) + offset, bodyLength - offset);
+    };
+
+    switch (packet.msgType) {
+        case MsgType::ADVERTISE:
+            if (bodyLength != 3) return false;
+            packet.gatewayId = body[0];
+            packet.duration = readUint16(body + 1);
+            return true;
+
+        case MsgType::SEARCHGW:
+            // the radius is not used by the broker
+            return bodyLength == 1;
+
+        case MsgType::GWINFO:
+            if (bodyLength < 1) return false;
+            packet.gatewayId = body[0];
+            readText(1, packet.text);
+            return true;
+
+        case MsgType::CONNECT:
+            if (bodyLength < 4) return false;
+            packet.flags = body[0];
+            packet.duration = readUint16(body + 2);
+            readText(4, packet.text);
+            return true;
+
+        case MsgType::CONNACK:
+            if (bodyLength != 1) return false;
+            packet.returnCode = (ReturnCode) body[0];
+            return true;
+
+        case MsgType::REGISTER:
+            if (bodyLength < 4) return false;
+            packet.topicId = readUint16(body);
+            packet.msgId = readUint16(body + 2);
+            readText(4, packet.text);
+            return true;
+
+        case MsgType::REGACK:
+        case MsgType::PUBACK:
+            if (bodyLength != 5) return false;
+            packet.topicId = readUint16(body);
+            packet.msgId = readUint16(body + 2);
+            packet.returnCode = (ReturnCode) body[4];
+            return true;
+
+        case MsgType::PUBLISH:
+            if (bodyLength < 5) return false;
+            packet.flags = body[0];
+            packet.topicId = readUint16(body + 1);
+            packet.msgId = readUint16(body + 3);
+            packet.data.assign(reinterpret_cast<const char*>(body) + 5, bodyLength - 5);
+            return true;
+
+        case MsgType::PUBCOMP:
+        case MsgType::PUBREC:
+        case MsgType::PUBREL:
+        case MsgType::UNSUBACK:
+            if (bodyLength != 2) return false;
+            packet.msgId = readUint16(body);
+            return true;
+
+        case MsgType::SUBSCRIBE:
+        case MsgType::UNSUBSCRIBE:
+            if (bodyLength < 3) return false;
+            packet.flags = body[0];
+            packet.msgId = readUint16(body + 1);
+
+            // predefined topics are sent as an ID, normal and short ones as a name
+            if (packet.getTopicIdType() == TopicIdType::PRE_DEFINED_TOPIC_ID) {
+                if (bodyLength != 5) return false;
+                packet.topicId = readUint16(body + 3);
+            }
+            else {
+                readText(3, packet.text);
+            }
+            return true;
+
+        case MsgType::SUBACK:
+            if (bodyLength != 6) return false;
+            packet.flags = body[0];
+            packet.topicId = readUint16(body + 1);
+            packet.msgId = readUint16(body + 3);
+            packet.returnCode = (ReturnCode) body[5];
+            return true;
+
+        case MsgType::PINGREQ:
+            readText(0, packet.text);
+            return true;
+
+        case MsgType::PINGRESP:
+        case MsgType::WILLTOPICREQ:
+        case MsgType::WILLMSGREQ:
+            return bodyLength == 0;
+
+        case MsgType::DISCONNECT:
+            if (bodyLength != 0 && bodyLength != 2) return false;
+            packet.duration = bodyLength == 2 ? readUint16(body) : 0;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void WireCodec::encode(const CorePacket& packet, std::vector<uint8_t>& buffer)
+{
+    // the length is patched in once the body is known; three octets are reserved up front
+    buffer.assign(3, 0);
+    buffer.push_back(packet.msgType);
+
+    auto writeText = [&](const std::string& field) {
+        buffer.insert(buffer.end(), field.begin(), field.end());
+    };
+
+    switch (packet.msgType) {
+        case MsgType::ADVERTISE:
+            buffer.push_back(packet.gatewayId);
+            writeUint16(buffer, packet.duration);
+            break;
+
+        case MsgType::SEARCHGW:
+            buffer.push_back(1);
+            break;
+
+        case MsgType::GWINFO:
+            buffer.push_back(packet.gatewayId);
+            writeText(packet.text);
+            break;
+
+        case MsgType::CONNECT:
+            buffer.push_back(packet.flags);
+            buffer.push_back(0x01);
+            writeUint16(buffer, packet.duration);
+            writeText(packet.text);
+            break;
+
+        case MsgType::CONNACK:
+            buffer.push_back(packet.returnCode);
+            break;
+
+        case MsgType::REGISTER:
+            writeUint16(buffer, packet.topicId);
+            writeUint16(buffer, packet.msgId);
+            writeText(packet.text);
+            break;
+
+        case MsgType::REGACK:
+        case MsgType::PUBACK:
+            writeUint16(buffer, packet.topicId);
+            writeUint16(buffer, packet.msgId);
+            buffer.push_back(packet.returnCode);
+            break;
+
+        case MsgType::PUBLISH:
+            buffer.push_back(packet.flags);
+            writeUint16(buffer, packet.topicId);
+            writeUint16(buffer, packet.msgId);
+            writeText(packet.data);
+            break;
+
+        case MsgType::PUBCOMP:
+        case MsgType::PUBREC:
+        case MsgType::PUBREL:
+        case MsgType::UNSUBACK:
+            writeUint16(buffer, packet.msgId);
+            break;
+
+        case MsgType::SUBSCRIBE:
+        case MsgType::UNSUBSCRIBE:
+            buffer.push_back(packet.flags);
+            writeUint16(buffer, packet.msgId);
+
+            if (packet.getTopicIdType() == TopicIdType::PRE_DEFINED_TOPIC_ID) {
+                writeUint16(buffer, packet.topicId);
+            }
+            else {
+                writeText(packet.text);
+            }
+            break;
+
+        case MsgType::SUBACK:
+            buffer.push_back(packet.flags);
+            writeUint16(buffer, packet.topicId);
+            writeUint16(buffer, packet.msgId);
+            buffer.push_back(packet.returnCode);
+            break;
+
+        case MsgType::PINGREQ:
+            writeText(packet.text);
+            break;
+
+        case MsgType::DISCONNECT:
+            if (packet.duration > 0) {
+                writeUint16(buffer, packet.duration);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    size_t length = buffer.size() - 2;
+
+    if (length < 256) {
+        // short form: drop the two spare octets
+        buffer.erase(buffer.begin(), buffer.begin() + 2);
+        buffer[0] = (uint8_t) length;
+    }
+    else {
+        length = buffer.size();
+        buffer[0] = 0x01;
+        buffer[1] = (uint8_t) (length >> 8);
+        buffer[2] = (uint8_t) length;
+    }
+}
+
+} /* namespace mqttsn */
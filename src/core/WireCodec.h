@@ -0,0 +1,43 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef CORE_WIRECODEC_H_
+#define CORE_WIRECODEC_H_
+
+#include "CorePacket.h"
+#include <cstddef>
+#include <vector>
+
+namespace mqttsn {
+
+// Encoder and decoder of the MQTT-SN v1.2 wire format. The length field takes one
+// octet, or three octets (0x01 followed by a big-endian uint16_t) from 256 bytes on.
+class WireCodec
+{
+    protected:
+        static uint16_t readUint16(const uint8_t* data) { return (uint16_t) ((data[0] << 8) | data[1]); }
+        static void writeUint16(std::vector<uint8_t>& buffer, uint16_t value);
+
+    public:
+        // returns false for truncated, oversized or unknown packets
+        static bool decode(const uint8_t* data, size_t length, CorePacket& packet);
+
+        // replaces the content of the buffer with the encoded packet
+        static void encode(const CorePacket& packet, std::vector<uint8_t>& buffer);
+};
+
+} /* namespace mqttsn */
+
+#endif /* CORE_WIRECODEC_H_ */
@@ -0,0 +1,43 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef ERRORMODELS_BASEERRORMODEL_H_
+#define ERRORMODELS_BASEERRORMODEL_H_
+
+#include <omnetpp.h>
+#include "inet/common/Units.h"
+#include "inet/networklayer/common/L3Address.h"
+
+namespace mqttsn {
+
+class BaseErrorModel
+{
+    protected:
+        omnetpp::cRNG* rng;
+
+    protected:
+        virtual double nextUniform();
+
+    public:
+        BaseErrorModel(omnetpp::cRNG* rng) : rng(rng) {};
+        virtual ~BaseErrorModel() {};
+
+        // decide whether a packet of the given length sent to the given destination is corrupted
+        virtual bool hasError(inet::B length, const inet::L3Address& destAddress) = 0;
+};
+
+} /* namespace mqttsn */
+
+#endif /* ERRORMODELS_BASEERRORMODEL_H_ */
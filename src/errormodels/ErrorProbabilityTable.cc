@@ -0,0 +1,47 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ErrorProbabilityTable.h"
+#include <cmath>
+
+namespace mqttsn {
+
+ErrorProbabilityTable::ErrorProbabilityTable(double ber)
+{
+    this->ber = ber;
+}
+
+double ErrorProbabilityTable::getProbability(uint32_t lengthInBytes)
+{
+    if (ber <= 0) {
+        return 0;
+    }
+
+    // grow the table on demand; negative entries are not computed yet
+    if (lengthInBytes >= probabilities.size()) {
+        probabilities.resize(lengthInBytes + 1, -1);
+    }
+
+    double& probability = probabilities[lengthInBytes];
+
+    if (probability < 0) {
+        // calculate error probability using BER and packet length in bits
+        probability = 1 - std::pow(1 - ber, lengthInBytes * 8.0);
+    }
+
+    return probability;
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,41 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef ERRORMODELS_ERRORPROBABILITYTABLE_H_
+#define ERRORMODELS_ERRORPROBABILITYTABLE_H_
+
+#include <vector>
+#include <cstdint>
+
+namespace mqttsn {
+
+class ErrorProbabilityTable
+{
+    protected:
+        double ber;
+
+        // cached error probabilities indexed by packet length in bytes
+        std::vector<double> probabilities;
+
+    public:
+        ErrorProbabilityTable(double ber = 0);
+
+        double getBER() const { return ber; }
+        double getProbability(uint32_t lengthInBytes);
+};
+
+} /* namespace mqttsn */
+
+#endif /* ERRORMODELS_ERRORPROBABILITYTABLE_H_ */
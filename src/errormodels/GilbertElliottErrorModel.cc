@@ -0,0 +1,47 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "GilbertElliottErrorModel.h"
+
+namespace mqttsn {
+
+GilbertElliottErrorModel::GilbertElliottErrorModel(omnetpp::cRNG* rng, double goodBER, double badBER, double goodToBadProbability,
+                                                   double badToGoodProbability) : BaseErrorModel(rng), goodTable(goodBER), badTable(badBER)
+{
+    if (goodToBadProbability < 0 || goodToBadProbability > 1 || badToGoodProbability < 0 || badToGoodProbability > 1) {
+        throw omnetpp::cRuntimeError("Gilbert-Elliott transition probabilities must be within [0, 1]");
+    }
+
+    this->goodToBadProbability = goodToBadProbability;
+    this->badToGoodProbability = badToGoodProbability;
+}
+
+bool GilbertElliottErrorModel::hasError(inet::B length, const inet::L3Address& destAddress)
+{
+    // every link starts in the good state
+    bool& bad = linkStates[destAddress];
+
+    // advance the two-state Markov chain once per packet
+    double transitionProbability = bad ? badToGoodProbability : goodToBadProbability;
+
+    if (nextUniform() < transitionProbability) {
+        bad = !bad;
+    }
+
+    ErrorProbabilityTable& table = bad ? badTable : goodTable;
+    return nextUniform() < table.getProbability(length.get());
+}
+
+} /* namespace mqttsn */
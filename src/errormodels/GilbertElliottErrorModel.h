@@ -0,0 +1,46 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef ERRORMODELS_GILBERTELLIOTTERRORMODEL_H_
+#define ERRORMODELS_GILBERTELLIOTTERRORMODEL_H_
+
+#include "BaseErrorModel.h"
+#include "ErrorProbabilityTable.h"
+
+namespace mqttsn {
+
+class GilbertElliottErrorModel : public BaseErrorModel
+{
+    protected:
+        ErrorProbabilityTable goodTable;
+        ErrorProbabilityTable badTable;
+
+        // per packet state transition probabilities
+        double goodToBadProbability;
+        double badToGoodProbability;
+
+        // channel state of each link, true when in the bad state
+        std::map<inet::L3Address, bool> linkStates;
+
+    public:
+        GilbertElliottErrorModel(omnetpp::cRNG* rng, double goodBER, double badBER, double goodToBadProbability,
+                                 double badToGoodProbability);
+
+        virtual bool hasError(inet::B length, const inet::L3Address& destAddress) override;
+};
+
+} /* namespace mqttsn */
+
+#endif /* ERRORMODELS_GILBERTELLIOTTERRORMODEL_H_ */
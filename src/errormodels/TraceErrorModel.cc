@@ -0,0 +1,97 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "TraceErrorModel.h"
+#include <fstream>
+#include <sstream>
+
+namespace mqttsn {
+
+TraceErrorModel::TraceErrorModel(omnetpp::cRNG* rng, const std::string& traceFile) : BaseErrorModel(rng)
+{
+    loadTraceFile(traceFile);
+}
+
+void TraceErrorModel::loadTraceFile(const std::string& traceFile)
+{
+    std::ifstream file(traceFile);
+
+    if (!file.is_open()) {
+        throw omnetpp::cRuntimeError("Unable to open loss trace file: %s", traceFile.c_str());
+    }
+
+    // each line holds a destination address (or * for any other) followed by a pattern of 0 and 1 characters
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        std::istringstream stream(line);
+        std::string destination;
+        std::string pattern;
+
+        if (!(stream >> destination) || destination[0] == '#') {
+            continue;
+        }
+
+        if (!(stream >> pattern)) {
+            throw omnetpp::cRuntimeError("Missing loss pattern in %s at line %d", traceFile.c_str(), lineNumber);
+        }
+
+        LossTrace trace;
+
+        for (char c : pattern) {
+            if (c != '0' && c != '1') {
+                throw omnetpp::cRuntimeError("Invalid loss pattern character '%c' in %s at line %d", c, traceFile.c_str(), lineNumber);
+            }
+
+            trace.losses.push_back(c == '1');
+        }
+
+        if (destination == "*") {
+            defaultTrace = trace;
+        }
+        else {
+            linkTraces[inet::L3Address(destination.c_str())] = trace;
+        }
+    }
+}
+
+bool TraceErrorModel::nextLoss(LossTrace& trace)
+{
+    if (trace.losses.empty()) {
+        return false;
+    }
+
+    // the trace is replayed cyclically
+    bool loss = trace.losses[trace.position];
+    trace.position = (trace.position + 1) % trace.losses.size();
+
+    return loss;
+}
+
+bool TraceErrorModel::hasError(inet::B length, const inet::L3Address& destAddress)
+{
+    auto it = linkTraces.find(destAddress);
+
+    if (it != linkTraces.end()) {
+        return nextLoss(it->second);
+    }
+
+    return nextLoss(defaultTrace);
+}
+
+} /* namespace mqttsn */
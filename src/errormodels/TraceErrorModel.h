@@ -0,0 +1,49 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef ERRORMODELS_TRACEERRORMODEL_H_
+#define ERRORMODELS_TRACEERRORMODEL_H_
+
+#include "BaseErrorModel.h"
+
+namespace mqttsn {
+
+class TraceErrorModel : public BaseErrorModel
+{
+    protected:
+        struct LossTrace {
+            std::vector<bool> losses;
+            size_t position = 0;
+        };
+
+        // loss traces by destination address
+        std::map<inet::L3Address, LossTrace> linkTraces;
+
+        // trace applied to destinations without an own entry
+        LossTrace defaultTrace;
+
+    protected:
+        virtual void loadTraceFile(const std::string& traceFile);
+        virtual bool nextLoss(LossTrace& trace);
+
+    public:
+        TraceErrorModel(omnetpp::cRNG* rng, const std::string& traceFile);
+
+        virtual bool hasError(inet::B length, const inet::L3Address& destAddress) override;
+};
+
+} /* namespace mqttsn */
+
+#endif /* ERRORMODELS_TRACEERRORMODEL_H_ */
@@ -0,0 +1,30 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "UniformErrorModel.h"
+
+namespace mqttsn {
+
+UniformErrorModel::UniformErrorModel(omnetpp::cRNG* rng, double ber) : BaseErrorModel(rng), table(ber)
+{
+}
+
+bool UniformErrorModel::hasError(inet::B length, const inet::L3Address& destAddress)
+{
+    // the random number is always drawn to keep the module RNG stream unchanged
+    return nextUniform() < table.getProbability(length.get());
+}
+
+} /* namespace mqttsn */
@@ -93,4 +93,34 @@ std::string ConversionHelper::topicIdTypeToString(TopicIdType idType)
     }
 }
 
+std::string ConversionHelper::stageToString(Stage stage)
+{
+    // convert a stage enumeration to its corresponding string identifier
+    switch (stage) {
+        case Stage::PUBLISHER_CREATED:
+            return "publisherCreated";
+
+        case Stage::PUBLISHER_SENT:
+            return "publisherSent";
+
+        case Stage::GATEWAY_RECEIVED:
+            return "gatewayReceived";
+
+        case Stage::GATEWAY_BUFFERED:
+            return "gatewayBuffered";
+
+        case Stage::GATEWAY_DISPATCHED:
+            return "gatewayDispatched";
+
+        case Stage::SUBSCRIBER_RECEIVED:
+            return "subscriberReceived";
+
+        case Stage::SUBSCRIBER_DELIVERED:
+            return "subscriberDelivered";
+
+        default:
+            throw omnetpp::cRuntimeError("Invalid stage");
+    }
+}
+
 } /* namespace mqttsn */
@@ -19,6 +19,7 @@
 #include "BaseHelper.h"
 #include "types/shared/QoS.h"
 #include "types/shared/TopicIdType.h"
+#include "types/shared/Stage.h"
 
 namespace mqttsn {
 
@@ -29,6 +30,7 @@ class ConversionHelper : public BaseHelper
         static int qosToInt(QoS value);
         static TopicIdType stringToTopicIdType(const std::string& idType);
         static std::string topicIdTypeToString(TopicIdType idType);
+        static std::string stageToString(Stage stage);
 };
 
 } /* namespace mqttsn */
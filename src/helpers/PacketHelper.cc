@@ -16,6 +16,7 @@
 #include "PacketHelper.h"
 #include "inet/common/TimeTag_m.h"
 #include "tags/IdentifierTag.h"
+#include "tags/StageTimestampTag.h"
 #include "messages/MqttSNRegister.h"
 #include "messages/MqttSNPublish.h"
 #include "messages/MqttSNBaseWithMsgId.h"
@@ -58,6 +59,7 @@ inet::Packet* PacketHelper::getPublishPacket(bool dupFlag, QoS qosFlag, bool ret
 
     if (tagInfo.identifier > 0) {
         payload->addTag<IdentifierTag>()->setIdentifier(tagInfo.identifier);
+        payload->addTag<StageTimestampTag>()->setTimestamps(tagInfo.stageTimestamps);
     }
 
     inet::Packet* packet = new inet::Packet("PublishPacket");
@@ -132,4 +134,26 @@ inet::Packet* PacketHelper::getMsgIdWithTopicIdPlusPacket(MsgType msgType, uint1
     return packet;
 }
 
+TagInfo PacketHelper::getPublishTagInfo(const inet::Ptr<const inet::Chunk>& payload)
+{
+    TagInfo tagInfo;
+
+    const auto& creationTimeTag = payload->findTag<inet::CreationTimeTag>();
+    if (creationTimeTag != nullptr) {
+        tagInfo.timestamp = inet::ClockTime::SIMTIME_AS_CLOCKTIME(creationTimeTag->getCreationTime());
+    }
+
+    const auto& identifierTag = payload->findTag<IdentifierTag>();
+    if (identifierTag != nullptr) {
+        tagInfo.identifier = identifierTag->getIdentifier();
+    }
+
+    const auto& stageTimestampTag = payload->findTag<StageTimestampTag>();
+    if (stageTimestampTag != nullptr) {
+        tagInfo.stageTimestamps = stageTimestampTag->getTimestamps();
+    }
+
+    return tagInfo;
+}
+
 } /* namespace mqttsn */
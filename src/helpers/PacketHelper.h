@@ -37,6 +37,8 @@ class PacketHelper : public BaseHelper
 
         static inet::Packet* getBaseWithMsgIdPacket(MsgType msgType, uint16_t msgId);
         static inet::Packet* getMsgIdWithTopicIdPlusPacket(MsgType msgType, uint16_t topicId, uint16_t msgId, ReturnCode returnCode);
+
+        static TagInfo getPublishTagInfo(const inet::Ptr<const inet::Chunk>& payload);
 };
 
 } /* namespace mqttsn */
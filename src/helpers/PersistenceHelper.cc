@@ -0,0 +1,151 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "PersistenceHelper.h"
+
+namespace mqttsn {
+
+void PersistenceHelper::writeClockTime(WriteAheadLog& log, inet::clocktime_t value)
+{
+    log.write<int64_t>(inet::ClockTime::CLOCKTIME_AS_SIMTIME(value).raw());
+}
+
+void PersistenceHelper::writeAddress(WriteAheadLog& log, const inet::L3Address& address)
+{
+    log.writeString(address.str());
+}
+
+void PersistenceHelper::writeTagInfo(WriteAheadLog& log, const TagInfo& tagInfo)
+{
+    writeClockTime(log, tagInfo.timestamp);
+    log.write<uint32_t>(tagInfo.identifier);
+
+    for (const auto& stageTimestamp : tagInfo.stageTimestamps) {
+        writeClockTime(log, stageTimestamp);
+    }
+}
+
+void PersistenceHelper::writeMessageInfo(WriteAheadLog& log, const MessageInfo& messageInfo)
+{
+    log.write<uint16_t>(messageInfo.topicId);
+    log.write<uint8_t>(messageInfo.topicIdType);
+    log.write<uint8_t>(messageInfo.dup);
+    log.write<uint8_t>(messageInfo.qos);
+    log.write<uint8_t>(messageInfo.retain);
+    log.writeString(messageInfo.data);
+    writeTagInfo(log, messageInfo.tagInfo);
+}
+
+void PersistenceHelper::writeRequestInfo(WriteAheadLog& log, const RequestInfo& requestInfo)
+{
+    writeAddress(log, requestInfo.subscriberAddress);
+    log.write<int32_t>(requestInfo.subscriberPort);
+    log.write<uint8_t>(requestInfo.messageType);
+    log.write<uint8_t>(requestInfo.sendAtLeastOnce);
+    log.write<int32_t>(requestInfo.retransmissionCounter);
+    log.write<uint16_t>(requestInfo.messagesKey);
+    log.write<uint16_t>(requestInfo.retainMessagesKey);
+}
+
+void PersistenceHelper::writeDataInfo(WriteAheadLog& log, const DataInfo& dataInfo)
+{
+    log.write<uint16_t>(dataInfo.topicId);
+    log.write<uint8_t>(dataInfo.topicIdType);
+    log.write<uint8_t>(dataInfo.retain);
+    log.writeString(dataInfo.data);
+    writeTagInfo(log, dataInfo.tagInfo);
+}
+
+void PersistenceHelper::writeRetainMessageInfo(WriteAheadLog& log, const RetainMessageInfo& retainMessageInfo)
+{
+    log.write<uint8_t>(retainMessageInfo.topicIdType);
+    log.write<uint8_t>(retainMessageInfo.dup);
+    log.write<uint8_t>(retainMessageInfo.qos);
+}
+
+inet::clocktime_t PersistenceHelper::readClockTime(WalReader& reader)
+{
+    return inet::ClockTime::SIMTIME_AS_CLOCKTIME(omnetpp::SimTime::fromRaw(reader.read<int64_t>()));
+}
+
+inet::L3Address PersistenceHelper::readAddress(WalReader& reader)
+{
+    return inet::L3Address(reader.readString().c_str());
+}
+
+TagInfo PersistenceHelper::readTagInfo(WalReader& reader)
+{
+    TagInfo tagInfo;
+    tagInfo.timestamp = readClockTime(reader);
+    tagInfo.identifier = reader.read<uint32_t>();
+
+    for (auto& stageTimestamp : tagInfo.stageTimestamps) {
+        stageTimestamp = readClockTime(reader);
+    }
+
+    return tagInfo;
+}
+
+MessageInfo PersistenceHelper::readMessageInfo(WalReader& reader)
+{
+    MessageInfo messageInfo;
+    messageInfo.topicId = reader.read<uint16_t>();
+    messageInfo.topicIdType = (TopicIdType) reader.read<uint8_t>();
+    messageInfo.dup = reader.read<uint8_t>();
+    messageInfo.qos = (QoS) reader.read<uint8_t>();
+    messageInfo.retain = reader.read<uint8_t>();
+    messageInfo.data = reader.readString();
+    messageInfo.tagInfo = readTagInfo(reader);
+
+    return messageInfo;
+}
+
+RequestInfo PersistenceHelper::readRequestInfo(WalReader& reader)
+{
+    RequestInfo requestInfo;
+    requestInfo.subscriberAddress = readAddress(reader);
+    requestInfo.subscriberPort = reader.read<int32_t>();
+    requestInfo.messageType = (MsgType) reader.read<uint8_t>();
+    requestInfo.sendAtLeastOnce = reader.read<uint8_t>();
+    requestInfo.retransmissionCounter = reader.read<int32_t>();
+    requestInfo.messagesKey = reader.read<uint16_t>();
+    requestInfo.retainMessagesKey = reader.read<uint16_t>();
+
+    return requestInfo;
+}
+
+DataInfo PersistenceHelper::readDataInfo(WalReader& reader)
+{
+    DataInfo dataInfo;
+    dataInfo.topicId = reader.read<uint16_t>();
+    dataInfo.topicIdType = (TopicIdType) reader.read<uint8_t>();
+    dataInfo.retain = reader.read<uint8_t>();
+    dataInfo.data = reader.readString();
+    dataInfo.tagInfo = readTagInfo(reader);
+
+    return dataInfo;
+}
+
+RetainMessageInfo PersistenceHelper::readRetainMessageInfo(WalReader& reader)
+{
+    RetainMessageInfo retainMessageInfo;
+    retainMessageInfo.topicIdType = (TopicIdType) reader.read<uint8_t>();
+    retainMessageInfo.dup = reader.read<uint8_t>();
+    retainMessageInfo.qos = (QoS) reader.read<uint8_t>();
+
+    return retainMessageInfo;
+}
+
+} /* namespace mqttsn */
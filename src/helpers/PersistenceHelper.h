@@ -0,0 +1,57 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef HELPERS_PERSISTENCEHELPER_H_
+#define HELPERS_PERSISTENCEHELPER_H_
+
+#include "BaseHelper.h"
+#include "inet/common/clock/ClockUserModuleMixin.h"
+#include "inet/networklayer/common/L3Address.h"
+#include "persistence/WriteAheadLog.h"
+#include "types/shared/MsgType.h"
+#include "types/shared/QoS.h"
+#include "types/shared/TopicIdType.h"
+#include "types/shared/TagInfo.h"
+#include "types/server/MessageInfo.h"
+#include "types/server/RequestInfo.h"
+#include "types/server/DataInfo.h"
+#include "types/server/RetainMessageInfo.h"
+
+namespace mqttsn {
+
+// Field encoding of the gateway state stored in the write-ahead log
+class PersistenceHelper : public BaseHelper
+{
+    public:
+        static void writeClockTime(WriteAheadLog& log, inet::clocktime_t value);
+        static void writeAddress(WriteAheadLog& log, const inet::L3Address& address);
+        static void writeTagInfo(WriteAheadLog& log, const TagInfo& tagInfo);
+        static void writeMessageInfo(WriteAheadLog& log, const MessageInfo& messageInfo);
+        static void writeRequestInfo(WriteAheadLog& log, const RequestInfo& requestInfo);
+        static void writeDataInfo(WriteAheadLog& log, const DataInfo& dataInfo);
+        static void writeRetainMessageInfo(WriteAheadLog& log, const RetainMessageInfo& retainMessageInfo);
+
+        static inet::clocktime_t readClockTime(WalReader& reader);
+        static inet::L3Address readAddress(WalReader& reader);
+        static TagInfo readTagInfo(WalReader& reader);
+        static MessageInfo readMessageInfo(WalReader& reader);
+        static RequestInfo readRequestInfo(WalReader& reader);
+        static DataInfo readDataInfo(WalReader& reader);
+        static RetainMessageInfo readRetainMessageInfo(WalReader& reader);
+};
+
+} /* namespace mqttsn */
+
+#endif /* HELPERS_PERSISTENCEHELPER_H_ */
@@ -100,4 +100,26 @@ std::string StringHelper::getStringBeforeDelimiter(const std::string& inputStrin
     }
 }
 
+std::vector<std::string> StringHelper::splitString(const std::string& inputString, char delimiter)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+
+    // empty parts are skipped, so trailing delimiters are allowed
+    while (start <= inputString.size()) {
+        size_t delimiterPos = inputString.find(delimiter, start);
+        if (delimiterPos == std::string::npos) {
+            delimiterPos = inputString.size();
+        }
+
+        if (delimiterPos > start) {
+            parts.push_back(inputString.substr(start, delimiterPos - start));
+        }
+
+        start = delimiterPos + 1;
+    }
+
+    return parts;
+}
+
 } /* namespace mqttsn */
@@ -31,6 +31,7 @@ class StringHelper : public BaseHelper
         static std::string sanitizeSpaces(const std::string& inputString);
         static std::string appendCounterToString(const std::string& inputString, const std::string& delimiter, int counter);
         static std::string getStringBeforeDelimiter(const std::string& inputString, const std::string& delimiter);
+        static std::vector<std::string> splitString(const std::string& inputString, char delimiter);
 };
 
 } /* namespace mqttsn */
@@ -0,0 +1,116 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "EventJournal.h"
+#include <omnetpp.h>
+
+namespace mqttsn {
+
+bool EventJournal::enabled = false;
+std::string EventJournal::fileName;
+std::ofstream EventJournal::stream;
+std::vector<JournalRecord> EventJournal::buffer;
+
+void EventJournal::open(const std::string& fileName)
+{
+    if (enabled) {
+        if (fileName != EventJournal::fileName) {
+            throw omnetpp::cRuntimeError("Event journal already open on file: %s", EventJournal::fileName.c_str());
+        }
+
+        return;
+    }
+
+    stream.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw omnetpp::cRuntimeError("Failed to open event journal file: %s", fileName.c_str());
+    }
+
+    stream.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+
+    EventJournal::fileName = fileName;
+
+    buffer.clear();
+    buffer.reserve(BLOCK_RECORDS);
+
+    enabled = true;
+}
+
+void EventJournal::registerModule(int moduleId, const std::string& modulePath)
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint8_t blockType = TraceBlockType::MODULE_BLOCK;
+    int32_t id = moduleId;
+    uint16_t length = (uint16_t) modulePath.size();
+
+    stream.write(reinterpret_cast<const char*>(&blockType), sizeof(blockType));
+    stream.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    stream.write(modulePath.data(), length);
+}
+
+void EventJournal::record(LogEvent event, int level, int64_t timestamp, int32_t moduleId, int64_t value1, int64_t value2)
+{
+    if (!enabled) {
+        return;
+    }
+
+    JournalRecord journalRecord;
+    journalRecord.timestamp = timestamp;
+    journalRecord.value1 = value1;
+    journalRecord.value2 = value2;
+    journalRecord.moduleId = moduleId;
+    journalRecord.event = event;
+    journalRecord.level = (uint16_t) level;
+
+    buffer.push_back(journalRecord);
+
+    if (buffer.size() >= BLOCK_RECORDS) {
+        writeRecords();
+    }
+}
+
+void EventJournal::writeRecords()
+{
+    if (buffer.empty()) {
+        return;
+    }
+
+    uint8_t blockType = TraceBlockType::RECORD_BLOCK;
+    uint32_t recordCount = (uint32_t) buffer.size();
+
+    stream.write(reinterpret_cast<const char*>(&blockType), sizeof(blockType));
+    stream.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
+    stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(JournalRecord));
+
+    buffer.clear();
+}
+
+void EventJournal::close()
+{
+    if (!enabled) {
+        return;
+    }
+
+    writeRecords();
+    stream.close();
+
+    enabled = false;
+}
+
+} /* namespace mqttsn */
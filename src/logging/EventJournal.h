@@ -0,0 +1,56 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef LOGGING_EVENTJOURNAL_H_
+#define LOGGING_EVENTJOURNAL_H_
+
+#include "JournalFormat.h"
+#include "types/shared/LogEvent.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// Process wide binary journal of log events. When open, the logging macros append
+// fixed size records instead of formatting text; records are written in blocks.
+class EventJournal
+{
+    protected:
+        static constexpr size_t BLOCK_RECORDS = 4096;
+
+        static bool enabled;
+        static std::string fileName;
+        static std::ofstream stream;
+        static std::vector<JournalRecord> buffer;
+
+    protected:
+        static void writeRecords();
+
+    public:
+        static bool isEnabled() { return enabled; }
+
+        // opening an already open journal is a no-op so that every module can request it
+        static void open(const std::string& fileName);
+        static void registerModule(int moduleId, const std::string& modulePath);
+
+        static void record(LogEvent event, int level, int64_t timestamp, int32_t moduleId, int64_t value1, int64_t value2);
+
+        static void close();
+};
+
+} /* namespace mqttsn */
+
+#endif /* LOGGING_EVENTJOURNAL_H_ */
@@ -0,0 +1,40 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef LOGGING_JOURNALFORMAT_H_
+#define LOGGING_JOURNALFORMAT_H_
+
+#include "tracing/TraceFormat.h"
+
+namespace mqttsn {
+
+// Event journals use the block layout of message traces with their own magic;
+// record blocks hold packed JournalRecord entries.
+static constexpr char JOURNAL_MAGIC[8] = {'M', 'Q', 'S', 'N', 'J', 'R', 'N', '1'};
+
+struct JournalRecord {
+    int64_t timestamp = 0; // simulation time in nanoseconds
+    int64_t value1 = 0;
+    int64_t value2 = 0;
+    int32_t moduleId = 0;
+    uint16_t event = 0;
+    uint16_t level = 0;
+};
+
+static_assert(sizeof(JournalRecord) == 32, "Journal records must stay packed");
+
+} /* namespace mqttsn */
+
+#endif /* LOGGING_JOURNALFORMAT_H_ */
@@ -0,0 +1,52 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef LOGGING_LOGGING_H_
+#define LOGGING_LOGGING_H_
+
+#include <omnetpp.h>
+#include "EventJournal.h"
+
+// Structured logging for module code. Every statement names a LogEvent with two numeric
+// values for the binary journal, and the EV text used when no journal is open. Arguments
+// are only evaluated when the statement is emitted; statements above MQTTSN_LOG_LEVEL are
+// removed at compile time, e.g. by adding -DMQTTSN_LOG_LEVEL=MQTTSN_LOG_LEVEL_WARN.
+#define MQTTSN_LOG_LEVEL_OFF 0
+#define MQTTSN_LOG_LEVEL_WARN 1
+#define MQTTSN_LOG_LEVEL_INFO 2
+#define MQTTSN_LOG_LEVEL_DEBUG 3
+
+#ifndef MQTTSN_LOG_LEVEL
+#define MQTTSN_LOG_LEVEL MQTTSN_LOG_LEVEL_DEBUG
+#endif
+
+#define MQTTSN_LOG(level, evStream, event, value1, value2, text) \
+    do { \
+        if ((level) <= MQTTSN_LOG_LEVEL) { \
+            if (mqttsn::EventJournal::isEnabled()) { \
+                mqttsn::EventJournal::record((event), (level), omnetpp::simTime().inUnit(omnetpp::SIMTIME_NS), getId(), \
+                                             (int64_t) (value1), (int64_t) (value2)); \
+            } \
+            else { \
+                evStream << text << std::endl; \
+            } \
+        } \
+    } while (0)
+
+#define MQTTSN_LOG_WARN(event, value1, value2, text) MQTTSN_LOG(MQTTSN_LOG_LEVEL_WARN, EV_WARN, event, value1, value2, text)
+#define MQTTSN_LOG_INFO(event, value1, value2, text) MQTTSN_LOG(MQTTSN_LOG_LEVEL_INFO, EV_INFO, event, value1, value2, text)
+#define MQTTSN_LOG_DEBUG(event, value1, value2, text) MQTTSN_LOG(MQTTSN_LOG_LEVEL_DEBUG, EV_DEBUG, event, value1, value2, text)
+
+#endif /* LOGGING_LOGGING_H_ */
@@ -17,23 +17,23 @@
 #include "types/shared/MsgTypesMap.h"
 #include "types/shared/Length.h"
 #include "cxxabi.h"
+#include <typeindex>
 
 namespace mqttsn {
 
 /* Private */
 void MqttSNBase::setLength(uint16_t octets)
 {
-    if (length.size() > 0)
-        length.clear();
-
     if (octets <= UINT8_MAX) {
-        length.push_back(static_cast<uint8_t>(octets));
+        length[0] = static_cast<uint8_t>(octets);
+        lengthOctets = 1;
     }
     else {
-        length.push_back(0x01);
-        length.push_back(static_cast<uint8_t>(octets & 0xFF));
-        length.push_back(static_cast<uint8_t>((octets >> 8) & 0xFF));
-   }
+        length[0] = 0x01;
+        length[1] = static_cast<uint8_t>(octets & 0xFF);
+        length[2] = static_cast<uint8_t>((octets >> 8) & 0xFF);
+        lengthOctets = 3;
+    }
 }
 
 /* Protected */
@@ -66,7 +66,7 @@ void MqttSNBase::setOptionalField(uint32_t value, uint16_t octets, uint32_t& fie
     addLength(length, prevLength);
 }
 
-void MqttSNBase::setStringField(const std::string& value, uint16_t minLength, uint16_t maxLength, const std::string& error, std::string& field)
+void MqttSNBase::setStringField(std::string value, uint16_t minLength, uint16_t maxLength, const char* error, std::string& field)
 {
     if (maxLength < minLength)
         throw omnetpp::cRuntimeError("Minimum string length cannot be greater than the maximum one");
@@ -76,10 +76,10 @@ void MqttSNBase::setStringField(const std::string& value, uint16_t minLength, ui
 
     if (length >= minLength && length <= maxLength) {
         prevLength = field.size();
-        field = value;
+        field = std::move(value);
     }
     else {
-        throw omnetpp::cRuntimeError("%s", error.c_str());
+        throw omnetpp::cRuntimeError("%s", error);
     }
 
     addLength(length, prevLength);
@@ -128,11 +128,11 @@ MqttSNBase::MqttSNBase()
 
 uint16_t MqttSNBase::getLength() const
 {
-    if (length.size() == 1) {
+    if (lengthOctets == 1) {
         return static_cast<uint16_t>(length[0]);
     }
 
-    if (length.size() == 3 && length[0] == 0x01) {
+    if (lengthOctets == 3 && length[0] == 0x01) {
         return static_cast<uint16_t>(length[2]) << 8 | static_cast<uint16_t>(length[1]);
     }
 
@@ -146,17 +146,26 @@ uint16_t MqttSNBase::getAvailableLength() const
 
 void MqttSNBase::setMsgType(MsgType messageType)
 {
-    std::string className = getClassName(typeid(*this).name());
-    std::vector<MsgType> types;
+    // resolve the allowed types once per class instead of demangling on every call
+    static std::map<std::type_index, const std::vector<MsgType>*> typesCache;
+
+    std::type_index classType(typeid(*this));
+    const std::vector<MsgType>* types;
 
-    try {
-        types = msgTypesMap.at(className);
+    auto it = typesCache.find(classType);
+    if (it != typesCache.end()) {
+        types = it->second;
     }
-    catch (std::out_of_range e) {
-        throw omnetpp::cRuntimeError("Class without message type");
+    else {
+        auto typesIt = msgTypesMap.find(getClassName(classType.name()));
+        if (typesIt == msgTypesMap.end())
+            throw omnetpp::cRuntimeError("Class without message type");
+
+        types = &typesIt->second;
+        typesCache[classType] = types;
     }
 
-    if (std::find(types.begin(), types.end(), messageType) == types.end()) {
+    if (std::find(types->begin(), types->end(), messageType) == types->end()) {
         throw omnetpp::cRuntimeError("Incorrect message type");
     }
 
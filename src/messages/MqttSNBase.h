@@ -25,7 +25,9 @@ namespace mqttsn {
 class MqttSNBase : public inet::FieldsChunk
 {
     private:
-        std::vector<uint8_t> length;
+        // 1 or 3 octets of encoded length stored inline
+        uint8_t length[3];
+        uint8_t lengthOctets = 0;
         MsgType msgType;
 
     private:
@@ -35,7 +37,7 @@ class MqttSNBase : public inet::FieldsChunk
         void addLength(uint16_t octets, uint16_t prevOctets = 0);
 
         void setOptionalField(uint32_t value, uint16_t octets, uint32_t& field);
-        void setStringField(const std::string& value, uint16_t minLength, uint16_t maxLength, const std::string& error, std::string& field);
+        void setStringField(std::string value, uint16_t minLength, uint16_t maxLength, const char* error, std::string& field);
 
         void setFlag(uint8_t value, Flag position, uint8_t& flags);
         void setBooleanFlag(bool value, Flag position, uint8_t& flags);
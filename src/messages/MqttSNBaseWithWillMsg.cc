@@ -18,10 +18,10 @@
 
 namespace mqttsn {
 
-void MqttSNBaseWithWillMsg::setWillMsg(const std::string& willMessage)
+void MqttSNBaseWithWillMsg::setWillMsg(std::string willMessage)
 {
     MqttSNBase::setStringField(
-            willMessage,
+            std::move(willMessage),
             Length::ZERO_OCTETS,
             MqttSNBase::getAvailableLength(),
             "Will message length out of range",
@@ -29,7 +29,7 @@ void MqttSNBaseWithWillMsg::setWillMsg(const std::string& willMessage)
     );
 }
 
-std::string MqttSNBaseWithWillMsg::getWillMsg() const
+const std::string& MqttSNBaseWithWillMsg::getWillMsg() const
 {
     return willMsg;
 }
@@ -28,8 +28,8 @@ class MqttSNBaseWithWillMsg : public MqttSNBase
     public:
         MqttSNBaseWithWillMsg() {};
 
-        void setWillMsg(const std::string& willMessage);
-        std::string getWillMsg() const;
+        void setWillMsg(std::string willMessage);
+        const std::string& getWillMsg() const;
 
         ~MqttSNBaseWithWillMsg() {};
 };
@@ -43,10 +43,10 @@ bool MqttSNBaseWithWillTopic::getRetainFlag() const
     return MqttSNBase::getBooleanFlag(Flag::RETAIN, flags);
 }
 
-void MqttSNBaseWithWillTopic::setWillTopic(const std::string& topicName)
+void MqttSNBaseWithWillTopic::setWillTopic(std::string topicName)
 {
     MqttSNBase::setStringField(
-            topicName,
+            std::move(topicName),
             Length::ZERO_OCTETS,
             MqttSNBase::getAvailableLength(),
             "Will topic name length out of range",
@@ -54,7 +54,7 @@ void MqttSNBaseWithWillTopic::setWillTopic(const std::string& topicName)
     );
 }
 
-std::string MqttSNBaseWithWillTopic::getWillTopic() const
+const std::string& MqttSNBaseWithWillTopic::getWillTopic() const
 {
     return willTopic;
 }
@@ -36,8 +36,8 @@ private:
         void setRetainFlag(bool retainFlag);
         bool getRetainFlag() const;
 
-        void setWillTopic(const std::string& topicName);
-        std::string getWillTopic() const;
+        void setWillTopic(std::string topicName);
+        const std::string& getWillTopic() const;
 
         ~MqttSNBaseWithWillTopic() {};
 };
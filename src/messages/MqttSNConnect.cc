@@ -49,10 +49,10 @@ uint8_t MqttSNConnect::getProtocolId() const
     return protocolId;
 }
 
-void MqttSNConnect::setClientId(const std::string& id)
+void MqttSNConnect::setClientId(std::string id)
 {
     MqttSNBase::setStringField(
-            id,
+            std::move(id),
             Length::ONE_OCTET,
             Length::CLIENT_ID_OCTETS,
             "Client ID length out of range",
@@ -60,7 +60,7 @@ void MqttSNConnect::setClientId(const std::string& id)
     );
 }
 
-std::string MqttSNConnect::getClientId() const
+const std::string& MqttSNConnect::getClientId() const
 {
     return clientId;
 }
@@ -38,8 +38,8 @@ class MqttSNConnect : public MqttSNBaseWithDuration
 
         uint8_t getProtocolId() const;
 
-        void setClientId(const std::string& id);
-        std::string getClientId() const;
+        void setClientId(std::string id);
+        const std::string& getClientId() const;
 
         ~MqttSNConnect() {};
 };
@@ -18,10 +18,10 @@
 
 namespace mqttsn {
 
-void MqttSNPingReq::setClientId(const std::string& id)
+void MqttSNPingReq::setClientId(std::string id)
 {
     MqttSNBase::setStringField(
-            id,
+            std::move(id),
             Length::ONE_OCTET,
             Length::CLIENT_ID_OCTETS,
             "Client ID length out of range",
@@ -29,7 +29,7 @@ void MqttSNPingReq::setClientId(const std::string& id)
     );
 }
 
-std::string MqttSNPingReq::getClientId() const
+const std::string& MqttSNPingReq::getClientId() const
 {
     return clientId;
 }
@@ -28,8 +28,8 @@ class MqttSNPingReq : public MqttSNBase
     public:
         MqttSNPingReq() {};
 
-        void setClientId(const std::string& id);
-        std::string getClientId() const;
+        void setClientId(std::string id);
+        const std::string& getClientId() const;
 
         ~MqttSNPingReq() {};
 };
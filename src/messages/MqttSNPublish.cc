@@ -63,10 +63,10 @@ uint8_t MqttSNPublish::getTopicIdTypeFlag() const
     return MqttSNBase::getFlag(Flag::TOPIC_ID_TYPE, flags);
 }
 
-void MqttSNPublish::setData(const std::string& stringData)
+void MqttSNPublish::setData(std::string stringData)
 {
     MqttSNBase::setStringField(
-            stringData,
+            std::move(stringData),
             Length::ZERO_OCTETS,
             MqttSNBase::getAvailableLength(),
             "Data string length out of range",
@@ -74,7 +74,7 @@ void MqttSNPublish::setData(const std::string& stringData)
     );
 }
 
-std::string MqttSNPublish::getData() const
+const std::string& MqttSNPublish::getData() const
 {
     return data;
 }
@@ -43,8 +43,8 @@ class MqttSNPublish : public MqttSNMsgIdWithTopicId
         void setTopicIdTypeFlag(TopicIdType topicIdTypeFlag);
         uint8_t getTopicIdTypeFlag() const;
 
-        void setData(const std::string& stringData);
-        std::string getData() const;
+        void setData(std::string stringData);
+        const std::string& getData() const;
 
         ~MqttSNPublish() {};
 };
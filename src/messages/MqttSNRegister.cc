@@ -18,10 +18,10 @@
 
 namespace mqttsn {
 
-void MqttSNRegister::setTopicName(const std::string& name)
+void MqttSNRegister::setTopicName(std::string name)
 {
     MqttSNBase::setStringField(
-            name,
+            std::move(name),
             Length::ZERO_OCTETS,
             MqttSNBase::getAvailableLength(),
             "Topic name length out of range",
@@ -29,7 +29,7 @@ void MqttSNRegister::setTopicName(const std::string& name)
     );
 }
 
-std::string MqttSNRegister::getTopicName() const
+const std::string& MqttSNRegister::getTopicName() const
 {
     return topicName;
 }
@@ -28,8 +28,8 @@ class MqttSNRegister : public MqttSNMsgIdWithTopicId
     public:
         MqttSNRegister() {};
 
-        void setTopicName(const std::string& name);
-        std::string getTopicName() const;
+        void setTopicName(std::string name);
+        const std::string& getTopicName() const;
 
         ~MqttSNRegister() {};
 };
@@ -33,13 +33,13 @@ uint8_t MqttSNUnsubscribe::getTopicIdTypeFlag() const
     return MqttSNBase::getFlag(Flag::TOPIC_ID_TYPE, flags);
 }
 
-void MqttSNUnsubscribe::setTopicName(const std::string& name)
+void MqttSNUnsubscribe::setTopicName(std::string name)
 {
     uint8_t topicIdFlag = getTopicIdTypeFlag();
 
     if (topicIdFlag == TopicIdType::NORMAL_TOPIC_ID)
         MqttSNBase::setStringField(
-                name,
+                std::move(name),
                 Length::ZERO_OCTETS,
                 MqttSNBase::getAvailableLength(),
                 "Topic name length out of range",
@@ -47,7 +47,7 @@ void MqttSNUnsubscribe::setTopicName(const std::string& name)
         );
     else if (topicIdFlag == TopicIdType::SHORT_TOPIC_ID)
         MqttSNBase::setStringField(
-                name,
+                std::move(name),
                 Length::ZERO_OCTETS,
                 Length::TWO_OCTETS,
                 "Short topic name length out of range",
@@ -57,7 +57,7 @@ void MqttSNUnsubscribe::setTopicName(const std::string& name)
         throw omnetpp::cRuntimeError("The topic ID type flag is not correctly set to either topic name or short topic name");
 }
 
-std::string MqttSNUnsubscribe::getTopicName() const
+const std::string& MqttSNUnsubscribe::getTopicName() const
 {
     return topicName;
 }
@@ -36,8 +36,8 @@ class MqttSNUnsubscribe : public MqttSNBaseWithMsgId
         void setTopicIdTypeFlag(TopicIdType topicIdTypeFlag);
         uint8_t getTopicIdTypeFlag() const;
 
-        void setTopicName(const std::string& name);
-        std::string getTopicName() const;
+        void setTopicName(std::string name);
+        const std::string& getTopicName() const;
 
         void setTopicId(uint16_t id);
         uint16_t getTopicId() const;
@@ -0,0 +1,129 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "HandlerProfiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+namespace mqttsn {
+
+std::map<std::pair<std::string, std::string>, HandlerStats> HandlerProfiler::typeHandlers;
+std::map<std::string, HandlerStats> HandlerProfiler::modules;
+int HandlerProfiler::activeProfilers = 0;
+
+void HandlerProfiler::start()
+{
+    if (started) {
+        return;
+    }
+
+    handlers.clear();
+    started = true;
+
+    activeProfilers++;
+}
+
+void HandlerProfiler::record(const std::string& handler, uint64_t nanoseconds)
+{
+    HandlerStats& stats = handlers[handler];
+    stats.count++;
+    stats.totalTime += nanoseconds;
+    stats.maxTime = std::max(stats.maxTime, nanoseconds);
+}
+
+HandlerStats HandlerProfiler::getTotal() const
+{
+    HandlerStats total;
+
+    for (const auto& pair : handlers) {
+        merge(total, pair.second);
+    }
+
+    return total;
+}
+
+bool HandlerProfiler::finish(const std::string& moduleType, const std::string& modulePath, std::ostream& out)
+{
+    if (!started) {
+        return false;
+    }
+
+    for (const auto& pair : handlers) {
+        merge(typeHandlers[std::make_pair(moduleType, pair.first)], pair.second);
+    }
+    merge(modules[modulePath], getTotal());
+
+    started = false;
+
+    if (--activeProfilers > 0) {
+        return false;
+    }
+
+    // sort both tables by decreasing total time
+    std::vector<std::pair<std::string, HandlerStats>> handlerRows;
+    for (const auto& pair : typeHandlers) {
+        handlerRows.emplace_back(pair.first.first + " " + pair.first.second, pair.second);
+    }
+
+    std::vector<std::pair<std::string, HandlerStats>> moduleRows(modules.begin(), modules.end());
+
+    auto byTotalTime = [](const std::pair<std::string, HandlerStats>& a, const std::pair<std::string, HandlerStats>& b) {
+        return a.second.totalTime > b.second.totalTime;
+    };
+    std::stable_sort(handlerRows.begin(), handlerRows.end(), byTotalTime);
+    std::stable_sort(moduleRows.begin(), moduleRows.end(), byTotalTime);
+
+    out << "==== Event Handler Profile ====" << std::endl;
+    out << "count, total (ms), mean (us), max (us), handler" << std::endl;
+    for (const auto& row : handlerRows) {
+        printRow(out, row.first, row.second);
+    }
+    out << std::endl;
+
+    out << "count, total (ms), mean (us), max (us), module" << std::endl;
+    for (const auto& row : moduleRows) {
+        printRow(out, row.first, row.second);
+    }
+    out << std::endl;
+
+    typeHandlers.clear();
+    modules.clear();
+
+    return true;
+}
+
+void HandlerProfiler::merge(HandlerStats& target, const HandlerStats& source)
+{
+    target.count += source.count;
+    target.totalTime += source.totalTime;
+    target.maxTime = std::max(target.maxTime, source.maxTime);
+}
+
+void HandlerProfiler::printRow(std::ostream& out, const std::string& name, const HandlerStats& stats)
+{
+    double mean = stats.count > 0 ? (double) stats.totalTime / stats.count : 0;
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3)
+        << stats.count << ", "
+        << stats.totalTime / 1e6 << ", "
+        << mean / 1e3 << ", "
+        << stats.maxTime / 1e3 << ", "
+        << name << std::endl;
+    out.flags(flags);
+}
+
+} /* namespace mqttsn */
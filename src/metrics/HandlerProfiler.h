@@ -0,0 +1,57 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef METRICS_HANDLERPROFILER_H_
+#define METRICS_HANDLERPROFILER_H_
+
+#include "types/shared/HandlerStats.h"
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace mqttsn {
+
+// Wall time accounting of the events handled by a module, keyed by handler name.
+// Every profiler merges its statistics into process wide totals when finished; the
+// last profiler to finish prints a report sorted by total time.
+class HandlerProfiler
+{
+    protected:
+        std::map<std::string, HandlerStats> handlers;
+        bool started = false;
+
+        // totals keyed by module type and handler, and by module path
+        static std::map<std::pair<std::string, std::string>, HandlerStats> typeHandlers;
+        static std::map<std::string, HandlerStats> modules;
+        static int activeProfilers;
+
+    protected:
+        static void merge(HandlerStats& target, const HandlerStats& source);
+        static void printRow(std::ostream& out, const std::string& name, const HandlerStats& stats);
+
+    public:
+        HandlerProfiler() {};
+
+        void start();
+        void record(const std::string& handler, uint64_t nanoseconds);
+        HandlerStats getTotal() const;
+
+        // returns true if this was the last active profiler and the report was printed
+        bool finish(const std::string& moduleType, const std::string& modulePath, std::ostream& out);
+};
+
+} /* namespace mqttsn */
+
+#endif /* METRICS_HANDLERPROFILER_H_ */
@@ -0,0 +1,128 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mqttsn {
+
+size_t LatencyHistogram::getBucketIndex(uint64_t value)
+{
+    // position of the most significant bit; values below two sub-bucket ranges map linearly
+    int msb = value == 0 ? 0 : 63 - __builtin_clzll(value);
+    int shift = std::max(0, msb - (int) SUB_BUCKET_BITS);
+
+    return shift * SUB_BUCKET_COUNT + (value >> shift);
+}
+
+uint64_t LatencyHistogram::getBucketValue(size_t index)
+{
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return index;
+    }
+
+    // middle of the value range covered by the bucket
+    uint64_t shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t mantissa = index - shift * SUB_BUCKET_COUNT;
+
+    return (mantissa << shift) + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(double seconds)
+{
+    uint64_t value = seconds > 0 ? (uint64_t) std::llround(seconds * 1e9) : 0;
+    size_t index = getBucketIndex(value);
+
+    if (index >= counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+
+    counts[index]++;
+    totalCount++;
+
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+    sum += seconds > 0 ? seconds : 0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    if (other.counts.size() > counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+
+    for (size_t i = 0; i < other.counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+
+    totalCount += other.totalCount;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+    sum += other.sum;
+}
+
+void LatencyHistogram::clear()
+{
+    counts.clear();
+    totalCount = 0;
+    minValue = UINT64_MAX;
+    maxValue = 0;
+    sum = 0;
+}
+
+double LatencyHistogram::getPercentile(double percentile) const
+{
+    if (totalCount == 0) {
+        return 0;
+    }
+
+    if (percentile >= 100) {
+        return getMax();
+    }
+
+    // rank of the requested percentile, at least the first value
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t) std::ceil(percentile / 100 * totalCount));
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        cumulative += counts[i];
+
+        if (cumulative >= rank) {
+            // keep the estimate within the exact observed range
+            uint64_t value = std::min(std::max(getBucketValue(i), minValue), maxValue);
+            return value / 1e9;
+        }
+    }
+
+    return maxValue / 1e9;
+}
+
+double LatencyHistogram::getMean() const
+{
+    return totalCount > 0 ? sum / totalCount : 0;
+}
+
+double LatencyHistogram::getMin() const
+{
+    return totalCount > 0 ? minValue / 1e9 : 0;
+}
+
+double LatencyHistogram::getMax() const
+{
+    return maxValue / 1e9;
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,66 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef METRICS_LATENCYHISTOGRAM_H_
+#define METRICS_LATENCYHISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mqttsn {
+
+// Log-bucketed latency histogram with a bounded relative error. Values are
+// kept in nanoseconds; each power of two is split into 128 linear sub-buckets,
+// so any reported percentile is within 1% of the recorded value. Histograms
+// with the same layout can be merged, which makes interval snapshots cheap.
+class LatencyHistogram
+{
+    protected:
+        static constexpr unsigned SUB_BUCKET_BITS = 7;
+        static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+
+        std::vector<uint64_t> counts;
+
+        uint64_t totalCount = 0;
+        uint64_t minValue = UINT64_MAX;
+        uint64_t maxValue = 0;
+        double sum = 0;
+
+    protected:
+        static size_t getBucketIndex(uint64_t value);
+        static uint64_t getBucketValue(size_t index);
+
+    public:
+        LatencyHistogram() {};
+
+        // record a latency expressed in seconds
+        void record(double seconds);
+        void merge(const LatencyHistogram& other);
+        void clear();
+
+        uint64_t getCount() const { return totalCount; }
+        bool isEmpty() const { return totalCount == 0; }
+
+        // statistics expressed in seconds
+        double getPercentile(double percentile) const;
+        double getMean() const;
+        double getMin() const;
+        double getMax() const;
+};
+
+} /* namespace mqttsn */
+
+#endif /* METRICS_LATENCYHISTOGRAM_H_ */
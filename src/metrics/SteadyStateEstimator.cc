@@ -0,0 +1,155 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "SteadyStateEstimator.h"
+#include <cmath>
+#include <limits>
+
+namespace mqttsn {
+
+void SteadyStateEstimator::record(double value)
+{
+    observations.push_back(value);
+    observationSums.push_back(observationSums.back() + value);
+    batchSum += value;
+
+    if (observations.size() % MSER_BATCH_SIZE == 0) {
+        double batchMean = batchSum / MSER_BATCH_SIZE;
+
+        batchMeans.push_back(batchMean);
+        batchMeanSums.push_back(batchMeanSums.back() + batchMean);
+        batchMeanSquares.push_back(batchMeanSquares.back() + batchMean * batchMean);
+        batchSum = 0;
+
+        // the truncation point only moves when a batch completes
+        warmupLength = computeWarmupLength();
+    }
+}
+
+void SteadyStateEstimator::clear()
+{
+    observations.clear();
+    batchMeans.clear();
+    batchSum = 0;
+
+    observationSums.assign(1, 0);
+    batchMeanSums.assign(1, 0);
+    batchMeanSquares.assign(1, 0);
+
+    warmupLength = -1;
+}
+
+long SteadyStateEstimator::computeWarmupLength() const
+{
+    size_t count = batchMeans.size();
+    if (count < 2) {
+        return -1;
+    }
+
+    size_t bestTruncation = 0;
+    double bestStatistic = std::numeric_limits<double>::max();
+
+    // the prefix sums make every candidate truncation point O(1)
+    for (size_t truncation = 0; truncation < count - 1; truncation++) {
+        double remaining = count - truncation;
+        double mean = (batchMeanSums[count] - batchMeanSums[truncation]) / remaining;
+        double squares = batchMeanSquares[count] - batchMeanSquares[truncation];
+
+        // MSER(d) = sum of the squared deviations of the remaining batches / (n - d)^2
+        double statistic = (squares - remaining * mean * mean) / (remaining * remaining);
+
+        if (statistic < bestStatistic) {
+            bestStatistic = statistic;
+            bestTruncation = truncation;
+        }
+    }
+
+    // a minimum in the second half means the series is still in its transient
+    if (bestTruncation > count / 2) {
+        return -1;
+    }
+
+    return (long) (bestTruncation * MSER_BATCH_SIZE);
+}
+
+double SteadyStateEstimator::getMean() const
+{
+    if (warmupLength < 0 || (size_t) warmupLength >= observations.size()) {
+        return std::nan("");
+    }
+
+    return (observationSums.back() - observationSums[warmupLength]) / (observations.size() - warmupLength);
+}
+
+double SteadyStateEstimator::getHalfWidth(double confidence) const
+{
+    if (warmupLength < 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // the remaining observations are split into equal batches, dropping the oldest leftovers
+    size_t remaining = observations.size() - warmupLength;
+    size_t batchSize = remaining / confidenceBatches;
+    if (confidenceBatches < 2 || batchSize == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    size_t start = observations.size() - batchSize * confidenceBatches;
+    std::vector<double> means(confidenceBatches, 0);
+
+    for (size_t i = 0; i < confidenceBatches; i++) {
+        size_t batchStart = start + i * batchSize;
+        means[i] = (observationSums[batchStart + batchSize] - observationSums[batchStart]) / batchSize;
+    }
+
+    double mean = 0;
+    for (double value : means) {
+        mean += value / confidenceBatches;
+    }
+
+    double variance = 0;
+    for (double value : means) {
+        variance += (value - mean) * (value - mean) / (confidenceBatches - 1);
+    }
+
+    return getStudentQuantile(confidence, confidenceBatches - 1) * std::sqrt(variance / confidenceBatches);
+}
+
+double SteadyStateEstimator::getStudentQuantile(double confidence, size_t degreesOfFreedom)
+{
+    double p = 1 - (1 - confidence) / 2;
+
+    // normal quantile by the rational approximation of Abramowitz and Stegun 26.2.23
+    double tail = 1 - p;
+    double t = std::sqrt(-2 * std::log(tail));
+    double z = t - (2.515517 + 0.802853 * t + 0.010328 * t * t) / (1 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+
+    if (degreesOfFreedom == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // Cornish-Fisher expansion of the student t quantile around the normal one
+    double n = degreesOfFreedom;
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    double z7 = z5 * z * z;
+    double z9 = z7 * z * z;
+
+    return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n)
+            + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n)
+            + (79 * z9 + 776 * z7 + 1482 * z5 - 1920 * z3 - 945 * z) / (92160 * n * n * n * n);
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,72 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef METRICS_STEADYSTATEESTIMATOR_H_
+#define METRICS_STEADYSTATEESTIMATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace mqttsn {
+
+// Output analysis of a series of observations. The warm-up transient is truncated
+// with MSER-5: the observations are averaged in batches of five and the truncation
+// point minimizing the marginal standard error of the remaining batches is chosen,
+// as long as it falls in the first half of the series. The remaining observations
+// are then split into a fixed number of batches whose means give the confidence interval.
+class SteadyStateEstimator
+{
+    protected:
+        static constexpr size_t MSER_BATCH_SIZE = 5;
+
+        std::vector<double> observations;
+        std::vector<double> batchMeans;
+        double batchSum = 0;
+
+        // prefix sums, so that the statistics of any suffix take O(1)
+        std::vector<double> observationSums = {0};
+        std::vector<double> batchMeanSums = {0};
+        std::vector<double> batchMeanSquares = {0};
+
+        // truncation point, updated once per completed batch
+        long warmupLength = -1;
+
+        size_t confidenceBatches;
+
+    protected:
+        long computeWarmupLength() const;
+
+    public:
+        SteadyStateEstimator(size_t confidenceBatches = 20) : confidenceBatches(confidenceBatches) {};
+
+        void record(double value);
+        void clear();
+
+        size_t getCount() const { return observations.size(); }
+
+        // number of truncated observations, or -1 while no truncation point is found
+        long getWarmupLength() const { return warmupLength; }
+
+        // statistics of the observations after the warm-up
+        double getMean() const;
+        double getHalfWidth(double confidence) const;
+
+        // two sided quantile of the student t distribution
+        static double getStudentQuantile(double confidence, size_t degreesOfFreedom);
+};
+
+} /* namespace mqttsn */
+
+#endif /* METRICS_STEADYSTATEESTIMATOR_H_ */
@@ -16,16 +16,25 @@
 #include "MqttSNApp.h"
 #include "inet/networklayer/common/L3AddressResolver.h"
 #include "externals/nlohmann/json.hpp"
+#include "containers/IdCursor.h"
 #include "helpers/StringHelper.h"
 #include "types/shared/Length.h"
+#include "errormodels/UniformErrorModel.h"
+#include "errormodels/GilbertElliottErrorModel.h"
+#include "errormodels/TraceErrorModel.h"
+#include "tracing/MessageTracer.h"
+#include "logging/EventJournal.h"
+#include "snapshot/SimulationFork.h"
 #include "messages/MqttSNGwInfo.h"
 #include "messages/MqttSNPingReq.h"
 #include "messages/MqttSNDisconnect.h"
+#include <chrono>
 
 namespace mqttsn {
 
 using json = nlohmann::json;
 
+std::map<std::string, std::map<std::string, uint16_t>> MqttSNApp::predefinedTopicsRegistry;
 unsigned MqttSNApp::serversRetransmissions = 0;
 
 void MqttSNApp::initialize(int stage)
@@ -38,17 +47,95 @@ void MqttSNApp::initialize(int stage)
 
         packetBER = par("packetBER");
 
+        delete errorModel;
+        errorModel = createErrorModel();
+
         serversRetransmissions = 0;
 
+        profiling = par("profiling");
+        if (profiling) {
+            handlerProfiler.start();
+        }
+
+        initializeTracing();
+        initializeJournal();
+
+        // every module schedules the fork, the first one to reach it forks the whole process
+        forkTime = par("forkTime");
+        if (forkTime >= 0) {
+            forkEvent = new omnetpp::cMessage("forkTimer");
+            scheduleAt(forkTime, forkEvent);
+        }
+
         levelOneInit();
     }
 }
 
+MqttSNApp::~MqttSNApp()
+{
+    cancelAndDelete(forkEvent);
+    delete errorModel;
+}
+
+void MqttSNApp::handleMessage(omnetpp::cMessage* msg)
+{
+    // the fork is independent of the operational state
+    if (msg == forkEvent) {
+        handleForkEvent();
+        return;
+    }
+
+    if (!profiling) {
+        ClockUserModuleMixin::handleMessage(msg);
+        return;
+    }
+
+    // timers and packets are told apart by name; the message may be deleted while handled
+    std::string handler = *msg->getName() ? msg->getName() : msg->getClassName();
+
+    auto start = std::chrono::steady_clock::now();
+    ClockUserModuleMixin::handleMessage(msg);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    handlerProfiler.record(handler, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
 void MqttSNApp::finish()
 {
+    if (profiling) {
+        HandlerStats total = handlerProfiler.getTotal();
+        recordScalar("profiledEvents", total.count);
+        recordScalar("profiledWallTime", total.totalTime / 1e9);
+
+        // the last profiled module to finish prints the report of all modules
+        handlerProfiler.finish(getComponentType()->getName(), getFullPath(), std::cout);
+    }
+
+    // the first module to finish writes out the remaining trace and journal records
+    MessageTracer::close();
+    EventJournal::close();
+
+    // the parent of forked variants finishes once all of them have finished
+    SimulationFork::waitForVariants();
+
     inet::ApplicationBase::finish();
 }
 
+void MqttSNApp::handleParameterChange(const char* parameterName)
+{
+    // refresh the parameters cached at initialization, e.g. after a fork variant assigned them
+    retransmissionInterval = par("retransmissionInterval");
+    retransmissionCounter = par("retransmissionCounter");
+
+    packetBER = par("packetBER");
+
+    // the error model is rebuilt only when its parameters change, so a Gilbert-Elliott channel keeps its state otherwise
+    if (parameterName == nullptr || isErrorModelParameter(parameterName)) {
+        delete errorModel;
+        errorModel = createErrorModel();
+    }
+}
+
 void MqttSNApp::refreshDisplay() const
 {
     inet::ApplicationBase::refreshDisplay();
@@ -92,10 +179,10 @@ void MqttSNApp::checkPacketIntegrity(const inet::B& receivedLength, const inet::
     }
 }
 
-void MqttSNApp::corruptPacket(inet::Packet* packet, double ber)
+void MqttSNApp::corruptPacket(inet::Packet* packet, const inet::L3Address& destAddress)
 {
     // determine if the packet should be considered corrupted
-    bool hasErrors = hasProbabilisticError(packet->getDataLength(), ber);
+    bool hasErrors = errorModel->hasError(inet::B(packet->getByteLength()), destAddress);
 
     // set bit error flag
     packet->setBitError(hasErrors);
@@ -112,9 +199,10 @@ void MqttSNApp::sendGwInfo(uint8_t gatewayId, const std::string& gatewayAddress,
 
     inet::Packet* packet = new inet::Packet("GwInfoPacket");
     packet->insertAtBack(payload);
-    corruptPacket(packet, packetBER);
+    inet::L3Address destAddress = inet::L3Address(par("broadcastAddress"));
+    corruptPacket(packet, destAddress);
 
-    socket.sendTo(packet, inet::L3Address(par("broadcastAddress")), par("destPort"));
+    socket.sendTo(packet, destAddress, par("destPort"));
 }
 
 void MqttSNApp::sendPingReq(const inet::L3Address& destAddress, const int& destPort, const std::string& clientId)
@@ -130,7 +218,7 @@ void MqttSNApp::sendPingReq(const inet::L3Address& destAddress, const int& destP
 
     inet::Packet* packet = new inet::Packet("PingReqPacket");
     packet->insertAtBack(payload);
-    corruptPacket(packet, packetBER);
+    corruptPacket(packet, destAddress);
 
     socket.sendTo(packet, destAddress, destPort);
 }
@@ -162,7 +250,7 @@ void MqttSNApp::sendBase(const inet::L3Address& destAddress, const int& destPort
 
     inet::Packet* packet = new inet::Packet(packetName.c_str());
     packet->insertAtBack(payload);
-    corruptPacket(packet, packetBER);
+    corruptPacket(packet, destAddress);
 
     socket.sendTo(packet, destAddress, destPort);
 }
@@ -180,7 +268,7 @@ void MqttSNApp::sendDisconnect(const inet::L3Address& destAddress, const int& de
 
     inet::Packet* packet = new inet::Packet("DisconnectPacket");
     packet->insertAtBack(payload);
-    corruptPacket(packet, packetBER);
+    corruptPacket(packet, destAddress);
 
     socket.sendTo(packet, destAddress, destPort);
 }
@@ -191,45 +279,128 @@ bool MqttSNApp::isSelfBroadcastAddress(const inet::L3Address& address)
     return (address == selfBroadcastAddress);
 }
 
-bool MqttSNApp::hasProbabilisticError(inet::b length, double ber)
+bool MqttSNApp::isErrorModelParameter(const std::string& parameterName)
 {
-    // calculate error probability using BER and packet length in bits
-    double errorProbability = 1 - std::pow(1 - ber, length.get());
+    static const std::set<std::string> errorModelParameters = {
+        "errorModel", "packetBER", "goodStateBER", "badStateBER", "goodToBadProbability", "badToGoodProbability", "lossTraceFile"
+    };
 
-    // generate a random number between 0 and 1
-    double rand = uniform(0, 1);
+    return errorModelParameters.count(parameterName) > 0;
+}
+
+BaseErrorModel* MqttSNApp::createErrorModel()
+{
+    std::string model = par("errorModel").stdstringValue();
+
+    if (model == "uniform") {
+        return new UniformErrorModel(getRNG(0), packetBER);
+    }
+
+    if (model == "gilbertElliott") {
+        return new GilbertElliottErrorModel(
+                getRNG(0),
+                par("goodStateBER"),
+                par("badStateBER"),
+                par("goodToBadProbability"),
+                par("badToGoodProbability")
+        );
+    }
+
+    if (model == "trace") {
+        return new TraceErrorModel(getRNG(0), par("lossTraceFile").stdstringValue());
+    }
 
-    // return true if random number is less than error probability, indicating corruption
-    return rand < errorProbability;
+    throw omnetpp::cRuntimeError("Unknown error model: %s", model.c_str());
 }
 
-bool MqttSNApp::setNextAvailableId(const std::set<uint16_t>& usedIds, uint16_t& currentId, bool allowMaxValue)
+void MqttSNApp::initializeTracing()
 {
-    // ID=0 is considered invalid; ID=UINT16_MAX can be considered invalid
-    uint16_t maxValue = allowMaxValue ? UINT16_MAX : UINT16_MAX - 1;
+    std::string traceFile = par("traceFile").stdstringValue();
 
-    // if the set is full, there is no available ID
-    if (usedIds.size() >= maxValue) {
-        return false;
+    // tracing is opt-in; without a trace file no records are kept
+    if (traceFile.empty()) {
+        return;
     }
 
-    // if the set is empty, increment the current ID
-    if (usedIds.empty()) {
-        currentId = (currentId >= maxValue) ? 1 : currentId + 1;
-        return true;
+    int traceBufferSize = par("traceBufferSize");
+    if (traceBufferSize <= 0) {
+        throw omnetpp::cRuntimeError("Parameter traceBufferSize must be positive");
     }
 
-    // reset to one if the current ID is invalid (zero) or exceeds the maximum allowed value
-    if (currentId == 0 || (!allowMaxValue && currentId > maxValue)) {
-        currentId = 1;
+    MessageTracer::open(traceFile, traceBufferSize, par("traceStreaming"));
+    MessageTracer::registerModule(getId(), getFullPath());
+}
+
+void MqttSNApp::initializeJournal()
+{
+    std::string logJournalFile = par("logJournalFile").stdstringValue();
+
+    // without a journal file log events are written as text
+    if (logJournalFile.empty()) {
+        return;
     }
 
-    // find the next available ID
-    while (usedIds.find(currentId) != usedIds.end()) {
-        currentId = (currentId >= maxValue) ? 1 : currentId + 1;
+    EventJournal::open(logJournalFile);
+    EventJournal::registerModule(getId(), getFullPath());
+}
+
+void MqttSNApp::traceMessage(TraceEvent event, unsigned identifier, uint32_t value, QoS qos, bool dup)
+{
+    // messages without an identifier tag cannot be correlated across modules
+    if (!MessageTracer::isEnabled() || identifier == 0) {
+        return;
     }
 
-    return true;
+    MessageTracer::record(event, omnetpp::simTime().inUnit(omnetpp::SIMTIME_NS), identifier, getId(), value, qos, dup);
+}
+
+void MqttSNApp::handleForkEvent()
+{
+    std::string definition = par("forkVariants").stdstringValue();
+
+    // a parameter read only at initialization would be assigned without any effect
+    for (const auto& variant : SimulationFork::parseVariants(definition)) {
+        for (const auto& assignment : variant) {
+            if (!isRefreshedParameter(assignment.first)) {
+                throw omnetpp::cRuntimeError("Fork variant parameter %s is not refreshed after initialization", assignment.first.c_str());
+            }
+        }
+    }
+
+    SimulationFork::fork(definition);
+
+    // the parent continues as the baseline, every child with its own variant
+    const std::map<std::string, std::string>* variant = SimulationFork::getVariant();
+    if (variant != nullptr) {
+        applyForkVariant(*variant);
+    }
+}
+
+void MqttSNApp::applyForkVariant(const std::map<std::string, std::string>& variant)
+{
+    for (const auto& assignment : variant) {
+        // an assignment applies to the modules that have the parameter
+        if (!hasPar(assignment.first.c_str())) {
+            continue;
+        }
+
+        omnetpp::cPar& parameter = par(assignment.first.c_str());
+        parameter.parse(assignment.second.c_str());
+
+        EV_INFO << "Fork variant " << SimulationFork::getVariantIndex() << " sets " << assignment.first << " = "
+                << parameter.str() << std::endl;
+    }
+}
+
+bool MqttSNApp::isRefreshedParameter(const std::string& parameterName)
+{
+    // the parameters read again by handleParameterChange
+    return parameterName == "retransmissionInterval" || parameterName == "retransmissionCounter" || isErrorModelParameter(parameterName);
+}
+
+bool MqttSNApp::setNextAvailableId(const std::set<uint16_t>& usedIds, uint16_t& currentId, bool allowMaxValue)
+{
+    return advanceIdCursor(usedIds.size(), [&usedIds](uint16_t id) { return usedIds.count(id) > 0; }, currentId, allowMaxValue);
 }
 
 uint16_t MqttSNApp::getNewIdentifier(const std::set<uint16_t>& usedIds, uint16_t& currentId, bool allowMaxValue,
@@ -267,9 +438,22 @@ void MqttSNApp::checkTopicLength(uint16_t topicLength, TopicIdType topicIdType)
     }
 }
 
-std::map<std::string, uint16_t> MqttSNApp::getPredefinedTopics()
+const std::map<std::string, uint16_t>* MqttSNApp::getPredefinedTopics()
+{
+    std::string predefinedTopicsJson = par("predefinedTopicsJson").stdstringValue();
+
+    // parse each distinct json definition only once per simulation process
+    auto it = predefinedTopicsRegistry.find(predefinedTopicsJson);
+    if (it == predefinedTopicsRegistry.end()) {
+        it = predefinedTopicsRegistry.emplace(predefinedTopicsJson, parsePredefinedTopics(predefinedTopicsJson)).first;
+    }
+
+    return &it->second;
+}
+
+std::map<std::string, uint16_t> MqttSNApp::parsePredefinedTopics(const std::string& predefinedTopicsJson)
 {
-    json jsonData = json::parse(par("predefinedTopicsJson").stringValue());
+    json jsonData = json::parse(predefinedTopicsJson);
 
     std::set<std::string> topicNames;
     std::set<uint16_t> topicIds;
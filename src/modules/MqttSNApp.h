@@ -21,6 +21,10 @@
 #include "inet/transportlayer/contract/udp/UdpSocket.h"
 #include "types/shared/MsgType.h"
 #include "types/shared/TopicIdType.h"
+#include "types/shared/QoS.h"
+#include "types/shared/TraceEvent.h"
+#include "errormodels/BaseErrorModel.h"
+#include "metrics/HandlerProfiler.h"
 
 extern template class inet::ClockUserModuleMixin<inet::ApplicationBase>;
 
@@ -33,9 +37,17 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
         double retransmissionInterval;
         int retransmissionCounter;
         double packetBER;
+        bool profiling;
+        double forkTime;
 
         // app state
         inet::UdpSocket socket;
+        BaseErrorModel* errorModel = nullptr;
+        HandlerProfiler handlerProfiler;
+        omnetpp::cMessage* forkEvent = nullptr;
+
+        // predefined topic tables shared by all modules, keyed by their json definition
+        static std::map<std::string, std::map<std::string, uint16_t>> predefinedTopicsRegistry;
 
         // metrics attributes
         static unsigned serversRetransmissions;
@@ -45,6 +57,10 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
         virtual int numInitStages() const override { return inet::NUM_INIT_STAGES; }
         virtual void initialize(int stage) override;
 
+        // message handling
+        virtual void handleMessage(omnetpp::cMessage* msg) override;
+        virtual void handleParameterChange(const char* parameterName) override;
+
         // application base
         virtual void finish() override;
         virtual void refreshDisplay() const override;
@@ -57,7 +73,7 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
 
         // packet handling
         virtual void checkPacketIntegrity(const inet::B& receivedLength, const inet::B& fieldLength);
-        virtual void corruptPacket(inet::Packet* packet, double ber);
+        virtual void corruptPacket(inet::Packet* packet, const inet::L3Address& destAddress);
 
         // outgoing packet handling
         virtual void sendGwInfo(uint8_t gatewayId, const std::string& gatewayAddress = "", uint16_t gatewayPort = 0);
@@ -67,7 +83,20 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
 
         // check methods
         virtual bool isSelfBroadcastAddress(const inet::L3Address& address);
-        virtual bool hasProbabilisticError(inet::b length, double ber);
+
+        // error model methods
+        virtual BaseErrorModel* createErrorModel();
+        virtual bool isErrorModelParameter(const std::string& parameterName);
+
+        // tracing methods
+        virtual void initializeTracing();
+        virtual void initializeJournal();
+        virtual void traceMessage(TraceEvent event, unsigned identifier, uint32_t value = 0, QoS qos = QoS::QOS_ZERO, bool dup = false);
+
+        // fork methods
+        virtual void handleForkEvent();
+        virtual void applyForkVariant(const std::map<std::string, std::string>& variant);
+        virtual bool isRefreshedParameter(const std::string& parameterName);
 
         // identifier methods
         virtual bool setNextAvailableId(const std::set<uint16_t>& usedIds, uint16_t& currentId, bool allowMaxValue = true);
@@ -78,7 +107,8 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
         // topic methods
         virtual void checkTopicLength(uint16_t topicLength, TopicIdType topicIdType);
         virtual bool isMinTopicLength(uint16_t topicLength);
-        virtual std::map<std::string, uint16_t> getPredefinedTopics();
+        virtual std::map<std::string, uint16_t> parsePredefinedTopics(const std::string& predefinedTopicsJson);
+        virtual const std::map<std::string, uint16_t>* getPredefinedTopics();
 
         // pure virtual functions
         virtual void levelOneInit() = 0;
@@ -86,7 +116,7 @@ class MqttSNApp : public inet::ClockUserModuleMixin<inet::ApplicationBase>, publ
 
     public:
         MqttSNApp() {};
-        ~MqttSNApp() {};
+        ~MqttSNApp();
 };
 
 } /* namespace mqttsn */
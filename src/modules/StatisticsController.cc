@@ -0,0 +1,245 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "StatisticsController.h"
+#include "modules/client/MqttSNClient.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace mqttsn {
+
+Define_Module(StatisticsController);
+
+omnetpp::simsignal_t StatisticsController::seriesCompleteSignal = registerSignal("replicationSeriesComplete");
+
+void StatisticsController::initialize()
+{
+    sampleInterval = par("sampleInterval");
+    confidenceLevel = par("confidenceLevel");
+    targetRelativeHalfWidth = par("targetRelativeHalfWidth");
+    minSamples = par("minSamples");
+    replicationsFile = par("replicationsFile").stdstringValue();
+    minReplications = par("minReplications");
+
+    int confidenceBatches = par("confidenceBatches");
+    if (confidenceBatches < 2) {
+        throw omnetpp::cRuntimeError("Parameter confidenceBatches must be at least 2");
+    }
+
+    delayEstimator = SteadyStateEstimator(confidenceBatches);
+    hitRateEstimator = SteadyStateEstimator(confidenceBatches);
+
+    delayVector.setName("steadyStateDelay");
+    hitRateVector.setName("steadyStateHitRate");
+
+    seriesComplete = checkReplicationSeries();
+
+    // the run ends right away once the series already has enough replications
+    if (seriesComplete) {
+        seriesCompleteEvent = new omnetpp::cMessage("seriesCompleteTimer");
+        scheduleAt(omnetpp::simTime(), seriesCompleteEvent);
+        return;
+    }
+
+    sampleEvent = new omnetpp::cMessage("sampleTimer");
+    scheduleAt(omnetpp::simTime() + sampleInterval, sampleEvent);
+}
+
+void StatisticsController::finish()
+{
+    if (seriesComplete) {
+        recordScalar("replicationSkipped", 1);
+        return;
+    }
+
+    recordScalar("delayWarmupTime", getWarmupTime(delayEstimator, delaySampleTimes));
+    recordScalar("delayMean", delayEstimator.getMean());
+    recordScalar("delayHalfWidth", delayEstimator.getHalfWidth(confidenceLevel));
+
+    recordScalar("hitRateWarmupTime", getWarmupTime(hitRateEstimator, hitRateSampleTimes));
+    recordScalar("hitRateMean", hitRateEstimator.getMean());
+    recordScalar("hitRateHalfWidth", hitRateEstimator.getHalfWidth(confidenceLevel));
+
+    recordScalar("stoppedEarly", stoppedEarly);
+
+    appendReplication();
+}
+
+void StatisticsController::handleMessage(omnetpp::cMessage* msg)
+{
+    if (msg == sampleEvent) {
+        handleSampleEvent();
+    }
+    else if (msg == seriesCompleteEvent) {
+        EV << "Replication series complete, skipping the run" << std::endl;
+
+        // lets the applications leave the skipped run out of their results
+        emit(seriesCompleteSignal, true);
+        endSimulation();
+    }
+    else {
+        throw omnetpp::cRuntimeError("Unknown message: %s", msg->getName());
+    }
+}
+
+void StatisticsController::handleSampleEvent()
+{
+    double sumDelay = MqttSNClient::getSumReceivedPublishMsgTimestamps();
+    unsigned receivedTotal = MqttSNClient::getReceivedTotalPublishMsgs();
+    unsigned sentUnique = MqttSNClient::getSentUniquePublishMsgs();
+    unsigned receivedUnique = MqttSNClient::getReceivedUniquePublishMsgs();
+
+    // the observations are the interval averages; intervals without traffic are skipped
+    if (receivedTotal > lastReceivedTotal) {
+        double delay = (sumDelay - lastSumDelay) / (receivedTotal - lastReceivedTotal);
+
+        delayEstimator.record(delay);
+        delaySampleTimes.push_back(omnetpp::simTime());
+        delayVector.record(delay);
+    }
+
+    if (sentUnique > lastSentUnique) {
+        double hitRate = static_cast<double>(receivedUnique - lastReceivedUnique) / (sentUnique - lastSentUnique) * 100;
+
+        hitRateEstimator.record(hitRate);
+        hitRateSampleTimes.push_back(omnetpp::simTime());
+        hitRateVector.record(hitRate);
+    }
+
+    lastSumDelay = sumDelay;
+    lastReceivedTotal = receivedTotal;
+    lastSentUnique = sentUnique;
+    lastReceivedUnique = receivedUnique;
+
+    if (isPrecise(delayEstimator) && isPrecise(hitRateEstimator)) {
+        EV << "Target precision reached after " << delayEstimator.getCount() << " samples, ending the run" << std::endl;
+
+        stoppedEarly = true;
+        endSimulation();
+    }
+
+    scheduleAt(omnetpp::simTime() + sampleInterval, sampleEvent);
+}
+
+bool StatisticsController::isPrecise(const SteadyStateEstimator& estimator)
+{
+    // 0 disables stopping the run
+    if (targetRelativeHalfWidth <= 0 || estimator.getCount() < (size_t) minSamples) {
+        return false;
+    }
+
+    double mean = estimator.getMean();
+    double halfWidth = estimator.getHalfWidth(confidenceLevel);
+
+    return std::isfinite(halfWidth) && mean != 0 && halfWidth / std::abs(mean) <= targetRelativeHalfWidth;
+}
+
+omnetpp::simtime_t StatisticsController::getWarmupTime(const SteadyStateEstimator& estimator,
+                                                       const std::vector<omnetpp::simtime_t>& sampleTimes)
+{
+    long warmupLength = estimator.getWarmupLength();
+
+    // -1 while the series is still in its transient
+    if (warmupLength < 0) {
+        return -1;
+    }
+
+    return warmupLength == 0 ? omnetpp::SIMTIME_ZERO : sampleTimes[warmupLength - 1];
+}
+
+bool StatisticsController::checkReplicationSeries()
+{
+    if (replicationsFile.empty() || targetRelativeHalfWidth <= 0) {
+        return false;
+    }
+
+    std::ifstream file(replicationsFile);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // one line per finished replication with its steady state delay and hit rate means
+    std::vector<double> delays;
+    std::vector<double> hitRates;
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream values(line);
+        double delay;
+        double hitRate;
+        char separator;
+
+        if (values >> delay >> separator >> hitRate) {
+            delays.push_back(delay);
+            hitRates.push_back(hitRate);
+        }
+    }
+
+    if ((int) delays.size() < std::max(minReplications, 2)) {
+        return false;
+    }
+
+    // the replication means are independent, so the interval follows from their sample variance
+    auto isSeriesPrecise = [this](const std::vector<double>& means) {
+        double mean = 0;
+        for (double value : means) {
+            mean += value / means.size();
+        }
+
+        double variance = 0;
+        for (double value : means) {
+            variance += (value - mean) * (value - mean) / (means.size() - 1);
+        }
+
+        double halfWidth = SteadyStateEstimator::getStudentQuantile(confidenceLevel, means.size() - 1) * std::sqrt(variance / means.size());
+
+        return mean != 0 && halfWidth / std::abs(mean) <= targetRelativeHalfWidth;
+    };
+
+    return isSeriesPrecise(delays) && isSeriesPrecise(hitRates);
+}
+
+void StatisticsController::appendReplication()
+{
+    if (replicationsFile.empty()) {
+        return;
+    }
+
+    double delayMean = delayEstimator.getMean();
+    double hitRateMean = hitRateEstimator.getMean();
+
+    // a run that never left its transient does not count as a replication
+    if (!std::isfinite(delayMean) || !std::isfinite(hitRateMean)) {
+        EV_WARN << "No steady state detected, the run is not added to the replication series" << std::endl;
+        return;
+    }
+
+    // one append of the whole line, so runs sharing the file do not interleave
+    std::ostringstream line;
+    line << delayMean << "," << hitRateMean << "\n";
+
+    std::ofstream file(replicationsFile, std::ios::app);
+    file << line.str() << std::flush;
+}
+
+StatisticsController::~StatisticsController()
+{
+    cancelAndDelete(sampleEvent);
+    cancelAndDelete(seriesCompleteEvent);
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,86 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef MODULES_STATISTICSCONTROLLER_H_
+#define MODULES_STATISTICSCONTROLLER_H_
+
+#include "metrics/SteadyStateEstimator.h"
+#include <omnetpp.h>
+
+namespace mqttsn {
+
+class StatisticsController : public omnetpp::cSimpleModule
+{
+    protected:
+        // parameters
+        double sampleInterval;
+        double confidenceLevel;
+        double targetRelativeHalfWidth;
+        int minSamples;
+        std::string replicationsFile;
+        int minReplications;
+
+        // controller state
+        omnetpp::cMessage* sampleEvent = nullptr;
+        omnetpp::cMessage* seriesCompleteEvent = nullptr;
+
+        double lastSumDelay = 0;
+        unsigned lastReceivedTotal = 0;
+        unsigned lastSentUnique = 0;
+        unsigned lastReceivedUnique = 0;
+
+        // observations, one per sample interval with traffic
+        SteadyStateEstimator delayEstimator;
+        SteadyStateEstimator hitRateEstimator;
+        std::vector<omnetpp::simtime_t> delaySampleTimes;
+        std::vector<omnetpp::simtime_t> hitRateSampleTimes;
+
+        bool stoppedEarly = false;
+        bool seriesComplete = false;
+
+        // signals
+        static omnetpp::simsignal_t seriesCompleteSignal;
+
+        // metrics attributes
+        omnetpp::cOutVector delayVector;
+        omnetpp::cOutVector hitRateVector;
+
+    protected:
+        // initialization
+        virtual void initialize() override;
+        virtual void finish() override;
+
+        // message handling
+        virtual void handleMessage(omnetpp::cMessage* msg) override;
+
+        // event handlers
+        virtual void handleSampleEvent();
+
+        // run stopping
+        virtual bool isPrecise(const SteadyStateEstimator& estimator);
+        virtual omnetpp::simtime_t getWarmupTime(const SteadyStateEstimator& estimator, const std::vector<omnetpp::simtime_t>& sampleTimes);
+
+        // replication series
+        virtual bool checkReplicationSeries();
+        virtual void appendReplication();
+
+    public:
+        StatisticsController() {};
+        ~StatisticsController();
+};
+
+} /* namespace mqttsn */
+
+#endif /* MODULES_STATISTICSCONTROLLER_H_ */
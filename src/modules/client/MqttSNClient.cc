@@ -18,6 +18,9 @@
 #include "inet/networklayer/common/L3AddressTag_m.h"
 #include "inet/transportlayer/common/L4PortTag_m.h"
 #include "helpers/StringHelper.h"
+#include "helpers/ConversionHelper.h"
+#include "logging/Logging.h"
+#include "snapshot/SimulationFork.h"
 #include "types/shared/Length.h"
 #include "messages/MqttSNAdvertise.h"
 #include "messages/MqttSNSearchGw.h"
@@ -31,18 +34,31 @@ namespace mqttsn {
 
 const std::string MqttSNClient::TOPIC_DELIMITER = "-";
 
+omnetpp::simsignal_t MqttSNClient::seriesCompleteSignal = registerSignal("replicationSeriesComplete");
+
 double MqttSNClient::sumReceivedPublishMsgTimestamps;
 unsigned MqttSNClient::receivedTotalPublishMsgs;
 
 unsigned MqttSNClient::sentUniquePublishMsgs = 0;
 unsigned MqttSNClient::receivedUniquePublishMsgs = 0;
 unsigned MqttSNClient::receivedDuplicatePublishMsgs = 0;
+unsigned MqttSNClient::receivedLatePublishMsgs = 0;
+unsigned MqttSNClient::droppedPublishMsgs = 0;
+
+LatencyHistogram MqttSNClient::publishLatencyHistogram;
+std::map<std::string, LatencyHistogram> MqttSNClient::topicLatencyHistograms;
+std::map<int, LatencyHistogram> MqttSNClient::qosLatencyHistograms;
+std::map<std::pair<Stage, Stage>, LatencyHistogram> MqttSNClient::stageLatencyHistograms;
 
 unsigned MqttSNClient::publishersRetransmissions = 0;
 unsigned MqttSNClient::subscribersRetransmissions = 0;
 
+std::map<std::string, std::vector<std::streampos>> MqttSNClient::itemsFileOffsets;
+
 void MqttSNClient::levelOneInit()
 {
+    getSimulation()->getSystemModule()->subscribe(seriesCompleteSignal, this);
+
     stateChangeEvent = new inet::ClockEvent("stateChangeTimer");
     currentState = ClientState::DISCONNECTED;
 
@@ -77,6 +93,13 @@ void MqttSNClient::levelOneInit()
     sentUniquePublishMsgs = 0;
     receivedUniquePublishMsgs = 0;
     receivedDuplicatePublishMsgs = 0;
+    receivedLatePublishMsgs = 0;
+    droppedPublishMsgs = 0;
+
+    publishLatencyHistogram.clear();
+    topicLatencyHistograms.clear();
+    qosLatencyHistograms.clear();
+    stageLatencyHistograms.clear();
 
     publishersRetransmissions = 0;
     subscribersRetransmissions = 0;
@@ -88,9 +111,18 @@ void MqttSNClient::finish()
 {
     handleFinalSimulationResults();
 
+    getSimulation()->getSystemModule()->unsubscribe(seriesCompleteSignal, this);
+
     MqttSNApp::finish();
 }
 
+void MqttSNClient::receiveSignal(omnetpp::cComponent* source, omnetpp::simsignal_t signalID, bool value, omnetpp::cObject* details)
+{
+    if (signalID == seriesCompleteSignal) {
+        seriesComplete = value;
+    }
+}
+
 void MqttSNClient::handleStartOperation(inet::LifecycleOperation* operation)
 {
     MqttSNApp::socketConfiguration();
@@ -172,7 +204,7 @@ void MqttSNClient::handleStateChangeEvent()
 void MqttSNClient::updateCurrentState(ClientState nextState)
 {
     currentState = nextState;
-    EV << "Current client state: " << getClientStateAsString() << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::CLIENT_STATE_CHANGED, currentState, 0, "Current client state: " << getClientStateAsString());
 }
 
 void MqttSNClient::returnToSleep()
@@ -515,7 +547,8 @@ void MqttSNClient::processPacket(inet::Packet* pk)
         }
     }
 
-    EV << "Client received packet: " << inet::UdpSocket::getReceivedPacketInfo(pk) << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::PACKET_RECEIVED, msgType, pk->getByteLength(),
+                    "Client received packet: " << inet::UdpSocket::getReceivedPacketInfo(pk));
 
     int srcPort = pk->getTag<inet::L4PortInd>()->getSrcPort();
 
@@ -659,9 +692,8 @@ void MqttSNClient::processConnAck(inet::Packet* pk)
     cancelEvent(pingEvent);
     scheduleClockEventAfter(keepAlive, pingEvent);
 
-    std::ostringstream str;
-    str << "Client connected to: " << selectedGateway.address.str() << ":" << selectedGateway.port;
-    EV << str.str() << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::CLIENT_CONNECTED, selectedGateway.port, 0,
+                    "Client connected to: " << selectedGateway.address.str() << ":" << selectedGateway.port);
 
     processConnAckCustom();
 }
@@ -679,7 +711,7 @@ void MqttSNClient::processPingResp(const inet::L3Address& srcAddress, const int&
         return;
     }
 
-    EV << "Received ping response from server: " << srcAddress << ":" << srcPort << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::PING_RESPONSE_RECEIVED, srcPort, 0, "Received ping response from server: " << srcAddress << ":" << srcPort);
     unscheduleMsgRetransmission(MsgType::PINGREQ);
 }
 
@@ -728,9 +760,10 @@ void MqttSNClient::sendSearchGw()
 
     inet::Packet* packet = new inet::Packet("SearchGwPacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    inet::L3Address destAddress = inet::L3Address(par("broadcastAddress"));
+    MqttSNApp::corruptPacket(packet, destAddress);
 
-    MqttSNApp::socket.sendTo(packet, inet::L3Address(par("broadcastAddress")), par("destPort"));
+    MqttSNApp::socket.sendTo(packet, destAddress, par("destPort"));
 }
 
 void MqttSNClient::sendConnect(const inet::L3Address& destAddress, const int& destPort, bool willFlag, bool cleanSessionFlag, uint16_t duration)
@@ -745,7 +778,7 @@ void MqttSNClient::sendConnect(const inet::L3Address& destAddress, const int& de
 
     inet::Packet* packet = new inet::Packet("ConnectPacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -986,28 +1019,101 @@ void MqttSNClient::checkTopicConsistency(const std::string& topicName, TopicIdTy
 uint16_t MqttSNClient::getPredefinedTopicId(const std::string& topicName)
 {
     // check if the predefined topic exists
-    auto predefinedTopicsIt = predefinedTopics.find(StringHelper::base64Encode(topicName));
-    if (predefinedTopicsIt == predefinedTopics.end()) {
+    auto predefinedTopicsIt = predefinedTopics->find(StringHelper::base64Encode(topicName));
+    if (predefinedTopicsIt == predefinedTopics->end()) {
         throw omnetpp::cRuntimeError("Predefined topic '%s' is not defined", topicName.c_str());
     }
 
     return predefinedTopicsIt->second;
 }
 
+std::string MqttSNClient::getItemsJson()
+{
+    std::string itemsFile = par("itemsFile").stdstringValue();
+
+    // inline json string takes effect when no items file is given
+    if (itemsFile.empty()) {
+        std::string itemsJson = par("itemsJson").stdstringValue();
+
+        if (itemsJson.empty()) {
+            throw omnetpp::cRuntimeError("Either itemsJson or itemsFile must be specified");
+        }
+
+        return itemsJson;
+    }
+
+    // client hosts are scalar submodules, so every module selects its line explicitly
+    int itemsIndex = par("itemsIndex");
+    if (itemsIndex < 0) {
+        throw omnetpp::cRuntimeError("itemsIndex must be set when itemsFile is specified");
+    }
+
+    const std::vector<std::streampos>& offsets = getItemsFileOffsets(itemsFile);
+
+    if ((size_t) itemsIndex >= offsets.size()) {
+        throw omnetpp::cRuntimeError("Items index %d is out of range in items file %s (%zu lines)", itemsIndex, itemsFile.c_str(),
+                                     offsets.size());
+    }
+
+    // read only the selected line
+    std::ifstream file(itemsFile);
+    file.seekg(offsets[itemsIndex]);
+
+    std::string line;
+    std::getline(file, line);
+
+    return line;
+}
+
+const std::vector<std::streampos>& MqttSNClient::getItemsFileOffsets(const std::string& itemsFile)
+{
+    auto it = itemsFileOffsets.find(itemsFile);
+    if (it != itemsFileOffsets.end()) {
+        return it->second;
+    }
+
+    std::ifstream file(itemsFile);
+    if (!file.is_open()) {
+        throw omnetpp::cRuntimeError("Unable to open items file: %s", itemsFile.c_str());
+    }
+
+    // scan the file once, recording where each non-empty line starts
+    std::vector<std::streampos> offsets;
+    std::string line;
+
+    std::streampos offset = file.tellg();
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            offsets.push_back(offset);
+        }
+
+        offset = file.tellg();
+    }
+
+    return itemsFileOffsets.emplace(itemsFile, std::move(offsets)).first->second;
+}
+
 void MqttSNClient::handleFinalSimulationResults()
 {
     static bool resultsProcessed = false;
 
+    // a run skipped by the completed replication series has no results
+    if (seriesComplete) {
+        return;
+    }
+
     if (!resultsProcessed) {
         std::cout << "==== Publish Messages Results ====" << std::endl;
 
         // compute and print the results
         printStatistics();
         computePublishEndToEndDelay();
+        computeStageBreakdown();
         computePublishHitRate();
 
-        // save results
-        appendSimulationResultsToCsv("results/results.csv");
+        // save results; the files are opened after a fork, so every variant gets its own
+        appendSimulationResultsToCsv(SimulationFork::getVariantFileName(par("resultsFile").stdstringValue()));
+        appendLatencyResultsToCsv(SimulationFork::getVariantFileName(par("latencyResultsFile").stdstringValue()));
 
         resultsProcessed = true;
     }
@@ -1019,6 +1125,8 @@ void MqttSNClient::printStatistics()
     std::cout << "Unique received: " << receivedUniquePublishMsgs << std::endl;
     std::cout << "Total received: " << receivedTotalPublishMsgs << std::endl;
     std::cout << "Total received duplicates: " << receivedDuplicatePublishMsgs << std::endl;
+    std::cout << "Received behind the identifier window: " << receivedLatePublishMsgs << std::endl;
+    std::cout << "Dropped before sending: " << droppedPublishMsgs << std::endl;
     std::cout << std::endl;
 }
 
@@ -1026,12 +1134,82 @@ void MqttSNClient::computePublishEndToEndDelay()
 {
     if (receivedTotalPublishMsgs > 0) {
         std::cout << "Average end-to-end delay: " << sumReceivedPublishMsgTimestamps / receivedTotalPublishMsgs << " seconds" << std::endl;
+
+        // tail latency overall, per QoS level and per topic
+        printLatencyPercentiles("All", publishLatencyHistogram);
+
+        for (const auto& pair : qosLatencyHistograms) {
+            printLatencyPercentiles("QoS " + std::to_string(pair.first), pair.second);
+        }
+
+        for (const auto& pair : topicLatencyHistograms) {
+            printLatencyPercentiles("Topic " + pair.first, pair.second);
+        }
+
         return;
     }
 
     std::cout << "No publish messages received to calculate average delay" << std::endl;
 }
 
+void MqttSNClient::printLatencyPercentiles(const std::string& label, const LatencyHistogram& histogram)
+{
+    std::cout << label << " end-to-end delay (seconds) -"
+              << " p50: " << histogram.getPercentile(50)
+              << ", p90: " << histogram.getPercentile(90)
+              << ", p99: " << histogram.getPercentile(99)
+              << ", p99.9: " << histogram.getPercentile(99.9)
+              << ", max: " << histogram.getMax()
+              << " (" << histogram.getCount() << " messages)" << std::endl;
+}
+
+void MqttSNClient::recordStageLatencies(const TagInfo& tagInfo)
+{
+    const auto& timestamps = tagInfo.stageTimestamps;
+    int previousStage = -1;
+
+    // each segment spans from the previous stamped stage to the next one; stages that were skipped are not stamped
+    for (int stage = 0; stage < Stage::STAGE_COUNT; stage++) {
+        if (timestamps[stage] == 0) {
+            continue;
+        }
+
+        if (previousStage >= 0) {
+            std::pair<Stage, Stage> segment = std::make_pair((Stage) previousStage, (Stage) stage);
+            stageLatencyHistograms[segment].record((timestamps[stage] - timestamps[previousStage]).dbl());
+        }
+
+        previousStage = stage;
+    }
+}
+
+void MqttSNClient::computeStageBreakdown()
+{
+    if (stageLatencyHistograms.empty()) {
+        return;
+    }
+
+    // total time spent over all segments, to compute the share of each one
+    double totalTime = 0;
+    for (const auto& pair : stageLatencyHistograms) {
+        totalTime += pair.second.getMean() * pair.second.getCount();
+    }
+
+    // gatewayBuffered -> gatewayDispatched covers requests waiting for the subscriber and the requests check polling
+    std::cout << std::endl << "End-to-end delay breakdown by stage:" << std::endl;
+
+    for (const auto& pair : stageLatencyHistograms) {
+        const LatencyHistogram& histogram = pair.second;
+        double share = totalTime > 0 ? histogram.getMean() * histogram.getCount() / totalTime * 100 : 0;
+
+        std::cout << ConversionHelper::stageToString(pair.first.first) << " -> " << ConversionHelper::stageToString(pair.first.second)
+                  << ": mean " << histogram.getMean() << " s, p99 " << histogram.getPercentile(99) << " s, max " << histogram.getMax()
+                  << " s, share " << share << " % (" << histogram.getCount() << " messages)" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
 void MqttSNClient::computePublishHitRate()
 {
     if (sentUniquePublishMsgs > 0) {
@@ -1072,6 +1250,46 @@ void MqttSNClient::appendSimulationResultsToCsv(const std::string& filePath)
     outfile.close();
 }
 
+void MqttSNClient::appendLatencyResultsToCsv(const std::string& filePath)
+{
+    // check if the CSV file already exists
+    std::ifstream infile(filePath);
+    bool fileExists = infile.good();
+    infile.close();
+
+    // open the CSV file in append mode
+    std::ofstream outfile(filePath, std::ios::app);
+
+    // if the file does not exist, write the column headers
+    if (!fileExists) {
+        outfile << "BER,Scope,Count,Mean,P50,P90,P99,P99.9,Max\n";
+    }
+
+    appendLatencyRowToCsv(outfile, "all", publishLatencyHistogram);
+
+    for (const auto& pair : qosLatencyHistograms) {
+        appendLatencyRowToCsv(outfile, "qos:" + std::to_string(pair.first), pair.second);
+    }
+
+    for (const auto& pair : topicLatencyHistograms) {
+        appendLatencyRowToCsv(outfile, "topic:" + pair.first, pair.second);
+    }
+
+    for (const auto& pair : stageLatencyHistograms) {
+        appendLatencyRowToCsv(outfile, "stage:" + ConversionHelper::stageToString(pair.first.first) + "->" +
+                              ConversionHelper::stageToString(pair.first.second), pair.second);
+    }
+
+    outfile.close();
+}
+
+void MqttSNClient::appendLatencyRowToCsv(std::ofstream& outfile, const std::string& scope, const LatencyHistogram& histogram)
+{
+    outfile << MqttSNApp::packetBER << "," << scope << "," << histogram.getCount() << "," << histogram.getMean() << ","
+            << histogram.getPercentile(50) << "," << histogram.getPercentile(90) << "," << histogram.getPercentile(99) << ","
+            << histogram.getPercentile(99.9) << "," << histogram.getMax() << "\n";
+}
+
 void MqttSNClient::scheduleMsgRetransmission(const inet::L3Address& destAddress, const int& destPort, MsgType msgType,
                                              std::map<std::string, std::string>* parameters)
 {
@@ -21,10 +21,13 @@
 #include "types/shared/MsgType.h"
 #include "types/client/GatewayInfo.h"
 #include "types/client/RetransmissionInfo.h"
+#include "types/shared/TagInfo.h"
+#include "metrics/LatencyHistogram.h"
+#include <fstream>
 
 namespace mqttsn {
 
-class MqttSNClient : public MqttSNApp
+class MqttSNClient : public MqttSNApp, public omnetpp::cListener
 {
     protected:
         // constants
@@ -66,11 +69,18 @@ class MqttSNClient : public MqttSNApp
 
         uint16_t currentMsgId = 0;
 
-        std::map<std::string, uint16_t> predefinedTopics;
+        const std::map<std::string, uint16_t>* predefinedTopics = nullptr;
 
         // retransmission management
         std::map<MsgType, RetransmissionInfo> retransmissions;
 
+        // set when the replication series is already complete and the run is skipped
+        static omnetpp::simsignal_t seriesCompleteSignal;
+        bool seriesComplete = false;
+
+        // line offsets of each items file, indexed once and shared by all modules
+        static std::map<std::string, std::vector<std::streampos>> itemsFileOffsets;
+
         // metrics attributes
         static double sumReceivedPublishMsgTimestamps;
         static unsigned receivedTotalPublishMsgs;
@@ -78,6 +88,13 @@ class MqttSNClient : public MqttSNApp
         static unsigned sentUniquePublishMsgs;
         static unsigned receivedUniquePublishMsgs;
         static unsigned receivedDuplicatePublishMsgs;
+        static unsigned receivedLatePublishMsgs; // neither unique nor duplicate, see identifierWindowSize
+        static unsigned droppedPublishMsgs;
+
+        static LatencyHistogram publishLatencyHistogram;
+        static std::map<std::string, LatencyHistogram> topicLatencyHistograms;
+        static std::map<int, LatencyHistogram> qosLatencyHistograms;
+        static std::map<std::pair<Stage, Stage>, LatencyHistogram> stageLatencyHistograms;
 
         static unsigned publishersRetransmissions;
         static unsigned subscribersRetransmissions;
@@ -89,6 +106,9 @@ class MqttSNClient : public MqttSNApp
         // application base
         virtual void finish() override;
 
+        // signal handling
+        virtual void receiveSignal(omnetpp::cComponent* source, omnetpp::simsignal_t signalID, bool value, omnetpp::cObject* details) override;
+
         // lifecycle
         virtual void handleStartOperation(inet::LifecycleOperation* operation) override;
         virtual void handleStopOperation(inet::LifecycleOperation* operation) override;
@@ -165,12 +185,21 @@ class MqttSNClient : public MqttSNApp
         virtual void checkTopicConsistency(const std::string& topicName, TopicIdType topicIdType, bool isFound);
         virtual uint16_t getPredefinedTopicId(const std::string& topicName);
 
+        // item methods
+        virtual std::string getItemsJson();
+        virtual const std::vector<std::streampos>& getItemsFileOffsets(const std::string& itemsFile);
+
         // result handling
         virtual void handleFinalSimulationResults();
         virtual void printStatistics();
         virtual void computePublishEndToEndDelay();
+        virtual void printLatencyPercentiles(const std::string& label, const LatencyHistogram& histogram);
+        virtual void recordStageLatencies(const TagInfo& tagInfo);
+        virtual void computeStageBreakdown();
         virtual void computePublishHitRate();
         virtual void appendSimulationResultsToCsv(const std::string& filePath);
+        virtual void appendLatencyResultsToCsv(const std::string& filePath);
+        virtual void appendLatencyRowToCsv(std::ofstream& outfile, const std::string& scope, const LatencyHistogram& histogram);
 
         // retransmission management
         virtual void scheduleMsgRetransmission(const inet::L3Address& destAddress, const int& destPort, MsgType msgType,
@@ -205,6 +234,12 @@ class MqttSNClient : public MqttSNApp
     public:
         MqttSNClient() {};
         ~MqttSNClient();
+
+        // publish metrics shared by all clients
+        static double getSumReceivedPublishMsgTimestamps() { return sumReceivedPublishMsgTimestamps; }
+        static unsigned getReceivedTotalPublishMsgs() { return receivedTotalPublishMsgs; }
+        static unsigned getSentUniquePublishMsgs() { return sentUniquePublishMsgs; }
+        static unsigned getReceivedUniquePublishMsgs() { return receivedUniquePublishMsgs; }
 };
 
 } /* namespace mqttsn */
@@ -20,11 +20,16 @@
 #include "helpers/StringHelper.h"
 #include "helpers/PacketHelper.h"
 #include "helpers/NumericHelper.h"
+#include "logging/Logging.h"
 #include "messages/MqttSNBaseWithWillTopic.h"
 #include "messages/MqttSNBaseWithWillMsg.h"
 #include "messages/MqttSNBaseWithReturnCode.h"
 #include "messages/MqttSNMsgIdWithTopicIdPlus.h"
 #include "messages/MqttSNBaseWithMsgId.h"
+#include "workloads/PeriodicArrivalProcess.h"
+#include "workloads/PoissonArrivalProcess.h"
+#include "workloads/OnOffArrivalProcess.h"
+#include "workloads/TraceArrivalProcess.h"
 
 namespace mqttsn {
 
@@ -49,6 +54,12 @@ void MqttSNPublisher::levelTwoInit()
     publishInterval = par("publishInterval");
     publishEvent = new inet::ClockEvent("publishTimer");
 
+    publishQueueLimit = par("publishQueueLimit");
+    arrivalEvent = new inet::ClockEvent("arrivalTimer");
+
+    delete arrivalProcess;
+    arrivalProcess = createArrivalProcess();
+
     publishMinusOneInterval = par("publishMinusOneInterval");
     publishMinusOneEvent = new inet::ClockEvent("publishMinusOneTimer");
 
@@ -66,6 +77,9 @@ bool MqttSNPublisher::handleMessageWhenUpCustom(omnetpp::cMessage* msg)
     else if (msg == publishMinusOneEvent) {
         handlePublishMinusOneEvent();
     }
+    else if (msg == arrivalEvent) {
+        handleArrivalEvent();
+    }
     else {
         return false;
     }
@@ -83,6 +97,11 @@ void MqttSNPublisher::scheduleActiveStateEventsCustom()
     // reset registration counter
     registrationCounter = 0;
 
+    // reset workload state
+    publishInFlight = false;
+    publishAwaitsRegistration = false;
+    publishQueue.clear();
+
     // reset and initialize topics
     resetAndPopulateTopics();
 
@@ -96,6 +115,7 @@ void MqttSNPublisher::cancelActiveStateEventsCustom()
     cancelEvent(registrationEvent);
     cancelEvent(publishEvent);
     cancelEvent(publishMinusOneEvent);
+    cancelEvent(arrivalEvent);
 }
 
 void MqttSNPublisher::cancelActiveStateClockEventsCustom()
@@ -103,6 +123,7 @@ void MqttSNPublisher::cancelActiveStateClockEventsCustom()
     cancelClockEvent(registrationEvent);
     cancelClockEvent(publishEvent);
     cancelClockEvent(publishMinusOneEvent);
+    cancelClockEvent(arrivalEvent);
 }
 
 void MqttSNPublisher::processPacketCustom(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType)
@@ -173,7 +194,15 @@ void MqttSNPublisher::processPacketCustom(inet::Packet* pk, const inet::L3Addres
 void MqttSNPublisher::processConnAckCustom()
 {
     scheduleClockEventAfter(registrationInterval, registrationEvent);
-    scheduleClockEventAfter(publishInterval, publishEvent);
+
+    if (arrivalProcess == nullptr) {
+        scheduleClockEventAfter(publishInterval, publishEvent);
+        return;
+    }
+
+    if (!arrivalEvent->isScheduled()) {
+        scheduleNextArrival();
+    }
 }
 
 void MqttSNPublisher::processWillTopicReq(const inet::L3Address& srcAddress, const int& srcPort)
@@ -223,6 +252,13 @@ void MqttSNPublisher::processRegAck(inet::Packet* pk)
     if (returnCode == ReturnCode::REJECTED_NOT_SUPPORTED) {
         lastRegistration.retry = false;
         scheduleClockEventAfter(MqttSNClient::waitingInterval, registrationEvent);
+
+        // the topic of the rejected PUBLISH cannot be registered again, so the PUBLISH is given up
+        if (publishAwaitsRegistration && lastPublish.topicName == lastRegistration.topicName) {
+            publishAwaitsRegistration = false;
+            lastPublish.retry = false;
+            scheduleNextPublish();
+        }
         return;
     }
 
@@ -244,6 +280,13 @@ void MqttSNPublisher::processRegAck(inet::Packet* pk)
 
     registrationCounter++;
 
+    // the PUBLISH rejected for an evicted topic goes out again under the new topic ID
+    if (publishAwaitsRegistration && lastPublish.topicName == lastRegistration.topicName) {
+        publishAwaitsRegistration = false;
+        lastPublish.topicId = topicId;
+        retryLastPublish();
+    }
+
     EV << "Registration completed - Topic Name: " << lastRegistration.topicName << ", Topic ID: " << topicId << std::endl;
 }
 
@@ -265,18 +308,53 @@ void MqttSNPublisher::processPubAck(inet::Packet* pk)
     ReturnCode returnCode = payload->getReturnCode();
 
     if (returnCode == ReturnCode::REJECTED_INVALID_TOPIC_ID) {
-        // update registration information
-        lastRegistration.topicName = lastPublish.topicName;
-        lastRegistration.itemInfo = lastPublish.itemInfo;
-        lastRegistration.retry = true;
+        // a QoS 0 rejection may arrive after the next PUBLISH, so the topic is taken from the PUBACK
+        uint16_t rejectedTopicId = payload->getTopicId();
+        auto topicIterator = topics.find(rejectedTopicId);
+
+        // an earlier rejection of the same topic already forgot it and registers it again
+        if (topicIterator != topics.end()) {
+            // update registration information
+            lastRegistration.topicName = topicIterator->second.topicName;
+            lastRegistration.itemInfo = topicIterator->second.itemInfo;
+            lastRegistration.retry = true;
+
+            MqttSNClient::unscheduleMsgRetransmission(MsgType::REGISTER);
+            cancelEvent(registrationEvent);
+
+            // retry topic registration
+            scheduleClockEventAfter(MqttSNClient::MIN_WAITING_TIME, registrationEvent);
+
+            // predefined topic IDs cannot change; retry as is
+            if (topicIterator->second.itemInfo->topicIdType == TopicIdType::PRE_DEFINED_TOPIC_ID) {
+                retryLastPublish();
+                return;
+            }
 
-        MqttSNClient::unscheduleMsgRetransmission(MsgType::REGISTER);
-        cancelEvent(registrationEvent);
+            // the gateway evicted the topic, so its ID is stale and must not be picked again
+            topics.erase(topicIterator);
+        }
 
-        // retry topic registration
-        scheduleClockEventAfter(MqttSNClient::MIN_WAITING_TIME, registrationEvent);
+        // QoS 0 publications are not retried
+        if (qos == QoS::QOS_ZERO || lastPublish.topicId != rejectedTopicId) {
+            return;
+        }
 
-        retryLastPublish();
+        lastPublish.retry = true;
+        publishInFlight = false;
+        cancelEvent(publishEvent);
+
+        // the topic may already be registered again under a new ID
+        for (const auto& topic : topics) {
+            if (topic.second.topicName == lastPublish.topicName) {
+                lastPublish.topicId = topic.first;
+                retryLastPublish();
+                return;
+            }
+        }
+
+        // otherwise the PUBLISH is held until the REGACK gives the new topic ID
+        publishAwaitsRegistration = true;
         return;
     }
 
@@ -290,8 +368,11 @@ void MqttSNPublisher::processPubAck(inet::Packet* pk)
     }
 
     // handle operations when PUBLISH is ACCEPTED
+    MqttSNApp::traceMessage(TraceEvent::PUBLISHER_ACK, lastPublish.tagInfo.identifier, payload->getMsgId(), qos);
+
     lastPublish.retry = false;
-    scheduleClockEventAfter(publishInterval, publishEvent);
+    publishInFlight = false;
+    scheduleNextPublish();
 }
 
 void MqttSNPublisher::processPubRec(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
@@ -304,6 +385,8 @@ void MqttSNPublisher::processPubRec(inet::Packet* pk, const inet::L3Address& src
         return;
     }
 
+    MqttSNApp::traceMessage(TraceEvent::PUBLISHER_PUBREC, lastPublish.tagInfo.identifier, msgId, QoS::QOS_TWO);
+
     // send PUBlish RELease
     sendBaseWithMsgId(srcAddress, srcPort, MsgType::PUBREL, msgId);
 
@@ -320,9 +403,12 @@ void MqttSNPublisher::processPubComp(inet::Packet* pk)
         return;
     }
 
+    MqttSNApp::traceMessage(TraceEvent::PUBLISHER_COMPLETE, lastPublish.tagInfo.identifier, payload->getMsgId(), QoS::QOS_TWO);
+
     // proceed with the next PUBLISH
     lastPublish.retry = false;
-    scheduleClockEventAfter(publishInterval, publishEvent);
+    publishInFlight = false;
+    scheduleNextPublish();
 }
 
 void MqttSNPublisher::sendBaseWithWillTopic(const inet::L3Address& destAddress, const int& destPort, MsgType msgType, QoS qosFlag,
@@ -352,7 +438,7 @@ void MqttSNPublisher::sendBaseWithWillTopic(const inet::L3Address& destAddress,
 
     inet::Packet* packet = new inet::Packet(packetName.c_str());
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -381,7 +467,7 @@ void MqttSNPublisher::sendBaseWithWillMsg(const inet::L3Address& destAddress, co
 
     inet::Packet* packet = new inet::Packet(packetName.c_str());
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -389,7 +475,7 @@ void MqttSNPublisher::sendBaseWithWillMsg(const inet::L3Address& destAddress, co
 void MqttSNPublisher::sendRegister(const inet::L3Address& destAddress, const int& destPort, uint16_t msgId, const std::string& topicName)
 {
     inet::Packet* packet = PacketHelper::getRegisterPacket(0, msgId, topicName);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -397,8 +483,14 @@ void MqttSNPublisher::sendRegister(const inet::L3Address& destAddress, const int
 void MqttSNPublisher::sendPublish(const inet::L3Address& destAddress, const int& destPort, bool dupFlag, QoS qosFlag, bool retainFlag,
                                   TopicIdType topicIdTypeFlag, uint16_t topicId, uint16_t msgId, const std::string& data, const TagInfo& tagInfo)
 {
-    inet::Packet* packet = PacketHelper::getPublishPacket(dupFlag, qosFlag, retainFlag, topicIdTypeFlag, topicId, msgId, data, tagInfo);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    // stamp the transmission time on this copy of the tags
+    TagInfo sentTagInfo = tagInfo;
+    sentTagInfo.stageTimestamps[Stage::PUBLISHER_SENT] = getClockTime();
+
+    inet::Packet* packet = PacketHelper::getPublishPacket(dupFlag, qosFlag, retainFlag, topicIdTypeFlag, topicId, msgId, data, sentTagInfo);
+    MqttSNApp::corruptPacket(packet, destAddress);
+
+    MqttSNApp::traceMessage(TraceEvent::PUBLISHER_SEND, tagInfo.identifier, msgId, qosFlag, dupFlag);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -406,7 +498,7 @@ void MqttSNPublisher::sendPublish(const inet::L3Address& destAddress, const int&
 void MqttSNPublisher::sendBaseWithMsgId(const inet::L3Address& destAddress, const int& destPort, MsgType msgType, uint16_t msgId)
 {
     inet::Packet* packet = PacketHelper::getBaseWithMsgIdPacket(msgType, msgId);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -439,17 +531,20 @@ void MqttSNPublisher::handlePublishEvent()
 
     if (qos == QoS::QOS_ZERO) {
         sendPublish(MqttSNClient::selectedGateway.address, MqttSNClient::selectedGateway.port, false, qos, lastPublish.dataInfo->retain,
-                    lastPublish.itemInfo->topicIdType, lastPublish.topicId, 0, lastPublish.dataInfo->data, lastPublish.tagInfo);
+                    lastPublish.itemInfo->topicIdType, lastPublish.topicId, 0, getPublishData(lastPublish), lastPublish.tagInfo);
 
         // no need to wait for an ACK
-        scheduleClockEventAfter(publishInterval, publishEvent);
+        scheduleNextPublish();
         return;
     }
 
     sendPublish(MqttSNClient::selectedGateway.address, MqttSNClient::selectedGateway.port, false, qos, lastPublish.dataInfo->retain,
-                lastPublish.itemInfo->topicIdType, lastPublish.topicId, MqttSNClient::getNewMsgId(), lastPublish.dataInfo->data,
+                lastPublish.itemInfo->topicIdType, lastPublish.topicId, MqttSNClient::getNewMsgId(), getPublishData(lastPublish),
                 lastPublish.tagInfo);
 
+    // only one QoS 1 or QoS 2 message can be in flight
+    publishInFlight = true;
+
     // schedule PUBLISH retransmission
     MqttSNClient::scheduleRetransmissionWithMsgId(MsgType::PUBLISH, MqttSNClient::currentMsgId);
 }
@@ -468,6 +563,37 @@ void MqttSNPublisher::handlePublishMinusOneEvent()
     scheduleClockEventAfter(publishMinusOneInterval, publishMinusOneEvent);
 }
 
+void MqttSNPublisher::handleArrivalEvent()
+{
+    int publishLimit = par("publishLimit");
+    // stop generating arrivals once the PUBLISH limit is covered by sent and queued messages
+    if (publishLimit != -1 && publishCounter + (int) publishQueue.size() >= publishLimit) {
+        return;
+    }
+
+    if (publishQueueLimit != -1 && (int) publishQueue.size() >= publishQueueLimit) {
+        // the offered load exceeds what the send path can drain
+        MqttSNClient::droppedPublishMsgs++;
+    }
+    else {
+        PendingPublishInfo pendingPublish;
+        pendingPublish.arrivalTime = getClockTime();
+
+        // a payload size defined by the arrival process takes precedence
+        int payloadSize = arrivalProcess->getPayloadSize();
+        pendingPublish.payloadSize = payloadSize >= 0 ? payloadSize : (int) par("payloadSize");
+
+        publishQueue.push_back(pendingPublish);
+
+        // wake up the send path if it is idle
+        if (!publishInFlight && !publishEvent->isScheduled()) {
+            scheduleClockEventAfter(0.0, publishEvent);
+        }
+    }
+
+    scheduleNextArrival();
+}
+
 void MqttSNPublisher::validatePublishMinusOneGateway()
 {
     // check gateway address and port for QoS -1 publications
@@ -488,7 +614,7 @@ void MqttSNPublisher::validatePublishMinusOneGateway()
 
 void MqttSNPublisher::populateItems()
 {
-    json jsonData = json::parse(par("itemsJson").stringValue());
+    json jsonData = json::parse(MqttSNClient::getItemsJson());
     int itemsKey = 0;
 
     // iterate over json array elements
@@ -499,8 +625,8 @@ void MqttSNPublisher::populateItems()
         // validate topic name length and type against specified criteria
         MqttSNApp::checkTopicLength(topicName.length(), topicIdType);
 
-        auto predefinedTopicIt = MqttSNClient::predefinedTopics.find(StringHelper::base64Encode(topicName));
-        bool isPredefined = predefinedTopicIt != MqttSNClient::predefinedTopics.end();
+        auto predefinedTopicIt = MqttSNClient::predefinedTopics->find(StringHelper::base64Encode(topicName));
+        bool isPredefined = predefinedTopicIt != MqttSNClient::predefinedTopics->end();
 
         // validate topic consistency
         MqttSNClient::checkTopicConsistency(topicName, topicIdType, isPredefined);
@@ -618,23 +744,103 @@ bool MqttSNPublisher::proceedWithRegistration()
     return true;
 }
 
+BaseArrivalProcess* MqttSNPublisher::createArrivalProcess()
+{
+    std::string process = par("arrivalProcess").stdstringValue();
+
+    if (process == "fixed") {
+        return nullptr;
+    }
+
+    if (process == "periodic") {
+        return new PeriodicArrivalProcess(getRNG(0), publishInterval, par("publishJitter"));
+    }
+
+    if (process == "poisson") {
+        return new PoissonArrivalProcess(getRNG(0), par("arrivalRate"));
+    }
+
+    if (process == "onOff") {
+        return new OnOffArrivalProcess(getRNG(0), par("arrivalRate"), par("meanOnDuration"), par("meanOffDuration"));
+    }
+
+    if (process == "trace") {
+        return new TraceArrivalProcess(getRNG(0), par("arrivalTraceFile").stdstringValue());
+    }
+
+    throw omnetpp::cRuntimeError("Unknown arrival process: %s", process.c_str());
+}
+
+void MqttSNPublisher::scheduleNextArrival()
+{
+    double interArrivalTime = arrivalProcess->getNextInterArrivalTime();
+
+    // a negative time means the arrival process is exhausted
+    if (interArrivalTime < 0) {
+        return;
+    }
+
+    scheduleClockEventAfter(interArrivalTime, arrivalEvent);
+}
+
+void MqttSNPublisher::scheduleNextPublish()
+{
+    if (arrivalProcess == nullptr) {
+        scheduleClockEventAfter(publishInterval, publishEvent);
+        return;
+    }
+
+    // drain queued arrivals right away; otherwise the next arrival wakes up the send path
+    if (!publishQueue.empty()) {
+        scheduleClockEventAfter(0.0, publishEvent);
+    }
+}
+
 void MqttSNPublisher::printPublishMessage(const LastPublishInfo& lastPublishInfo)
 {
-    EV << "Publish message:" << std::endl;
-    EV << "Topic name: " << lastPublishInfo.topicName << std::endl;
-    EV << "Topic ID: " << lastPublishInfo.topicId << std::endl;
-    EV << "Topic ID type: " << ConversionHelper::topicIdTypeToString(lastPublishInfo.itemInfo->topicIdType) << std::endl;
-    EV << "Duplicate: " << false << std::endl;
-    EV << "QoS: " << ConversionHelper::qosToInt(lastPublishInfo.dataInfo->qos) << std::endl;
-    EV << "Retain: " << lastPublishInfo.dataInfo->retain << std::endl;
-    EV << "Data: " << lastPublishInfo.dataInfo->data << std::endl;
-    EV << "Timestamp tag: " << lastPublishInfo.tagInfo.timestamp << std::endl;
-    EV << "ID tag: " << lastPublishInfo.tagInfo.identifier << std::endl;
+    MQTTSN_LOG_DEBUG(LogEvent::PUBLISH_CREATED, lastPublishInfo.tagInfo.identifier, lastPublishInfo.topicId,
+                     "Publish message:" << std::endl
+                     << "Topic name: " << lastPublishInfo.topicName << std::endl
+                     << "Topic ID: " << lastPublishInfo.topicId << std::endl
+                     << "Topic ID type: " << ConversionHelper::topicIdTypeToString(lastPublishInfo.itemInfo->topicIdType) << std::endl
+                     << "Duplicate: " << false << std::endl
+                     << "QoS: " << ConversionHelper::qosToInt(lastPublishInfo.dataInfo->qos) << std::endl
+                     << "Retain: " << lastPublishInfo.dataInfo->retain << std::endl
+                     << "Data: " << lastPublishInfo.dataInfo->data << std::endl
+                     << "Payload size: " << lastPublishInfo.payloadSize << std::endl
+                     << "Timestamp tag: " << lastPublishInfo.tagInfo.timestamp << std::endl
+                     << "ID tag: " << lastPublishInfo.tagInfo.identifier);
+}
+
+std::string MqttSNPublisher::getPublishData(const LastPublishInfo& lastPublishInfo)
+{
+    const std::string& data = lastPublishInfo.dataInfo->data;
+    int payloadSize = lastPublishInfo.payloadSize;
+
+    // negative size means the item data is sent as it is
+    if (payloadSize < 0) {
+        return data;
+    }
+
+    // payload bytes are only materialized here, by repeating the item data up to the drawn size
+    if (data.empty()) {
+        return std::string(payloadSize, '0');
+    }
+
+    std::string result;
+    result.reserve(payloadSize);
+
+    while ((int) result.size() < payloadSize) {
+        result.append(data, 0, payloadSize - result.size());
+    }
+
+    return result;
 }
 
 void MqttSNPublisher::retryLastPublish()
 {
     lastPublish.retry = true;
+    publishInFlight = false;
 
     // reschedule the last PUBLISH
     cancelEvent(publishEvent);
@@ -643,6 +849,11 @@ void MqttSNPublisher::retryLastPublish()
 
 bool MqttSNPublisher::proceedWithPublish()
 {
+    // the REGACK of the evicted topic schedules the held PUBLISH
+    if (publishAwaitsRegistration) {
+        return false;
+    }
+
     // if it's a retry, use the last sent element
     if (lastPublish.retry) {
         return true;
@@ -654,6 +865,11 @@ bool MqttSNPublisher::proceedWithPublish()
         return false;
     }
 
+    // with an arrival process, only queued arrivals are published
+    if (arrivalProcess != nullptr && publishQueue.empty()) {
+        return false;
+    }
+
     // check for topics availability
     if (topics.empty()) {
         scheduleClockEventAfter(MqttSNClient::MIN_WAITING_TIME, publishEvent);
@@ -692,9 +908,23 @@ bool MqttSNPublisher::proceedWithPublish()
     lastPublish.dataInfo = &dataIterator->second;
 
     TagInfo tagInfo;
-    tagInfo.timestamp = getClockTime();
     tagInfo.identifier = ++publishMsgIdentifier;
 
+    if (arrivalProcess == nullptr) {
+        tagInfo.timestamp = getClockTime();
+        lastPublish.payloadSize = par("payloadSize");
+    }
+    else {
+        // the creation time is the arrival time, so queueing delay is part of the end-to-end delay
+        const PendingPublishInfo& pendingPublish = publishQueue.front();
+        tagInfo.timestamp = pendingPublish.arrivalTime;
+        lastPublish.payloadSize = pendingPublish.payloadSize;
+
+        publishQueue.pop_front();
+    }
+
+    tagInfo.stageTimestamps[Stage::PUBLISHER_CREATED] = tagInfo.timestamp;
+
     // update tags about the last element
     lastPublish.tagInfo = tagInfo;
 
@@ -751,6 +981,7 @@ bool MqttSNPublisher::proceedWithPublishMinusOne()
     TagInfo tagInfo;
     tagInfo.timestamp = getClockTime();
     tagInfo.identifier = ++publishMsgIdentifier;
+    tagInfo.stageTimestamps[Stage::PUBLISHER_CREATED] = tagInfo.timestamp;
 
     // update tags about the last element
     lastPublishMinusOne.tagInfo = tagInfo;
@@ -821,8 +1052,12 @@ void MqttSNPublisher::retransmitRegister(const inet::L3Address& destAddress, con
 
 void MqttSNPublisher::retransmitPublish(const inet::L3Address& destAddress, const int& destPort, omnetpp::cMessage* msg)
 {
+    uint16_t msgId = std::stoi(msg->par("msgId").stringValue());
+
+    MqttSNApp::traceMessage(TraceEvent::PUBLISHER_RETRANSMIT, lastPublish.tagInfo.identifier, msgId, lastPublish.dataInfo->qos, true);
+
     sendPublish(destAddress, destPort, true, lastPublish.dataInfo->qos, lastPublish.dataInfo->retain, lastPublish.itemInfo->topicIdType,
-                lastPublish.topicId, std::stoi(msg->par("msgId").stringValue()), lastPublish.dataInfo->data, lastPublish.tagInfo);
+                lastPublish.topicId, msgId, getPublishData(lastPublish), lastPublish.tagInfo);
 
     MqttSNClient::publishersRetransmissions++;
 }
@@ -839,6 +1074,9 @@ MqttSNPublisher::~MqttSNPublisher()
     cancelAndDelete(registrationEvent);
     cancelAndDelete(publishEvent);
     cancelAndDelete(publishMinusOneEvent);
+    cancelAndDelete(arrivalEvent);
+
+    delete arrivalProcess;
 }
 
 } /* namespace mqttsn */
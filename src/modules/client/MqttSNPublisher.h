@@ -25,6 +25,8 @@
 #include "types/client/publisher/TopicInfo.h"
 #include "types/client/publisher/LastRegisterInfo.h"
 #include "types/client/publisher/LastPublishInfo.h"
+#include "types/client/publisher/PendingPublishInfo.h"
+#include "workloads/BaseArrivalProcess.h"
 
 namespace mqttsn {
 
@@ -41,6 +43,7 @@ class MqttSNPublisher : public MqttSNClient
         double publishMinusOneInterval;
         inet::L3Address publishMinusOneDestAddress;
         int publishMinusOneDestPort;
+        int publishQueueLimit;
 
         // active publisher state
         std::map<int, ItemInfo> items;
@@ -54,6 +57,13 @@ class MqttSNPublisher : public MqttSNClient
         inet::ClockEvent* publishEvent = nullptr;
         LastPublishInfo lastPublish;
         int publishCounter = 0;
+        bool publishInFlight = false;
+        bool publishAwaitsRegistration = false;
+
+        // workload state; no arrival process means publishing at a fixed interval
+        BaseArrivalProcess* arrivalProcess = nullptr;
+        inet::ClockEvent* arrivalEvent = nullptr;
+        std::deque<PendingPublishInfo> publishQueue;
 
         inet::ClockEvent* publishMinusOneEvent = nullptr;
         LastPublishInfo lastPublishMinusOne;
@@ -105,6 +115,7 @@ class MqttSNPublisher : public MqttSNClient
         virtual void handleRegistrationEvent();
         virtual void handlePublishEvent();
         virtual void handlePublishMinusOneEvent();
+        virtual void handleArrivalEvent();
 
         // gateway methods
         virtual void validatePublishMinusOneGateway();
@@ -116,8 +127,14 @@ class MqttSNPublisher : public MqttSNClient
         virtual void resetAndPopulateTopics();
         virtual bool proceedWithRegistration();
 
+        // workload methods
+        virtual BaseArrivalProcess* createArrivalProcess();
+        virtual void scheduleNextArrival();
+        virtual void scheduleNextPublish();
+
         // publication methods
         virtual void printPublishMessage(const LastPublishInfo& lastPublishInfo);
+        virtual std::string getPublishData(const LastPublishInfo& lastPublishInfo);
         virtual void retryLastPublish();
         virtual bool proceedWithPublish();
         virtual bool proceedWithPublishMinusOne();
@@ -15,12 +15,11 @@
 
 #include "MqttSNSubscriber.h"
 #include "externals/nlohmann/json.hpp"
-#include "inet/common/TimeTag_m.h"
-#include "tags/IdentifierTag.h"
 #include "helpers/ConversionHelper.h"
 #include "helpers/StringHelper.h"
 #include "helpers/NumericHelper.h"
 #include "helpers/PacketHelper.h"
+#include "logging/Logging.h"
 #include "messages/MqttSNSubscribe.h"
 #include "messages/MqttSNSubAck.h"
 #include "messages/MqttSNUnsubscribe.h"
@@ -34,7 +33,7 @@ Define_Module(MqttSNSubscriber);
 
 using json = nlohmann::json;
 
-std::set<unsigned> MqttSNSubscriber::publishMsgIdentifiers;
+IdentifierBitmap MqttSNSubscriber::publishMsgIdentifiers;
 
 void MqttSNSubscriber::levelTwoInit()
 {
@@ -46,8 +45,41 @@ void MqttSNSubscriber::levelTwoInit()
     unsubscriptionInterval = par("unsubscriptionInterval");
     unsubscriptionEvent = new inet::ClockEvent("unsubscriptionTimer");
 
+    int identifierWindowSize = par("identifierWindowSize");
+
     instancePublishMsgIdentifiers.clear();
+    instancePublishMsgIdentifiers.setWindowSize(identifierWindowSize);
+
     publishMsgIdentifiers.clear();
+    publishMsgIdentifiers.setWindowSize(identifierWindowSize);
+
+    latePublishMsgs = 0;
+
+    latencyReportInterval = par("latencyReportInterval");
+    latencyReportEvent = new inet::ClockEvent("latencyReportTimer");
+
+    latencyP50Vector.setName("publishLatencyP50");
+    latencyP99Vector.setName("publishLatencyP99");
+    latencyP999Vector.setName("publishLatencyP999");
+    latencyMaxVector.setName("publishLatencyMax");
+}
+
+void MqttSNSubscriber::finish()
+{
+    // per subscriber end-to-end delay distribution
+    if (!latencyHistogram.isEmpty()) {
+        recordScalar("publishLatencyCount", latencyHistogram.getCount());
+        recordScalar("publishLatencyMean", latencyHistogram.getMean());
+        recordScalar("publishLatencyP50", latencyHistogram.getPercentile(50));
+        recordScalar("publishLatencyP90", latencyHistogram.getPercentile(90));
+        recordScalar("publishLatencyP99", latencyHistogram.getPercentile(99));
+        recordScalar("publishLatencyP999", latencyHistogram.getPercentile(99.9));
+        recordScalar("publishLatencyMax", latencyHistogram.getMax());
+    }
+
+    recordScalar("latePublishMsgs", latePublishMsgs);
+
+    MqttSNClient::finish();
 }
 
 bool MqttSNSubscriber::handleMessageWhenUpCustom(omnetpp::cMessage* msg)
@@ -58,6 +90,9 @@ bool MqttSNSubscriber::handleMessageWhenUpCustom(omnetpp::cMessage* msg)
     else if (msg == unsubscriptionEvent) {
         handleUnsubscriptionEvent();
     }
+    else if (msg == latencyReportEvent) {
+        handleLatencyReportEvent();
+    }
     else {
         return false;
     }
@@ -80,18 +115,25 @@ void MqttSNSubscriber::scheduleActiveStateEventsCustom()
 
     // reset messages, if any
     messages.clear();
+
+    // periodic latency snapshots, if enabled
+    if (latencyReportInterval > 0) {
+        scheduleClockEventAfter(latencyReportInterval, latencyReportEvent);
+    }
 }
 
 void MqttSNSubscriber::cancelActiveStateEventsCustom()
 {
     cancelEvent(subscriptionEvent);
     cancelEvent(unsubscriptionEvent);
+    cancelEvent(latencyReportEvent);
 }
 
 void MqttSNSubscriber::cancelActiveStateClockEventsCustom()
 {
     cancelClockEvent(subscriptionEvent);
     cancelClockEvent(unsubscriptionEvent);
+    cancelClockEvent(latencyReportEvent);
 }
 
 void MqttSNSubscriber::adjustAllowedPacketTypes(std::vector<MsgType>& msgTypes)
@@ -284,11 +326,12 @@ void MqttSNSubscriber::processPublish(inet::Packet* pk, const inet::L3Address& s
 
     QoS qos = (QoS) payload->getQoSFlag();
     bool retain = payload->getRetainFlag();
-    std::string data = payload->getData();
+    const std::string& data = payload->getData();
+
+    TagInfo tagInfo = PacketHelper::getPublishTagInfo(payload);
+    tagInfo.stageTimestamps[Stage::SUBSCRIBER_RECEIVED] = getClockTime();
 
-    TagInfo tagInfo;
-    tagInfo.timestamp = inet::ClockTime::SIMTIME_AS_CLOCKTIME(payload->findTag<inet::CreationTimeTag>()->getCreationTime());
-    tagInfo.identifier = payload->findTag<IdentifierTag>()->getIdentifier();
+    MqttSNApp::traceMessage(TraceEvent::SUBSCRIBER_RECEIVE, tagInfo.identifier, msgId, qos, payload->getDupFlag());
 
     MessageInfo messageInfo;
     messageInfo.topicName = topics[topicId].topicName;
@@ -303,14 +346,14 @@ void MqttSNSubscriber::processPublish(inet::Packet* pk, const inet::L3Address& s
     if (qos == QoS::QOS_MINUS_ONE || qos == QoS::QOS_ZERO) {
         // handling QoS -1 or QoS 0
         printPublishMessage(messageInfo);
-        handlePublishMessageMetrics(tagInfo);
+        handlePublishMessageMetrics(messageInfo);
         return;
     }
 
     if (qos == QoS::QOS_ONE) {
         // handling QoS 1
         printPublishMessage(messageInfo);
-        handlePublishMessageMetrics(tagInfo);
+        handlePublishMessageMetrics(messageInfo);
         sendMsgIdWithTopicIdPlus(srcAddress, srcPort, MsgType::PUBACK, topicId, msgId, ReturnCode::ACCEPTED);
         return;
     }
@@ -359,7 +402,7 @@ void MqttSNSubscriber::processPubRel(inet::Packet* pk, const inet::L3Address& sr
 
         // handling QoS 2
         printPublishMessage(messageInfo);
-        handlePublishMessageMetrics(messageInfo.tagInfo);
+        handlePublishMessageMetrics(messageInfo);
 
         // after processing, delete the message from the map
         messages.erase(messageIt);
@@ -393,7 +436,7 @@ void MqttSNSubscriber::sendSubscribe(const inet::L3Address& destAddress, const i
 
     inet::Packet* packet = new inet::Packet("SubscribePacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -419,7 +462,7 @@ void MqttSNSubscriber::sendUnsubscribe(const inet::L3Address& destAddress, const
 
     inet::Packet* packet = new inet::Packet("UnsubscribePacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -428,7 +471,7 @@ void MqttSNSubscriber::sendMsgIdWithTopicIdPlus(const inet::L3Address& destAddre
                                                 uint16_t msgId, ReturnCode returnCode)
 {
     inet::Packet* packet = PacketHelper::getMsgIdWithTopicIdPlusPacket(msgType, topicId, msgId, returnCode);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -436,7 +479,7 @@ void MqttSNSubscriber::sendMsgIdWithTopicIdPlus(const inet::L3Address& destAddre
 void MqttSNSubscriber::sendBaseWithMsgId(const inet::L3Address& destAddress, const int& destPort, MsgType msgType, uint16_t msgId)
 {
     inet::Packet* packet = PacketHelper::getBaseWithMsgIdPacket(msgType, msgId);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -479,7 +522,7 @@ void MqttSNSubscriber::handleUnsubscriptionEvent()
 
 void MqttSNSubscriber::populateItems()
 {
-    json jsonData = json::parse(par("itemsJson").stringValue());
+    json jsonData = json::parse(MqttSNClient::getItemsJson());
     int itemsKey = 0;
 
     // iterate over json array elements
@@ -490,8 +533,8 @@ void MqttSNSubscriber::populateItems()
         // validate topic name length and type against specified criteria
         MqttSNApp::checkTopicLength(topicName.length(), topicIdType);
 
-        auto predefinedTopicIt = MqttSNClient::predefinedTopics.find(StringHelper::base64Encode(topicName));
-        bool isPredefined = predefinedTopicIt != MqttSNClient::predefinedTopics.end();
+        auto predefinedTopicIt = MqttSNClient::predefinedTopics->find(StringHelper::base64Encode(topicName));
+        bool isPredefined = predefinedTopicIt != MqttSNClient::predefinedTopics->end();
 
         // validate topic consistency
         MqttSNClient::checkTopicConsistency(topicName, topicIdType, isPredefined);
@@ -648,20 +691,25 @@ bool MqttSNSubscriber::proceedWithUnsubscription()
 
 void MqttSNSubscriber::printPublishMessage(const MessageInfo& messageInfo)
 {
-    EV << "Received publish message:" << std::endl;
-    EV << "Topic name: " << messageInfo.topicName << std::endl;
-    EV << "Topic ID: " << messageInfo.topicId << std::endl;
-    EV << "Topic ID type: " << ConversionHelper::topicIdTypeToString(messageInfo.topicIdType) << std::endl;
-    EV << "Duplicate: " << messageInfo.dup << std::endl;
-    EV << "QoS: " << ConversionHelper::qosToInt(messageInfo.qos) << std::endl;
-    EV << "Retain: " << messageInfo.retain << std::endl;
-    EV << "Data: " << messageInfo.data << std::endl;
-    EV << "Timestamp tag: " << messageInfo.tagInfo.timestamp << std::endl;
-    EV << "ID tag: " << messageInfo.tagInfo.identifier << std::endl;
+    MQTTSN_LOG_DEBUG(LogEvent::PUBLISH_DELIVERED, messageInfo.tagInfo.identifier, messageInfo.topicId,
+                     "Received publish message:" << std::endl
+                     << "Topic name: " << messageInfo.topicName << std::endl
+                     << "Topic ID: " << messageInfo.topicId << std::endl
+                     << "Topic ID type: " << ConversionHelper::topicIdTypeToString(messageInfo.topicIdType) << std::endl
+                     << "Duplicate: " << messageInfo.dup << std::endl
+                     << "QoS: " << ConversionHelper::qosToInt(messageInfo.qos) << std::endl
+                     << "Retain: " << messageInfo.retain << std::endl
+                     << "Data: " << messageInfo.data << std::endl
+                     << "Timestamp tag: " << messageInfo.tagInfo.timestamp << std::endl
+                     << "ID tag: " << messageInfo.tagInfo.identifier);
 }
 
-void MqttSNSubscriber::handlePublishMessageMetrics(const TagInfo& tagInfo)
+void MqttSNSubscriber::handlePublishMessageMetrics(const MessageInfo& messageInfo)
 {
+    const TagInfo& tagInfo = messageInfo.tagInfo;
+
+    MqttSNApp::traceMessage(TraceEvent::SUBSCRIBER_DELIVER, tagInfo.identifier, 0, messageInfo.qos, messageInfo.dup);
+
     // return if the tag information is not valid
     if (tagInfo.timestamp == 0 || tagInfo.identifier == 0) {
         return;
@@ -671,29 +719,62 @@ void MqttSNSubscriber::handlePublishMessageMetrics(const TagInfo& tagInfo)
     inet::clocktime_t endToEndDelay = getClockTime() - tagInfo.timestamp;
 
     // print the current message delay
-    EV << "End-to-end delay: " << endToEndDelay << " seconds" << std::endl;
+    MQTTSN_LOG_DEBUG(LogEvent::END_TO_END_DELAY, tagInfo.identifier, endToEndDelay.inUnit(omnetpp::SIMTIME_NS),
+                     "End-to-end delay: " << endToEndDelay << " seconds");
 
     MqttSNClient::sumReceivedPublishMsgTimestamps += endToEndDelay.dbl();
     MqttSNClient::receivedTotalPublishMsgs++;
 
-    // duplicate detection
-    auto identifierIt = instancePublishMsgIdentifiers.find(tagInfo.identifier);
-    if (identifierIt == instancePublishMsgIdentifiers.end()) {
-        // insert the message identifier into the instance set to track unique messages
-        instancePublishMsgIdentifiers.insert(tagInfo.identifier);
+    // latency distributions per subscriber, per topic and per QoS level
+    double delay = endToEndDelay.dbl();
+
+    // stage breakdown of the delay; delivery happens now, after the QoS 2 handshake if any
+    TagInfo deliveredTagInfo = tagInfo;
+    deliveredTagInfo.stageTimestamps[Stage::SUBSCRIBER_DELIVERED] = getClockTime();
+    MqttSNClient::recordStageLatencies(deliveredTagInfo);
+
+    latencyHistogram.record(delay);
+    intervalLatencyHistogram.record(delay);
+
+    MqttSNClient::publishLatencyHistogram.record(delay);
+    MqttSNClient::topicLatencyHistograms[messageInfo.topicName].record(delay);
+    MqttSNClient::qosLatencyHistograms[ConversionHelper::qosToInt(messageInfo.qos)].record(delay);
+
+    // behind the identifier window a first delivery cannot be told from a duplicate, so it is counted on its own
+    if (instancePublishMsgIdentifiers.isExpired(tagInfo.identifier) || publishMsgIdentifiers.isExpired(tagInfo.identifier)) {
+        latePublishMsgs++;
+        MqttSNClient::receivedLatePublishMsgs++;
+        return;
     }
-    else {
+
+    // duplicate detection; the identifier is recorded in the instance bitmap to track unique messages
+    if (!instancePublishMsgIdentifiers.insert(tagInfo.identifier)) {
         // increment the count of duplicate PUBLISH messages received so far
         MqttSNClient::receivedDuplicatePublishMsgs++;
     }
 
-    // insert the message identifier into the set to track unique messages
+    // insert the message identifier into the shared bitmap to track unique messages
     publishMsgIdentifiers.insert(tagInfo.identifier);
 
     // count of unique PUBLISH messages received so far
     MqttSNClient::receivedUniquePublishMsgs = publishMsgIdentifiers.size();
 }
 
+void MqttSNSubscriber::handleLatencyReportEvent()
+{
+    // record the snapshot of the elapsed interval, then start a new one
+    if (!intervalLatencyHistogram.isEmpty()) {
+        latencyP50Vector.record(intervalLatencyHistogram.getPercentile(50));
+        latencyP99Vector.record(intervalLatencyHistogram.getPercentile(99));
+        latencyP999Vector.record(intervalLatencyHistogram.getPercentile(99.9));
+        latencyMaxVector.record(intervalLatencyHistogram.getMax());
+
+        intervalLatencyHistogram.clear();
+    }
+
+    scheduleClockEventAfter(latencyReportInterval, latencyReportEvent);
+}
+
 void MqttSNSubscriber::handleRetransmissionEventCustom(const inet::L3Address& destAddress, const int& destPort, omnetpp::cMessage* msg,
                                                        MsgType msgType)
 {
@@ -742,6 +823,7 @@ MqttSNSubscriber::~MqttSNSubscriber()
 {
     cancelAndDelete(subscriptionEvent);
     cancelAndDelete(unsubscriptionEvent);
+    cancelAndDelete(latencyReportEvent);
 }
 
 } /* namespace mqttsn */
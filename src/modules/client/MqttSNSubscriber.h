@@ -26,6 +26,7 @@
 #include "types/client/subscriber/LastOperationInfo.h"
 #include "types/client/subscriber/DataInfo.h"
 #include "types/client/subscriber/MessageInfo.h"
+#include "containers/IdentifierBitmap.h"
 
 namespace mqttsn {
 
@@ -52,13 +53,28 @@ class MqttSNSubscriber : public MqttSNClient
         std::map<uint16_t, DataInfo> messages;
 
         // metrics attributes
-        std::set<unsigned> instancePublishMsgIdentifiers;
-        static std::set<unsigned> publishMsgIdentifiers;
+        IdentifierBitmap instancePublishMsgIdentifiers;
+        static IdentifierBitmap publishMsgIdentifiers;
+        unsigned latePublishMsgs = 0;
+
+        LatencyHistogram latencyHistogram;
+        LatencyHistogram intervalLatencyHistogram;
+
+        double latencyReportInterval;
+        inet::ClockEvent* latencyReportEvent = nullptr;
+
+        omnetpp::cOutVector latencyP50Vector;
+        omnetpp::cOutVector latencyP99Vector;
+        omnetpp::cOutVector latencyP999Vector;
+        omnetpp::cOutVector latencyMaxVector;
 
     protected:
         // initialization
         virtual void levelTwoInit() override;
 
+        // application base
+        virtual void finish() override;
+
         // message handling
         virtual bool handleMessageWhenUpCustom(omnetpp::cMessage* msg) override;
 
@@ -96,6 +112,7 @@ class MqttSNSubscriber : public MqttSNClient
         virtual void handleCheckConnectionEventCustom(const inet::L3Address& destAddress, const int& destPort) override;
         virtual void handleSubscriptionEvent();
         virtual void handleUnsubscriptionEvent();
+        virtual void handleLatencyReportEvent();
 
         // item methods
         virtual void populateItems() override;
@@ -110,7 +127,7 @@ class MqttSNSubscriber : public MqttSNClient
 
         // publication methods
         virtual void printPublishMessage(const MessageInfo& messageInfo);
-        virtual void handlePublishMessageMetrics(const TagInfo& tagInfo);
+        virtual void handlePublishMessageMetrics(const MessageInfo& messageInfo);
 
         // retransmission management
         virtual void handleRetransmissionEventCustom(const inet::L3Address& destAddress, const int& destPort, omnetpp::cMessage* msg,
@@ -17,12 +17,13 @@
 #include "inet/networklayer/common/L3AddressResolver.h"
 #include "inet/networklayer/common/L3AddressTag_m.h"
 #include "inet/transportlayer/common/L4PortTag_m.h"
-#include "inet/common/TimeTag_m.h"
 #include "helpers/StringHelper.h"
 #include "helpers/PacketHelper.h"
 #include "helpers/NumericHelper.h"
+#include "helpers/PersistenceHelper.h"
 #include "types/shared/Length.h"
-#include "tags/IdentifierTag.h"
+#include "tracing/MessageTracer.h"
+#include "logging/Logging.h"
 #include "messages/MqttSNAdvertise.h"
 #include "messages/MqttSNConnect.h"
 #include "messages/MqttSNBase.h"
@@ -37,6 +38,7 @@
 #include "messages/MqttSNSubscribe.h"
 #include "messages/MqttSNSubAck.h"
 #include "messages/MqttSNUnsubscribe.h"
+#include <chrono>
 
 namespace mqttsn {
 
@@ -75,6 +77,19 @@ void MqttSNServer::levelOneInit()
 
     messagesClearInterval = par("messagesClearInterval");
     messagesClearEvent = new inet::ClockEvent("messagesClearTimer");
+
+    topicsCheckInterval = par("topicsCheckInterval");
+    topicIdleTimeout = par("topicIdleTimeout");
+    topicsCheckEvent = new inet::ClockEvent("topicsCheckTimer");
+
+    retainedMemoryLimit = par("retainedMemoryLimit");
+    retainedMessageSizeLimit = par("retainedMessageSizeLimit");
+    retainedMessageTimeToLive = par("retainedMessageTimeToLive");
+    retainMessages.setLimits(retainedMemoryLimit, retainedMessageSizeLimit, retainedMessageTimeToLive);
+
+    retainedBytesVector.setName("retainedBytes");
+
+    initializePersistence();
 }
 
 void MqttSNServer::finish()
@@ -82,6 +97,27 @@ void MqttSNServer::finish()
     clearPublishersData();
     clearSubscribersData();
 
+    recordScalar("evictedTopics", evictedTopicsCounter);
+
+    recordScalar("retainedMessages", retainMessages.size());
+    recordScalar("retainedBytes", retainMessages.getUsedBytes());
+    recordScalar("retainedPeakBytes", retainMessages.getPeakBytes());
+    recordScalar("retainedArenaBytes", retainMessages.getArenaBytes());
+    recordScalar("retainedEvictions", retainMessages.getEvictions());
+    recordScalar("retainedExpirations", retainMessages.getExpirations());
+    recordScalar("retainedRejections", retainMessages.getRejections());
+
+    if (writeAheadLog.isEnabled()) {
+        writeAheadLog.close();
+
+        recordScalar("walCommits", writeAheadLog.getCommits());
+        recordScalar("walCommittedRecords", writeAheadLog.getCommittedRecords());
+        recordScalar("walCheckpoints", writeAheadLog.getCheckpoints());
+        recordScalar("walRecoveries", walRecoveries);
+        recordScalar("walRecoveredRecords", walRecoveredRecords);
+        recordScalar("walRecoveryTime", walRecoveryTime);
+    }
+
     MqttSNApp::finish();
 }
 
@@ -91,6 +127,15 @@ void MqttSNServer::handleStartOperation(inet::LifecycleOperation* operation)
 
     setGatewayId();
 
+    // rebuild the state lost in the crash from the write-ahead log
+    if (recoveryPending) {
+        recoverState();
+    }
+
+    if (writeAheadLog.isEnabled()) {
+        scheduleClockEventAfter(walCommitInterval, walCommitEvent);
+    }
+
     EV << "Current gateway state: " << getGatewayStateAsString() << std::endl;
 
     double currentStateInterval = getStateInterval(currentState);
@@ -104,6 +149,11 @@ void MqttSNServer::handleStopOperation(inet::LifecycleOperation* operation)
     cancelEvent(stateChangeEvent);
     cancelOnlineStateEvents();
 
+    if (writeAheadLog.isEnabled()) {
+        cancelEvent(walCommitEvent);
+        writeAheadLog.commit();
+    }
+
     MqttSNApp::socket.close();
 }
 
@@ -111,6 +161,15 @@ void MqttSNServer::handleCrashOperation(inet::LifecycleOperation* operation)
 {
     cancelOnlineStateClockEvents();
 
+    if (writeAheadLog.isEnabled()) {
+        cancelClockEvent(walCommitEvent);
+
+        // records of the open commit group are lost together with the in-memory state
+        writeAheadLog.discardPending();
+        clearPersistentState();
+        recoveryPending = true;
+    }
+
     MqttSNApp::socket.destroy();
 }
 
@@ -143,6 +202,12 @@ void MqttSNServer::handleMessageWhenUp(omnetpp::cMessage* msg)
     else if (msg == messagesClearEvent) {
         handleMessagesClearEvent();
     }
+    else if (msg == topicsCheckEvent) {
+        handleTopicsCheckEvent();
+    }
+    else if (msg == walCommitEvent) {
+        handleWalCommitEvent();
+    }
     else {
         MqttSNApp::socket.processMessage(msg);
     }
@@ -168,7 +233,7 @@ void MqttSNServer::handleStateChangeEvent()
 void MqttSNServer::updateCurrentState(GatewayState nextState)
 {
     currentState = nextState;
-    EV << "Current gateway state: " << getGatewayStateAsString() << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::GATEWAY_STATE_CHANGED, currentState, 0, "Current gateway state: " << getGatewayStateAsString());
 }
 
 void MqttSNServer::scheduleOnlineStateEvents()
@@ -180,6 +245,10 @@ void MqttSNServer::scheduleOnlineStateEvents()
     scheduleClockEventAfter(requestsCheckInterval, requestsCheckEvent);
     scheduleClockEventAfter(registrationsCheckInterval, registrationsCheckEvent);
     scheduleClockEventAfter(messagesClearInterval, messagesClearEvent);
+
+    if (topicIdleTimeout != -1) {
+        scheduleClockEventAfter(topicsCheckInterval, topicsCheckEvent);
+    }
 }
 
 void MqttSNServer::cancelOnlineStateEvents()
@@ -191,6 +260,7 @@ void MqttSNServer::cancelOnlineStateEvents()
     cancelEvent(requestsCheckEvent);
     cancelEvent(registrationsCheckEvent);
     cancelEvent(messagesClearEvent);
+    cancelEvent(topicsCheckEvent);
 }
 
 void MqttSNServer::cancelOnlineStateClockEvents()
@@ -203,6 +273,7 @@ void MqttSNServer::cancelOnlineStateClockEvents()
     cancelClockEvent(requestsCheckEvent);
     cancelClockEvent(registrationsCheckEvent);
     cancelClockEvent(messagesClearEvent);
+    cancelClockEvent(topicsCheckEvent);
 }
 
 bool MqttSNServer::fromOfflineToOnline()
@@ -290,16 +361,20 @@ void MqttSNServer::processPacket(inet::Packet* pk)
         return;
     }
 
-    EV << "Server received packet: " << inet::UdpSocket::getReceivedPacketInfo(pk) << std::endl;
+    // decode the message once; every handler below reads from this view
+    PacketView packet;
+    packet.header = pk->peekData<MqttSNBase>();
+    MqttSNApp::checkPacketIntegrity((inet::B) pk->getByteLength(), (inet::B) packet.header->getLength());
 
-    const auto& header = pk->peekData<MqttSNBase>();
-    MqttSNApp::checkPacketIntegrity((inet::B) pk->getByteLength(), (inet::B) header->getLength());
+    MsgType msgType = packet.header->getMsgType();
+    packet.msgType = msgType;
 
-    MsgType msgType = header->getMsgType();
+    MQTTSN_LOG_INFO(LogEvent::PACKET_RECEIVED, msgType, pk->getByteLength(),
+                    "Server received packet: " << inet::UdpSocket::getReceivedPacketInfo(pk));
 
     // if message type is PUBLISH and QoS is -1, process the packet and exit
-    if (msgType == MsgType::PUBLISH && pk->peekData<MqttSNPublish>()->getQoSFlag() == QoS::QOS_MINUS_ONE) {
-        processPublishMinusOne(pk);
+    if (msgType == MsgType::PUBLISH && packet.get<MqttSNPublish>()->getQoSFlag() == QoS::QOS_MINUS_ONE) {
+        processPublishMinusOne(packet);
         delete pk;
         return;
     }
@@ -314,13 +389,13 @@ void MqttSNServer::processPacket(inet::Packet* pk)
     }
 
     // process packet based on the message type
-    processPacketByMessageType(pk, srcAddress, srcPort, msgType, clientInfo);
+    processPacketByMessageType(packet, srcAddress, srcPort, msgType, clientInfo);
 
     // delete packet after processing
     delete pk;
 }
 
-void MqttSNServer::processPacketByMessageType(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType,
+void MqttSNServer::processPacketByMessageType(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType,
                                               ClientInfo* clientInfo)
 {
     switch(msgType) {
@@ -329,27 +404,27 @@ void MqttSNServer::processPacketByMessageType(inet::Packet* pk, const inet::L3Ad
             break;
 
         case MsgType::CONNECT:
-            processConnect(pk, srcAddress, srcPort);
+            processConnect(packet, srcAddress, srcPort);
             break;
 
         case MsgType::WILLTOPIC:
-            processWillTopic(pk, srcAddress, srcPort);
+            processWillTopic(packet, srcAddress, srcPort);
             break;
 
         case MsgType::WILLTOPICUPD:
-            processWillTopic(pk, srcAddress, srcPort, true);
+            processWillTopic(packet, srcAddress, srcPort, true);
             break;
 
         case MsgType::WILLMSG:
-            processWillMsg(pk, srcAddress, srcPort);
+            processWillMsg(packet, srcAddress, srcPort);
             break;
 
         case MsgType::WILLMSGUPD:
-            processWillMsg(pk, srcAddress, srcPort, true);
+            processWillMsg(packet, srcAddress, srcPort, true);
             break;
 
         case MsgType::PINGREQ:
-            processPingReq(pk, srcAddress, srcPort, clientInfo);
+            processPingReq(packet, srcAddress, srcPort, clientInfo);
             break;
 
         case MsgType::PINGRESP:
@@ -357,47 +432,47 @@ void MqttSNServer::processPacketByMessageType(inet::Packet* pk, const inet::L3Ad
             break;
 
         case MsgType::DISCONNECT:
-            processDisconnect(pk, srcAddress, srcPort, clientInfo);
+            processDisconnect(packet, srcAddress, srcPort, clientInfo);
             break;
 
         case MsgType::REGISTER:
             updateClientType(clientInfo, ClientType::PUBLISHER);
-            processRegister(pk, srcAddress, srcPort);
+            processRegister(packet, srcAddress, srcPort);
             break;
 
         case MsgType::PUBLISH:
             updateClientType(clientInfo, ClientType::PUBLISHER);
-            processPublish(pk, srcAddress, srcPort);
+            processPublish(packet, srcAddress, srcPort);
             break;
 
         case MsgType::PUBREL:
-            processPubRel(pk, srcAddress, srcPort);
+            processPubRel(packet, srcAddress, srcPort);
             break;
 
         case MsgType::SUBSCRIBE:
             updateClientType(clientInfo, ClientType::SUBSCRIBER);
-            processSubscribe(pk, srcAddress, srcPort);
+            processSubscribe(packet, srcAddress, srcPort);
             break;
 
         case MsgType::UNSUBSCRIBE:
             updateClientType(clientInfo, ClientType::SUBSCRIBER);
-            processUnsubscribe(pk, srcAddress, srcPort);
+            processUnsubscribe(packet, srcAddress, srcPort);
             break;
 
         case MsgType::REGACK:
-            processRegAck(pk, srcAddress, srcPort);
+            processRegAck(packet, srcAddress, srcPort);
             break;
 
         case MsgType::PUBACK:
-            processPubAck(pk, srcAddress, srcPort);
+            processPubAck(packet, srcAddress, srcPort);
             break;
 
         case MsgType::PUBREC:
-            processPubRec(pk, srcAddress, srcPort);
+            processPubRec(packet, srcAddress, srcPort);
             break;
 
         case MsgType::PUBCOMP:
-            processPubComp(pk, srcAddress, srcPort);
+            processPubComp(packet, srcAddress, srcPort);
             break;
 
         default:
@@ -473,9 +548,9 @@ void MqttSNServer::processSearchGw()
     MqttSNApp::sendGwInfo(gatewayId);
 }
 
-void MqttSNServer::processConnect(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processConnect(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNConnect>();
+    const auto& payload = packet.get<MqttSNConnect>();
 
     // prevent client connection when its protocol ID is not supported
     if (payload->getProtocolId() != 0x01) {
@@ -545,9 +620,9 @@ void MqttSNServer::processConnect(inet::Packet* pk, const inet::L3Address& srcAd
     sendBaseWithReturnCode(srcAddress, srcPort, MsgType::CONNACK, ReturnCode::ACCEPTED);
 }
 
-void MqttSNServer::processWillTopic(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate)
+void MqttSNServer::processWillTopic(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate)
 {
-    const auto& payload = pk->peekData<MqttSNBaseWithWillTopic>();
+    const auto& payload = packet.get<MqttSNBaseWithWillTopic>();
 
     // update publisher information
     PublisherInfo* publisherInfo = getPublisherInfo(srcAddress, srcPort, true);
@@ -563,9 +638,9 @@ void MqttSNServer::processWillTopic(inet::Packet* pk, const inet::L3Address& src
     MqttSNApp::sendBase(srcAddress, srcPort, MsgType::WILLMSGREQ);
 }
 
-void MqttSNServer::processWillMsg(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate)
+void MqttSNServer::processWillMsg(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate)
 {
-    const auto& payload = pk->peekData<MqttSNBaseWithWillMsg>();
+    const auto& payload = packet.get<MqttSNBaseWithWillMsg>();
 
     // update publisher information
     PublisherInfo* publisherInfo = getPublisherInfo(srcAddress, srcPort, true);
@@ -579,9 +654,9 @@ void MqttSNServer::processWillMsg(inet::Packet* pk, const inet::L3Address& srcAd
     sendBaseWithReturnCode(srcAddress, srcPort, MsgType::CONNACK, ReturnCode::ACCEPTED);
 }
 
-void MqttSNServer::processPingReq(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo)
+void MqttSNServer::processPingReq(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo)
 {
-    const auto& payload = pk->peekData<MqttSNPingReq>();
+    const auto& payload = packet.get<MqttSNPingReq>();
     std::string clientId = payload->getClientId();
 
     if (!clientId.empty()) {
@@ -608,12 +683,12 @@ void MqttSNServer::processPingResp(const inet::L3Address& srcAddress, const int&
     // update client information
     clientInfo->sentPingReq = false;
 
-    EV << "Received ping response from client: " << srcAddress << ":" << srcPort << std::endl;
+    MQTTSN_LOG_INFO(LogEvent::PING_RESPONSE_RECEIVED, srcPort, 0, "Received ping response from client: " << srcAddress << ":" << srcPort);
 }
 
-void MqttSNServer::processDisconnect(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo)
+void MqttSNServer::processDisconnect(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo)
 {
-    const auto& payload = pk->peekData<MqttSNDisconnect>();
+    const auto& payload = packet.get<MqttSNDisconnect>();
     uint16_t sleepDuration = payload->getDuration();
 
     // update client information
@@ -624,9 +699,9 @@ void MqttSNServer::processDisconnect(inet::Packet* pk, const inet::L3Address& sr
     MqttSNApp::sendDisconnect(srcAddress, srcPort, sleepDuration);
 }
 
-void MqttSNServer::processRegister(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processRegister(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNRegister>();
+    const auto& payload = packet.get<MqttSNRegister>();
     uint16_t topicId = payload->getTopicId();
     uint16_t msgId = payload->getMsgId();
 
@@ -646,6 +721,7 @@ void MqttSNServer::processRegister(inet::Packet* pk, const inet::L3Address& srcA
     // check if the topic is already registered; if yes, send ACCEPTED response, otherwise register the topic
     auto it = topicsToIds.find(encodedTopicName);
     if (it != topicsToIds.end()) {
+        updateTopicUsage(it->second);
         sendMsgIdWithTopicIdPlus(srcAddress, srcPort, MsgType::REGACK, it->second, msgId, ReturnCode::ACCEPTED);
         return;
     }
@@ -657,14 +733,15 @@ void MqttSNServer::processRegister(inet::Packet* pk, const inet::L3Address& srcA
     }
 
     addNewTopic(encodedTopicName, currentTopicId, getTopicIdType(topicLength));
+    updateTopicUsage(currentTopicId);
 
     // send REGACK response with the new topic ID and ACCEPTED status
     sendMsgIdWithTopicIdPlus(srcAddress, srcPort, MsgType::REGACK, currentTopicId, msgId, ReturnCode::ACCEPTED);
 }
 
-void MqttSNServer::processPublish(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processPublish(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNPublish>();
+    const auto& payload = packet.get<MqttSNPublish>();
     uint16_t topicId = payload->getTopicId();
     uint16_t msgId = payload->getMsgId();
 
@@ -683,6 +760,8 @@ void MqttSNServer::processPublish(inet::Packet* pk, const inet::L3Address& srcAd
         return;
     }
 
+    it->second.lastUsedTime = getClockTime();
+
     QoS qos = (QoS) payload->getQoSFlag();
     bool retain = payload->getRetainFlag();
 
@@ -693,16 +772,17 @@ void MqttSNServer::processPublish(inet::Packet* pk, const inet::L3Address& srcAd
     }
 
     bool dup = payload->getDupFlag();
-    std::string data = payload->getData();
+    const std::string& data = payload->getData();
 
     if (retain) {
         // add a new retained message for the specified topic
         addNewRetainMessage(topicId, dup, qos, topicIdType, data);
     }
 
-    TagInfo tagInfo;
-    tagInfo.timestamp = inet::ClockTime::SIMTIME_AS_CLOCKTIME(payload->findTag<inet::CreationTimeTag>()->getCreationTime());
-    tagInfo.identifier = payload->findTag<IdentifierTag>()->getIdentifier();
+    TagInfo tagInfo = PacketHelper::getPublishTagInfo(payload);
+    tagInfo.stageTimestamps[Stage::GATEWAY_RECEIVED] = getClockTime();
+
+    MqttSNApp::traceMessage(TraceEvent::GATEWAY_ACCEPT, tagInfo.identifier, msgId, qos, dup);
 
     MessageInfo messageInfo;
     messageInfo.topicId = topicId;
@@ -744,14 +824,15 @@ void MqttSNServer::processPublish(inet::Packet* pk, const inet::L3Address& srcAd
 
     // save message data for reuse
     publisherInfo->messages[msgId] = dataInfo;
+    persistPublisherMessage(srcAddress, srcPort, msgId, dataInfo);
 
     // send PUBlish RECeived
     sendBaseWithMsgId(srcAddress, srcPort, MsgType::PUBREC, msgId);
 }
 
-void MqttSNServer::processPublishMinusOne(inet::Packet* pk)
+void MqttSNServer::processPublishMinusOne(const PacketView& packet)
 {
-    const auto& payload = pk->peekData<MqttSNPublish>();
+    const auto& payload = packet.get<MqttSNPublish>();
     uint16_t topicId = payload->getTopicId();
     TopicIdType topicIdType = (TopicIdType) payload->getTopicIdTypeFlag();
 
@@ -761,9 +842,10 @@ void MqttSNServer::processPublishMinusOne(inet::Packet* pk)
         return;
     }
 
-    TagInfo tagInfo;
-    tagInfo.timestamp = inet::ClockTime::SIMTIME_AS_CLOCKTIME(payload->findTag<inet::CreationTimeTag>()->getCreationTime());;
-    tagInfo.identifier = payload->findTag<IdentifierTag>()->getIdentifier();
+    TagInfo tagInfo = PacketHelper::getPublishTagInfo(payload);
+    tagInfo.stageTimestamps[Stage::GATEWAY_RECEIVED] = getClockTime();
+
+    MqttSNApp::traceMessage(TraceEvent::GATEWAY_ACCEPT, tagInfo.identifier, 0, QoS::QOS_MINUS_ONE);
 
     MessageInfo messageInfo;
     messageInfo.topicId = topicId;
@@ -778,7 +860,7 @@ void MqttSNServer::processPublishMinusOne(inet::Packet* pk)
     dispatchPublishToSubscribers(messageInfo);
 }
 
-void MqttSNServer::processPubRel(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processPubRel(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
     // check if the publisher exists for the given key
     auto publisherIt = publishers.find(std::make_pair(srcAddress, srcPort));
@@ -786,7 +868,7 @@ void MqttSNServer::processPubRel(inet::Packet* pk, const inet::L3Address& srcAdd
         return;
     }
 
-    const auto& payload = pk->peekData<MqttSNBaseWithMsgId>();
+    const auto& payload = packet.get<MqttSNBaseWithMsgId>();
     uint16_t msgId = payload->getMsgId();
 
     // access the messages associated with the publisher
@@ -812,15 +894,16 @@ void MqttSNServer::processPubRel(inet::Packet* pk, const inet::L3Address& srcAdd
 
         // after processing, delete the message from the map
         messages.erase(messageIt);
+        persistPublisherMessageDeletion(srcAddress, srcPort, msgId);
     }
 
     // send PUBlish COMPlete
     sendBaseWithMsgId(srcAddress, srcPort, MsgType::PUBCOMP, msgId);
 }
 
-void MqttSNServer::processSubscribe(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processSubscribe(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNSubscribe>();
+    const auto& payload = packet.get<MqttSNSubscribe>();
     TopicIdType topicIdType = (TopicIdType) payload->getTopicIdTypeFlag();
     uint16_t topicId = payload->getTopicId();
 
@@ -879,9 +962,9 @@ void MqttSNServer::processSubscribe(inet::Packet* pk, const inet::L3Address& src
     sendSubAck(srcAddress, srcPort, qos, topicId, msgId, ReturnCode::ACCEPTED);
 }
 
-void MqttSNServer::processUnsubscribe(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processUnsubscribe(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNUnsubscribe>();
+    const auto& payload = packet.get<MqttSNUnsubscribe>();
     TopicIdType topicIdType = (TopicIdType) payload->getTopicIdTypeFlag();
     uint16_t topicId = payload->getTopicId();
 
@@ -907,9 +990,9 @@ void MqttSNServer::processUnsubscribe(inet::Packet* pk, const inet::L3Address& s
     sendBaseWithMsgId(srcAddress, srcPort, MsgType::UNSUBACK, payload->getMsgId());
 }
 
-void MqttSNServer::processRegAck(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processRegAck(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNMsgIdWithTopicIdPlus>();
+    const auto& payload = packet.get<MqttSNMsgIdWithTopicIdPlus>();
 
     // check if the ACK is correct; exit if not
     if (!processRegistrationAck(payload->getMsgId())) {
@@ -940,9 +1023,9 @@ void MqttSNServer::processRegAck(inet::Packet* pk, const inet::L3Address& srcAdd
     subscriberTopicInfo->isRegistered = true;
 }
 
-void MqttSNServer::processPubAck(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processPubAck(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNMsgIdWithTopicIdPlus>();
+    const auto& payload = packet.get<MqttSNMsgIdWithTopicIdPlus>();
     uint16_t msgId = payload->getMsgId();
 
     if (msgId > 0) {
@@ -966,16 +1049,14 @@ void MqttSNServer::processPubAck(inet::Packet* pk, const inet::L3Address& srcAdd
     }
 }
 
-void MqttSNServer::processPubRec(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processPubRec(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNBaseWithMsgId>();
+    const auto& payload = packet.get<MqttSNBaseWithMsgId>();
     uint16_t msgId = payload->getMsgId();
 
-    std::map<uint16_t, RequestInfo>::iterator requestIt;
-    std::set<uint16_t>::iterator requestIdIt;
-
     // check if the ACK is valid; exit if not
-    if (!isValidRequest(msgId, MsgType::PUBLISH, requestIt, requestIdIt)) {
+    RequestInfo* requestInfo = getValidRequest(msgId, MsgType::PUBLISH);
+    if (requestInfo == nullptr) {
         return;
     }
 
@@ -983,14 +1064,16 @@ void MqttSNServer::processPubRec(inet::Packet* pk, const inet::L3Address& srcAdd
     sendBaseWithMsgId(srcAddress, srcPort, MsgType::PUBREL, msgId);
 
     // update the request
-    requestIt->second.requestTime = getClockTime();
-    requestIt->second.retransmissionCounter = 0;
-    requestIt->second.messageType = MsgType::PUBREL;
+    requestInfo->requestTime = getClockTime();
+    requestInfo->retransmissionCounter = 0;
+    requestInfo->messageType = MsgType::PUBREL;
+
+    persistRequest(msgId, *requestInfo);
 }
 
-void MqttSNServer::processPubComp(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort)
+void MqttSNServer::processPubComp(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort)
 {
-    const auto& payload = pk->peekData<MqttSNBaseWithMsgId>();
+    const auto& payload = packet.get<MqttSNBaseWithMsgId>();
 
     // check if the ACK is correct; exit if not
     if (!processRequestAck(payload->getMsgId(), MsgType::PUBREL)) {
@@ -1008,9 +1091,10 @@ void MqttSNServer::sendAdvertise()
 
     inet::Packet* packet = new inet::Packet("AdvertisePacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    inet::L3Address destAddress = inet::L3Address(par("broadcastAddress"));
+    MqttSNApp::corruptPacket(packet, destAddress);
 
-    MqttSNApp::socket.sendTo(packet, inet::L3Address(par("broadcastAddress")), par("destPort"));
+    MqttSNApp::socket.sendTo(packet, destAddress, par("destPort"));
 }
 
 void MqttSNServer::sendBaseWithReturnCode(const inet::L3Address& destAddress, const int& destPort, MsgType msgType, ReturnCode returnCode)
@@ -1041,7 +1125,7 @@ void MqttSNServer::sendBaseWithReturnCode(const inet::L3Address& destAddress, co
 
     inet::Packet* packet = new inet::Packet(packetName.c_str());
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1050,7 +1134,7 @@ void MqttSNServer::sendMsgIdWithTopicIdPlus(const inet::L3Address& destAddress,
                                             uint16_t msgId, ReturnCode returnCode)
 {
     inet::Packet* packet = PacketHelper::getMsgIdWithTopicIdPlusPacket(msgType, topicId, msgId, returnCode);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1058,7 +1142,7 @@ void MqttSNServer::sendMsgIdWithTopicIdPlus(const inet::L3Address& destAddress,
 void MqttSNServer::sendBaseWithMsgId(const inet::L3Address& destAddress, const int& destPort, MsgType msgType, uint16_t msgId)
 {
     inet::Packet* packet = PacketHelper::getBaseWithMsgIdPacket(msgType, msgId);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1076,7 +1160,7 @@ void MqttSNServer::sendSubAck(const inet::L3Address& destAddress, const int& des
 
     inet::Packet* packet = new inet::Packet("SubAckPacket");
     packet->insertAtBack(payload);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1085,7 +1169,7 @@ void MqttSNServer::sendRegister(const inet::L3Address& destAddress, const int& d
                                 const std::string& topicName)
 {
     inet::Packet* packet = PacketHelper::getRegisterPacket(topicId, msgId, topicName);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    MqttSNApp::corruptPacket(packet, destAddress);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1093,8 +1177,15 @@ void MqttSNServer::sendRegister(const inet::L3Address& destAddress, const int& d
 void MqttSNServer::sendPublish(const inet::L3Address& destAddress, const int& destPort, bool dupFlag, QoS qosFlag, bool retainFlag,
                                TopicIdType topicIdTypeFlag, uint16_t topicId, uint16_t msgId, const std::string& data, const TagInfo& tagInfo)
 {
-    inet::Packet* packet = PacketHelper::getPublishPacket(dupFlag, qosFlag, retainFlag, topicIdTypeFlag, topicId, msgId, data, tagInfo);
-    MqttSNApp::corruptPacket(packet, MqttSNApp::packetBER);
+    // stamp the dispatch time on this copy of the tags
+    TagInfo dispatchedTagInfo = tagInfo;
+    dispatchedTagInfo.stageTimestamps[Stage::GATEWAY_DISPATCHED] = getClockTime();
+
+    inet::Packet* packet = PacketHelper::getPublishPacket(dupFlag, qosFlag, retainFlag, topicIdTypeFlag, topicId, msgId, data,
+                                                          dispatchedTagInfo);
+    MqttSNApp::corruptPacket(packet, destAddress);
+
+    MqttSNApp::traceMessage(TraceEvent::GATEWAY_DISPATCH, tagInfo.identifier, msgId, qosFlag, dupFlag);
 
     MqttSNApp::socket.sendTo(packet, destAddress, destPort);
 }
@@ -1173,16 +1264,10 @@ void MqttSNServer::handleRequestsCheckEvent()
     // structure to store allocated objects for future deallocation
     std::vector<MessageInfo*> allocatedObjects;
 
-    // iterate through the requests
-    for (auto requestIt = requests.begin(); requestIt != requests.end();) {
-        // find the same request ID in the set
-        auto requestIdIt = requestIds.find(requestIt->first);
-        if (requestIdIt == requestIds.end()) {
-            deleteRequest(requestIt, requestIdIt);
-            continue;
-        }
-
-        RequestInfo& requestInfo = requestIt->second;
+    // iterate through the requests in ID order; deleting the current request does not affect the next lookup
+    for (int32_t nextId = requests.nextId(0); nextId != -1; nextId = requests.nextId(nextId + 1)) {
+        uint16_t requestId = nextId;
+        RequestInfo& requestInfo = *requests.find(requestId);
 
         // retrieve subscriber address and port
         const inet::L3Address& subscriberAddress = requestInfo.subscriberAddress;
@@ -1193,17 +1278,22 @@ void MqttSNServer::handleRequestsCheckEvent()
 
         // check if the subscriber is in an ACTIVE or AWAKE state
         if (clientInfo->currentState != ClientState::ACTIVE && clientInfo->currentState != ClientState::AWAKE) {
-            ++requestIt;
             continue;
         }
 
         // get a message info pointer for regular or retained messages; memory allocation occurs for retained messages
         MessageInfo* messageInfo = getRequestMessageInfo(requestInfo, allocatedObjects);
 
+        // the message was cleared or the retained message was evicted
+        if (messageInfo == nullptr) {
+            deleteRequest(requestId);
+            continue;
+        }
+
         // check for an existing subscription
         std::pair<uint16_t, QoS> subscriptionKey;
         if (!findSubscription(subscriberAddress, subscriberPort, messageInfo->topicId, subscriptionKey)) {
-            deleteRequest(requestIt, requestIdIt);
+            deleteRequest(requestId);
             continue;
         }
 
@@ -1214,7 +1304,6 @@ void MqttSNServer::handleRequestsCheckEvent()
             // handle unregistered topic: initiate subscriber registration; the request will be processed later
             manageRegistration(subscriberAddress, subscriberPort, messageInfo->topicId);
 
-            ++requestIt;
             continue;
         }
 
@@ -1224,25 +1313,31 @@ void MqttSNServer::handleRequestsCheckEvent()
             // calculate the minimum QoS level between subscription QoS and original PUBLISH QoS
             resultQoS = NumericHelper::minQoS(subscriptionKey.second, messageInfo->qos);
 
+            // on its first transmission, the request time is when the delivery request was queued
+            TagInfo tagInfo = messageInfo->tagInfo;
+            if (requestInfo.sendAtLeastOnce) {
+                tagInfo.stageTimestamps[Stage::GATEWAY_BUFFERED] = requestInfo.requestTime;
+            }
+
             if (resultQoS == QoS::QOS_MINUS_ONE || resultQoS == QoS::QOS_ZERO) {
                 // send a PUBLISH message with QoS -1 or QoS 0 to the subscriber
                 sendPublish(subscriberAddress, subscriberPort, messageInfo->dup, resultQoS, messageInfo->retain,
-                            messageInfo->topicIdType, messageInfo->topicId, 0, messageInfo->data, messageInfo->tagInfo);
+                            messageInfo->topicIdType, messageInfo->topicId, 0, messageInfo->data, tagInfo);
 
-                deleteRequest(requestIt, requestIdIt);
+                deleteRequest(requestId);
                 continue;
             }
 
             if (requestInfo.sendAtLeastOnce) {
                 // send a PUBLISH message with QoS 1 or QoS 2 to the subscriber
                 sendPublish(subscriberAddress, subscriberPort, messageInfo->dup, resultQoS, messageInfo->retain,
-                            messageInfo->topicIdType, messageInfo->topicId, requestIt->first, messageInfo->data, messageInfo->tagInfo);
+                            messageInfo->topicIdType, messageInfo->topicId, requestId, messageInfo->data, tagInfo);
 
-                // update request information
+                // update request information; after a restart the request is sent again as a duplicate
                 requestInfo.sendAtLeastOnce = false;
                 requestInfo.requestTime = getClockTime();
 
-                ++requestIt;
+                persistRequest(requestId, requestInfo);
                 continue;
             }
         }
@@ -1251,30 +1346,32 @@ void MqttSNServer::handleRequestsCheckEvent()
         if ((getClockTime() - requestInfo.requestTime) > MqttSNApp::retransmissionInterval) {
             // check if the number of retries equals the threshold
             if (requestInfo.retransmissionCounter >= MqttSNApp::retransmissionCounter) {
-                deleteRequest(requestIt, requestIdIt);
+                deleteRequest(requestId);
                 continue;
             }
 
             resultQoS = NumericHelper::minQoS(subscriptionKey.second, messageInfo->qos);
 
             if (requestInfo.messageType == MsgType::PUBLISH) {
+                MqttSNApp::traceMessage(TraceEvent::GATEWAY_RETRANSMIT, messageInfo->tagInfo.identifier, requestId, resultQoS, true);
+
                 // send a PUBLISH message with QoS 1 or QoS 2 to the subscriber
                 sendPublish(subscriberAddress, subscriberPort, true, resultQoS, messageInfo->retain,
-                            messageInfo->topicIdType, messageInfo->topicId, requestIt->first, messageInfo->data, messageInfo->tagInfo);
+                            messageInfo->topicIdType, messageInfo->topicId, requestId, messageInfo->data, messageInfo->tagInfo);
             }
             else if (requestInfo.messageType == MsgType::PUBREL) {
                 // send PUBlish RELease
-                sendBaseWithMsgId(subscriberAddress, subscriberPort, MsgType::PUBREL, requestIt->first);
+                sendBaseWithMsgId(subscriberAddress, subscriberPort, MsgType::PUBREL, requestId);
             }
 
-            // update request information
+            // update request information; the retries left carry over a restart
             requestInfo.retransmissionCounter++;
             requestInfo.requestTime = getClockTime();
 
+            persistRequest(requestId, requestInfo);
+
             MqttSNApp::serversRetransmissions++;
         }
-
-        ++requestIt;
     }
 
     // deallocate objects
@@ -1285,27 +1382,21 @@ void MqttSNServer::handleRequestsCheckEvent()
 
 void MqttSNServer::handleRegistrationsCheckEvent()
 {
-    // iterate through the registrations
-    for (auto registrationIt = registrations.begin(); registrationIt != registrations.end();) {
-        // find the same registration ID in the set
-        auto registrationIdIt = registrationIds.find(registrationIt->first);
-        if (registrationIdIt == registrationIds.end()) {
-            deleteRegistration(registrationIt, registrationIdIt);
-            continue;
-        }
-
-        RegisterInfo& registerInfo = registrationIt->second;
+    // iterate through the registrations in ID order
+    for (int32_t nextId = registrations.nextId(0); nextId != -1; nextId = registrations.nextId(nextId + 1)) {
+        uint16_t registrationId = nextId;
+        RegisterInfo& registerInfo = *registrations.find(registrationId);
 
         // check if the elapsed time from last received message is beyond the retransmission duration
         if ((getClockTime() - registerInfo.requestTime) > MqttSNApp::retransmissionInterval) {
             // check if the number of retries equals the threshold
             if (registerInfo.retransmissionCounter >= MqttSNApp::retransmissionCounter) {
-                deleteRegistration(registrationIt, registrationIdIt);
+                deleteRegistration(registrationId);
                 continue;
             }
 
             sendRegister(registerInfo.subscriberAddress, registerInfo.subscriberPort, registerInfo.topicId,
-                         registrationIt->first, registerInfo.topicName);
+                         registrationId, registerInfo.topicName);
 
             // update the registration
             registerInfo.retransmissionCounter++;
@@ -1313,8 +1404,6 @@ void MqttSNServer::handleRegistrationsCheckEvent()
 
             MqttSNApp::serversRetransmissions++;
         }
-
-        ++registrationIt;
     }
 
     scheduleClockEventAfter(registrationsCheckInterval, registrationsCheckEvent);
@@ -1341,8 +1430,9 @@ void MqttSNServer::handleAwakenSubscriberCheckEvent(omnetpp::cMessage* msg)
         MqttSNApp::retransmissionCounter * MqttSNApp::retransmissionInterval) {
 
         // search if there is at least one pending request for the subscriber in AWAKE state
-        for (const auto& request : requests) {
-            if (request.second.subscriberAddress == subscriberAddress && request.second.subscriberPort == subscriberPort) {
+        for (int32_t requestId = requests.nextId(0); requestId != -1; requestId = requests.nextId(requestId + 1)) {
+            const RequestInfo* requestInfo = requests.find(requestId);
+            if (requestInfo->subscriberAddress == subscriberAddress && requestInfo->subscriberPort == subscriberPort) {
                 // if there is a pending request, reschedule and check again next time
                 scheduleClockEventAfter(awakenSubscriberCheckInterval, subscriberInfo.awakenSubscriberCheckEvent);
                 return;
@@ -1364,34 +1454,65 @@ void MqttSNServer::handleAwakenSubscriberCheckEvent(omnetpp::cMessage* msg)
 
 void MqttSNServer::handleMessagesClearEvent()
 {
-    // iterate through messages
-    for (auto messageIt = messages.begin(); messageIt != messages.end();) {
-        // find the same message ID in the set
-        auto messageIdIt = messageIds.find(messageIt->first);
-        if (messageIdIt == messageIds.end()) {
-            throw omnetpp::cRuntimeError("Mismatch between message structures during message clearance");
+    // collect the messages used by at least one request in a single pass over the requests
+    IdSlab<bool> usedMessages;
+    for (int32_t requestId = requests.nextId(0); requestId != -1; requestId = requests.nextId(requestId + 1)) {
+        uint16_t messagesKey = requests.find(requestId)->messagesKey;
+        if (messagesKey > 0) {
+            usedMessages.insert(messagesKey, true);
         }
+    }
 
-        bool isUsed = false;
-
-        // check if the message is used in at least one request
-        for (auto requestIt = requests.begin(); requestIt != requests.end(); ++requestIt) {
-            if (requestIt->second.messagesKey == messageIt->first) {
-                isUsed = true;
-                break;
-            }
+    // remove the messages that are not used
+    for (int32_t messageId = messages.nextId(0); messageId != -1; messageId = messages.nextId(messageId + 1)) {
+        if (!usedMessages.contains(messageId)) {
+            deleteMessage(messageId);
         }
+    }
 
-        // if the message is not used, remove it
-        if (!isUsed) {
-            deleteMessage(messageIt, messageIdIt);
+    // remove the retained messages whose time to live has elapsed
+    std::vector<uint16_t> expiredIds;
+    retainMessages.expire(getClockTime().dbl(), expiredIds);
+    releaseRetainedTopics(expiredIds);
+
+    scheduleClockEventAfter(messagesClearInterval, messagesClearEvent);
+}
+
+void MqttSNServer::handleTopicsCheckEvent()
+{
+    inet::clocktime_t currentTime = getClockTime();
+
+    for (auto it = idsToTopics.begin(); it != idsToTopics.end();) {
+        const TopicInfo& topicInfo = it->second;
+
+        // predefined topics and topics still in use are never evicted
+        if (topicInfo.topicIdType == TopicIdType::PRE_DEFINED_TOPIC_ID || topicInfo.references > 0 ||
+            (currentTime - topicInfo.lastUsedTime) < topicIdleTimeout) {
+
+            ++it;
             continue;
         }
 
-        ++messageIt;
+        uint16_t topicId = it->first;
+        ++it;
+
+        deleteTopic(topicId);
+        evictedTopicsCounter++;
     }
 
-    scheduleClockEventAfter(messagesClearInterval, messagesClearEvent);
+    scheduleClockEventAfter(topicsCheckInterval, topicsCheckEvent);
+}
+
+void MqttSNServer::handleWalCommitEvent()
+{
+    // group commit of the records written during the last window
+    writeAheadLog.commit();
+
+    if (walCheckpointSize > 0 && writeAheadLog.getFileBytes() > (uint64_t) walCheckpointSize) {
+        checkpointState();
+    }
+
+    scheduleClockEventAfter(walCommitInterval, walCommitEvent);
 }
 
 void MqttSNServer::cleanClientSession(const inet::L3Address& clientAddress, const int& clientPort, ClientType clientType)
@@ -1480,9 +1601,9 @@ PublisherInfo* MqttSNServer::getPublisherInfo(const inet::L3Address& publisherAd
 void MqttSNServer::fillWithPredefinedTopics()
 {
     // retrieve predefined topics and their IDs
-    std::map<std::string, uint16_t> predefinedTopics = MqttSNApp::getPredefinedTopics();
+    const std::map<std::string, uint16_t>* predefinedTopics = MqttSNApp::getPredefinedTopics();
 
-    for (const auto& topic : predefinedTopics) {
+    for (const auto& topic : *predefinedTopics) {
         addNewTopic(topic.first, topic.second, TopicIdType::PRE_DEFINED_TOPIC_ID);
     }
 }
@@ -1526,6 +1647,52 @@ TopicInfo MqttSNServer::getTopicById(uint16_t topicId)
     return it->second;
 }
 
+void MqttSNServer::acquireTopic(uint16_t topicId)
+{
+    auto it = idsToTopics.find(topicId);
+    if (it != idsToTopics.end()) {
+        it->second.references++;
+        it->second.lastUsedTime = getClockTime();
+    }
+}
+
+void MqttSNServer::releaseTopic(uint16_t topicId)
+{
+    auto it = idsToTopics.find(topicId);
+    if (it == idsToTopics.end()) {
+        return;
+    }
+
+    if (it->second.references <= 0) {
+        throw omnetpp::cRuntimeError("Topic reference count cannot be negative");
+    }
+
+    // the idle time of an unreferenced topic starts from its last release
+    it->second.references--;
+    it->second.lastUsedTime = getClockTime();
+}
+
+void MqttSNServer::updateTopicUsage(uint16_t topicId)
+{
+    auto it = idsToTopics.find(topicId);
+    if (it != idsToTopics.end()) {
+        it->second.lastUsedTime = getClockTime();
+    }
+}
+
+void MqttSNServer::deleteTopic(uint16_t topicId)
+{
+    auto it = idsToTopics.find(topicId);
+    if (it == idsToTopics.end()) {
+        return;
+    }
+
+    // remove the topic from the data structures, freeing its ID for reuse
+    topicsToIds.erase(it->second.topicName);
+    idsToTopics.erase(it);
+    topicIds.erase(topicId);
+}
+
 TopicIdType MqttSNServer::getTopicIdType(uint16_t topicLength)
 {
     if (topicLength == Length::TWO_OCTETS) {
@@ -1545,29 +1712,51 @@ void MqttSNServer::addNewRetainMessage(uint16_t topicId, bool dup, QoS qos, Topi
     retainMessageInfo.dup = dup;
     retainMessageInfo.qos = qos;
     retainMessageInfo.topicIdType = topicIdType;
-    retainMessageInfo.data = data;
 
-    retainMessages[topicId] = retainMessageInfo;
-    retainMessageIds.insert(topicId);
+    bool isNewTopic = !retainMessages.contains(topicId);
+    std::vector<uint16_t> evictedIds;
+
+    if (retainMessages.put(topicId, retainMessageInfo, data, getClockTime().dbl(), evictedIds)) {
+        // the retained message holds a reference on its topic
+        if (isNewTopic) {
+            acquireTopic(topicId);
+        }
+
+        persistRetainMessage(topicId, retainMessageInfo, data);
+    }
+    else if (retainMessages.erase(topicId)) {
+        // a message that cannot be retained still replaces the previous one
+        releaseTopic(topicId);
+        persistRetainMessageDeletion(topicId);
+    }
+
+    releaseRetainedTopics(evictedIds);
+    retainedBytesVector.record(retainMessages.getUsedBytes());
+}
+
+void MqttSNServer::releaseRetainedTopics(const std::vector<uint16_t>& topicIds)
+{
+    // release the topic references of evicted or expired retained messages
+    for (uint16_t topicId : topicIds) {
+        releaseTopic(topicId);
+        persistRetainMessageDeletion(topicId);
+    }
 }
 
 void MqttSNServer::addNewPendingRetainMessage(const inet::L3Address& subscriberAddress, const int& subscriberPort, uint16_t topicId, QoS qos)
 {
     // check for retained message on the subscribed topic
-    auto retainMsgIt = retainMessages.find(topicId);
-    if (retainMsgIt != retainMessages.end()) {
-        // retrieve retained message information
-        const RetainMessageInfo& retainMessageInfo = retainMsgIt->second;
-
+    const RetainMessageInfo* retainMessageInfo = retainMessages.find(topicId, getClockTime().dbl());
+    if (retainMessageInfo != nullptr) {
         MessageInfo messageInfo;
         messageInfo.topicId = topicId;
-        messageInfo.topicIdType = retainMessageInfo.topicIdType;
-        messageInfo.dup = retainMessageInfo.dup;
+        messageInfo.topicIdType = retainMessageInfo->topicIdType;
+        messageInfo.dup = retainMessageInfo->dup;
         messageInfo.retain = true;
-        messageInfo.data = retainMessageInfo.data;
+        retainMessages.readData(topicId, messageInfo.data);
 
         // calculate the minimum QoS level between subscription QoS and original PUBLISH QoS
-        messageInfo.qos = NumericHelper::minQoS(qos, retainMessageInfo.qos);
+        messageInfo.qos = NumericHelper::minQoS(qos, retainMessageInfo->qos);
 
         // store the pending retain message for the subscriber
         pendingRetainMessages[std::make_pair(subscriberAddress, subscriberPort)] = messageInfo;
@@ -1577,12 +1766,14 @@ void MqttSNServer::addNewPendingRetainMessage(const inet::L3Address& subscriberA
 void MqttSNServer::addNewMessage(const MessageInfo& messageInfo)
 {
     // set new available message ID if possible; otherwise, throw an exception
-    MqttSNApp::getNewIdentifier(messageIds, currentMessageId,
-                                "Failed to assign a new message ID. All available message IDs are in use");
+    if (!messages.setNextAvailableId(currentMessageId)) {
+        throw omnetpp::cRuntimeError("Failed to assign a new message ID. All available message IDs are in use");
+    }
 
-    // add the new message in the data structures
-    messages[currentMessageId] = messageInfo;
-    messageIds.insert(currentMessageId);
+    messages.insert(currentMessageId, messageInfo);
+    acquireTopic(messageInfo.topicId);
+
+    persistMessage(currentMessageId, messageInfo);
 }
 
 void MqttSNServer::addAndMarkMessage(const MessageInfo& messageInfo, bool& isMessageAdded)
@@ -1591,11 +1782,17 @@ void MqttSNServer::addAndMarkMessage(const MessageInfo& messageInfo, bool& isMes
     isMessageAdded = true;
 }
 
-void MqttSNServer::deleteMessage(std::map<uint16_t, MessageInfo>::iterator& messageIt, std::set<uint16_t>::iterator& messageIdIt)
+void MqttSNServer::deleteMessage(uint16_t messageId)
 {
-    // remove the message from both structures
-    messageIt = messages.erase(messageIt);
-    messageIdIt = messageIds.erase(messageIdIt);
+    MessageInfo* messageInfo = messages.find(messageId);
+    if (messageInfo == nullptr) {
+        return;
+    }
+
+    releaseTopic(messageInfo->topicId);
+    messages.erase(messageId);
+
+    persistMessageDeletion(messageId);
 }
 
 void MqttSNServer::deleteAllocatedMessages(const std::vector<MessageInfo*>& messages)
@@ -1611,30 +1808,23 @@ MessageInfo* MqttSNServer::getRequestMessageInfo(const RequestInfo& requestInfo,
     MessageInfo* messageInfo = nullptr;
 
     if (requestInfo.messagesKey > 0) {
-        // check if the key exists in the messages map
-        auto messageIt = messages.find(requestInfo.messagesKey);
-        if (messageIt != messages.end()) {
-            messageInfo = &messageIt->second;
-        }
-
-        return messageInfo;
+        // the message may have been cleared already
+        return messages.find(requestInfo.messagesKey);
     }
     else if (requestInfo.retainMessagesKey > 0) {
-        // check if the key exists in the retain messages map
-        auto retainMessageIt = retainMessages.find(requestInfo.retainMessagesKey);
-        if (retainMessageIt != retainMessages.end()) {
-            const RetainMessageInfo& retainMessageInfo = retainMessageIt->second;
-
+        // check if the topic still has a live retained message
+        const RetainMessageInfo* retainMessageInfo = retainMessages.find(requestInfo.retainMessagesKey, getClockTime().dbl());
+        if (retainMessageInfo != nullptr) {
             // allocate memory for a new object
             messageInfo = new MessageInfo;
 
             // populate the fields of the new object
             messageInfo->topicId = requestInfo.retainMessagesKey;
-            messageInfo->topicIdType = retainMessageInfo.topicIdType;
-            messageInfo->dup = retainMessageInfo.dup;
-            messageInfo->qos = retainMessageInfo.qos;
+            messageInfo->topicIdType = retainMessageInfo->topicIdType;
+            messageInfo->dup = retainMessageInfo->dup;
+            messageInfo->qos = retainMessageInfo->qos;
             messageInfo->retain = true;
-            messageInfo->data = retainMessageInfo.data;
+            retainMessages.readData(requestInfo.retainMessagesKey, messageInfo->data);
 
             // add the object pointer to the vector for future deallocation
             allocatedObjects.push_back(messageInfo);
@@ -1651,6 +1841,9 @@ void MqttSNServer::dispatchPublishToSubscribers(const MessageInfo& messageInfo)
     // set to track whether a new message needs to be added
     bool isMessageAdded = false;
 
+    // number of subscribers the message is handed to
+    uint32_t fanOut = 0;
+
     // keys with the same topic ID
     std::set<std::pair<uint16_t, QoS>> keys = getSubscriptionKeysByTopicId(messageInfo.topicId);
 
@@ -1688,11 +1881,15 @@ void MqttSNServer::dispatchPublishToSubscribers(const MessageInfo& messageInfo)
                         break;
 
                     default:
-                        break;
+                        continue;
                 }
+
+                fanOut++;
             }
         }
     }
+
+    MqttSNApp::traceMessage(TraceEvent::GATEWAY_FANOUT, messageInfo.tagInfo.identifier, fanOut, messageInfo.qos, messageInfo.dup);
 }
 
 void MqttSNServer::processRequestForActiveSubscriber(const inet::L3Address& subscriberAddress, int subscriberPort,
@@ -1763,8 +1960,9 @@ void MqttSNServer::addNewRequest(const inet::L3Address& subscriberAddress, const
     }
 
     // set new available request ID if possible; otherwise, throw an exception
-    MqttSNApp::getNewIdentifier(requestIds, currentRequestId,
-                                "Failed to assign a new request ID. All available request IDs are in use");
+    if (!requests.setNextAvailableId(currentRequestId)) {
+        throw omnetpp::cRuntimeError("Failed to assign a new request ID. All available request IDs are in use");
+    }
 
     RequestInfo requestInfo;
     requestInfo.requestTime = getClockTime();
@@ -1781,52 +1979,46 @@ void MqttSNServer::addNewRequest(const inet::L3Address& subscriberAddress, const
         requestInfo.retainMessagesKey = retainMessagesKey;
     }
 
-    // add the new request in the data structures
-    requests[currentRequestId] = requestInfo;
-    requestIds.insert(currentRequestId);
+    requests.insert(currentRequestId, requestInfo);
+    persistRequest(currentRequestId, requestInfo);
 }
 
-void MqttSNServer::deleteRequest(std::map<uint16_t, RequestInfo>::iterator& requestIt, std::set<uint16_t>::iterator& requestIdIt)
+void MqttSNServer::deleteRequest(uint16_t requestId)
 {
-    // remove the request from both structures
-    requestIt = requests.erase(requestIt);
-    requestIdIt = requestIds.erase(requestIdIt);
+    if (requests.erase(requestId)) {
+        persistRequestDeletion(requestId);
+    }
 }
 
-bool MqttSNServer::isValidRequest(uint16_t requestId, MsgType messageType, std::map<uint16_t, RequestInfo>::iterator& requestIt,
-                                  std::set<uint16_t>::iterator& requestIdIt)
+RequestInfo* MqttSNServer::getValidRequest(uint16_t requestId, MsgType messageType)
 {
-    // search for the request ID in the map
-    requestIt = requests.find(requestId);
-    if (requestIt == requests.end()) {
-        return false;
-    }
-
-    // check if the request message type matches
-    if (requestIt->second.messageType != messageType) {
-        return false;
-    }
+    RequestInfo* requestInfo = requests.find(requestId);
 
-    // search for the request ID in the set
-    requestIdIt = requestIds.find(requestId);
-    if (requestIdIt == requestIds.end()) {
-        return false;
+    // the request must exist and its message type must match
+    if (requestInfo == nullptr || requestInfo->messageType != messageType) {
+        return nullptr;
     }
 
-    return true;
+    return requestInfo;
 }
 
 bool MqttSNServer::processRequestAck(uint16_t requestId, MsgType messageType)
 {
-    std::map<uint16_t, RequestInfo>::iterator requestIt;
-    std::set<uint16_t>::iterator requestIdIt;
-
-    // check if the request is valid and retrieve iterators
-    if (!isValidRequest(requestId, messageType, requestIt, requestIdIt)) {
+    // check if the request is valid
+    RequestInfo* requestInfo = getValidRequest(requestId, messageType);
+    if (requestInfo == nullptr) {
         return false;
     }
 
-    deleteRequest(requestIt, requestIdIt);
+    if (MessageTracer::isEnabled()) {
+        // the subscriber acknowledged the message referenced by the request
+        const MessageInfo* messageInfo = messages.find(requestInfo->messagesKey);
+        if (messageInfo != nullptr) {
+            MqttSNApp::traceMessage(TraceEvent::GATEWAY_ACK, messageInfo->tagInfo.identifier, requestId, messageInfo->qos);
+        }
+    }
+
+    deleteRequest(requestId);
     return true;
 }
 
@@ -1847,8 +2039,9 @@ void MqttSNServer::addNewRegistration(const inet::L3Address& subscriberAddress,
                                       uint16_t topicId)
 {
     // set new available registration ID if possible; otherwise, throw an exception
-    MqttSNApp::getNewIdentifier(registrationIds, currentRegistrationId,
-                                "Failed to assign a new registration ID. All available registration IDs are in use");
+    if (!registrations.setNextAvailableId(currentRegistrationId)) {
+        throw omnetpp::cRuntimeError("Failed to assign a new registration ID. All available registration IDs are in use");
+    }
 
     RegisterInfo registerInfo;
     registerInfo.requestTime = getClockTime();
@@ -1857,36 +2050,29 @@ void MqttSNServer::addNewRegistration(const inet::L3Address& subscriberAddress,
     registerInfo.topicName = topicName;
     registerInfo.topicId = topicId;
 
-    // add the new registration in the data structures
-    registrations[currentRegistrationId] = registerInfo;
-    registrationIds.insert(currentRegistrationId);
+    registrations.insert(currentRegistrationId, registerInfo);
+    acquireTopic(topicId);
 }
 
-void MqttSNServer::deleteRegistration(std::map<uint16_t, RegisterInfo>::iterator& registrationIt, std::set<uint16_t>::iterator& registrationIdIt)
+void MqttSNServer::deleteRegistration(uint16_t registrationId)
 {
-    // remove the registration from both structures
-    registrationIt = registrations.erase(registrationIt);
-    registrationIdIt = registrationIds.erase(registrationIdIt);
+    RegisterInfo* registerInfo = registrations.find(registrationId);
+    if (registerInfo == nullptr) {
+        return;
+    }
+
+    releaseTopic(registerInfo->topicId);
+    registrations.erase(registrationId);
 }
 
 bool MqttSNServer::processRegistrationAck(uint16_t registrationId)
 {
-    std::map<uint16_t, RegisterInfo>::iterator registrationIt;
-    std::set<uint16_t>::iterator registrationIdIt;
-
-    // search for the registration ID in the map
-    registrationIt = registrations.find(registrationId);
-    if (registrationIt == registrations.end()) {
+    // search for the registration ID
+    if (!registrations.contains(registrationId)) {
         return false;
     }
 
-    // search for the registration ID in the set
-    registrationIdIt = registrationIds.find(registrationId);
-    if (registrationIdIt == registrationIds.end()) {
-        return false;
-    }
-
-    deleteRegistration(registrationIt, registrationIdIt);
+    deleteRegistration(registrationId);
     return true;
 }
 
@@ -2084,6 +2270,8 @@ bool MqttSNServer::insertSubscription(const inet::L3Address& subscriberAddress,
 
     subscriberInfo->subscriberTopics[topicId] = subscriberTopicInfo;
 
+    acquireTopic(topicId);
+
     // return true if the insertion is successful
     return true;
 }
@@ -2125,6 +2313,8 @@ bool MqttSNServer::deleteSubscription(const inet::L3Address& subscriberAddress,
             SubscriberInfo* subscriberInfo = getSubscriberInfo(subscriberAddress, subscriberPort, true);
             subscriberInfo->subscriberTopics.erase(subscriptionKey.first);
 
+            releaseTopic(subscriptionKey.first);
+
             // delete operation is successful
             return true;
         }
@@ -2160,34 +2350,16 @@ bool MqttSNServer::checkClientsCongestion()
     return clients.size() >= (unsigned int) par("maximumClients");
 }
 
-bool MqttSNServer::checkIDSpaceCongestion(const std::set<uint16_t>& usedIds, bool allowMaxValue)
-{
-    // check for invalid message ID; ID=0 is invalid
-    if (usedIds.find(0) != usedIds.end()) {
-        throw omnetpp::cRuntimeError("Invalid message ID=0 detected in the set");
-    }
-
-    // check for invalid message ID; ID=UINT16_MAX can be considered invalid
-    if (!allowMaxValue && usedIds.find(UINT16_MAX) != usedIds.end()) {
-        throw omnetpp::cRuntimeError("Invalid message ID=UINT16_MAX detected in the set");
-    }
-
-    uint16_t maxValue = allowMaxValue ? UINT16_MAX : UINT16_MAX - 1;
-
-    // check if the size equals the maximum valid range of IDs
-    return (usedIds.size() == maxValue);
-}
-
 bool MqttSNServer::checkPublishCongestion(QoS qos, bool retain)
 {
     // check congestion for retained messages
-    if (retain && checkIDSpaceCongestion(retainMessageIds, false)) {
+    if (retain && retainMessages.isFull()) {
         return true;
     }
 
     // check congestion for QoS levels 1 and 2
     if (qos == QoS::QOS_ONE || qos == QoS::QOS_TWO) {
-        return (checkIDSpaceCongestion(requestIds) || checkIDSpaceCongestion(messageIds));
+        return (requests.isFull() || messages.isFull());
     }
 
     // no congestion detected
@@ -2216,6 +2388,264 @@ void MqttSNServer::clearSubscribersData()
     }
 }
 
+void MqttSNServer::initializePersistence()
+{
+    walCommitInterval = par("walCommitInterval");
+    walCheckpointSize = par("walCheckpointSize");
+    walCommitEvent = new inet::ClockEvent("walCommitTimer");
+
+    std::string walFile = par("walFile").stdstringValue();
+    if (!walFile.empty()) {
+        writeAheadLog.open(walFile);
+    }
+}
+
+void MqttSNServer::persistMessage(uint16_t messageId, const MessageInfo& messageInfo)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::MESSAGE_PUT);
+    writeAheadLog.write<uint16_t>(messageId);
+    PersistenceHelper::writeMessageInfo(writeAheadLog, messageInfo);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistMessageDeletion(uint16_t messageId)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::MESSAGE_DELETE);
+    writeAheadLog.write<uint16_t>(messageId);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistRequest(uint16_t requestId, const RequestInfo& requestInfo)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::REQUEST_PUT);
+    writeAheadLog.write<uint16_t>(requestId);
+    PersistenceHelper::writeRequestInfo(writeAheadLog, requestInfo);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistRequestDeletion(uint16_t requestId)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::REQUEST_DELETE);
+    writeAheadLog.write<uint16_t>(requestId);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistPublisherMessage(const inet::L3Address& publisherAddress, const int& publisherPort, uint16_t msgId,
+                                           const DataInfo& dataInfo)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::PUBLISHER_MESSAGE_PUT);
+    PersistenceHelper::writeAddress(writeAheadLog, publisherAddress);
+    writeAheadLog.write<int32_t>(publisherPort);
+    writeAheadLog.write<uint16_t>(msgId);
+    PersistenceHelper::writeDataInfo(writeAheadLog, dataInfo);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistPublisherMessageDeletion(const inet::L3Address& publisherAddress, const int& publisherPort, uint16_t msgId)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::PUBLISHER_MESSAGE_DELETE);
+    PersistenceHelper::writeAddress(writeAheadLog, publisherAddress);
+    writeAheadLog.write<int32_t>(publisherPort);
+    writeAheadLog.write<uint16_t>(msgId);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistRetainMessage(uint16_t topicId, const RetainMessageInfo& retainMessageInfo, const std::string& data)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::RETAINED_PUT);
+    writeAheadLog.write<uint16_t>(topicId);
+    PersistenceHelper::writeRetainMessageInfo(writeAheadLog, retainMessageInfo);
+    writeAheadLog.writeString(data);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::persistRetainMessageDeletion(uint16_t topicId)
+{
+    if (!writeAheadLog.isEnabled()) {
+        return;
+    }
+
+    writeAheadLog.beginRecord(WalRecordType::RETAINED_DELETE);
+    writeAheadLog.write<uint16_t>(topicId);
+    writeAheadLog.endRecord();
+}
+
+void MqttSNServer::checkpointState()
+{
+    // the snapshot covers the uncommitted changes as well
+    writeAheadLog.discardPending();
+
+    for (int32_t messageId = messages.nextId(0); messageId != -1; messageId = messages.nextId(messageId + 1)) {
+        persistMessage(messageId, *messages.find(messageId));
+    }
+
+    for (int32_t requestId = requests.nextId(0); requestId != -1; requestId = requests.nextId(requestId + 1)) {
+        persistRequest(requestId, *requests.find(requestId));
+    }
+
+    for (const auto& publisherPair : publishers) {
+        for (const auto& messagePair : publisherPair.second.messages) {
+            persistPublisherMessage(publisherPair.first.first, publisherPair.first.second, messagePair.first, messagePair.second);
+        }
+    }
+
+    std::string data;
+    for (int32_t topicId = retainMessages.nextId(0); topicId != -1; topicId = retainMessages.nextId(topicId + 1)) {
+        retainMessages.readData(topicId, data);
+        persistRetainMessage(topicId, *retainMessages.peek(topicId), data);
+    }
+
+    writeAheadLog.checkpoint();
+}
+
+void MqttSNServer::clearPersistentState()
+{
+    // drop the state covered by the log without logging the removals
+    for (int32_t messageId = messages.nextId(0); messageId != -1; messageId = messages.nextId(messageId + 1)) {
+        releaseTopic(messages.find(messageId)->topicId);
+    }
+
+    for (int32_t topicId = retainMessages.nextId(0); topicId != -1; topicId = retainMessages.nextId(topicId + 1)) {
+        releaseTopic(topicId);
+    }
+
+    messages.clear();
+    requests.clear();
+    retainMessages.clear();
+    pendingRetainMessages.clear();
+    clearPublishersData();
+}
+
+void MqttSNServer::recoverState()
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<char> records;
+    WriteAheadLog::load(writeAheadLog.getFileName(), records);
+
+    WalReader reader(records);
+    WalRecordType type;
+    uint64_t recordCount = 0;
+
+    std::vector<uint16_t> evictedIds;
+    double currentTime = getClockTime().dbl();
+
+    while (reader.next(type)) {
+        switch (type) {
+            case WalRecordType::MESSAGE_PUT: {
+                uint16_t messageId = reader.read<uint16_t>();
+                messages.insert(messageId, PersistenceHelper::readMessageInfo(reader));
+                break;
+            }
+
+            case WalRecordType::MESSAGE_DELETE:
+                messages.erase(reader.read<uint16_t>());
+                break;
+
+            case WalRecordType::REQUEST_PUT: {
+                uint16_t requestId = reader.read<uint16_t>();
+                RequestInfo requestInfo = PersistenceHelper::readRequestInfo(reader);
+
+                // the retransmission timer starts over after the restart; the retries already made are kept
+                requestInfo.requestTime = getClockTime();
+                requests.insert(requestId, requestInfo);
+                break;
+            }
+
+            case WalRecordType::REQUEST_DELETE:
+                requests.erase(reader.read<uint16_t>());
+                break;
+
+            case WalRecordType::PUBLISHER_MESSAGE_PUT: {
+                inet::L3Address publisherAddress = PersistenceHelper::readAddress(reader);
+                int publisherPort = reader.read<int32_t>();
+                uint16_t msgId = reader.read<uint16_t>();
+
+                getPublisherInfo(publisherAddress, publisherPort, true)->messages[msgId] = PersistenceHelper::readDataInfo(reader);
+                break;
+            }
+
+            case WalRecordType::PUBLISHER_MESSAGE_DELETE: {
+                inet::L3Address publisherAddress = PersistenceHelper::readAddress(reader);
+                int publisherPort = reader.read<int32_t>();
+
+                PublisherInfo* publisherInfo = getPublisherInfo(publisherAddress, publisherPort);
+                if (publisherInfo != nullptr) {
+                    publisherInfo->messages.erase(reader.read<uint16_t>());
+                }
+                break;
+            }
+
+            case WalRecordType::RETAINED_PUT: {
+                uint16_t topicId = reader.read<uint16_t>();
+                RetainMessageInfo retainMessageInfo = PersistenceHelper::readRetainMessageInfo(reader);
+
+                retainMessages.put(topicId, retainMessageInfo, reader.readString(), currentTime, evictedIds);
+                break;
+            }
+
+            case WalRecordType::RETAINED_DELETE:
+                retainMessages.erase(reader.read<uint16_t>());
+                break;
+
+            default:
+                throw omnetpp::cRuntimeError("Unknown write-ahead log record type: %d", type);
+        }
+
+        recordCount++;
+    }
+
+    // restore the topic references held by the recovered state
+    for (int32_t messageId = messages.nextId(0); messageId != -1; messageId = messages.nextId(messageId + 1)) {
+        acquireTopic(messages.find(messageId)->topicId);
+    }
+
+    for (int32_t topicId = retainMessages.nextId(0); topicId != -1; topicId = retainMessages.nextId(topicId + 1)) {
+        acquireTopic(topicId);
+    }
+
+    // compact the log so that the next recovery starts from the recovered state
+    checkpointState();
+
+    double elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    walRecoveries++;
+    walRecoveredRecords += recordCount;
+    walRecoveryTime += elapsedTime;
+    recoveryPending = false;
+
+    EV_INFO << "Recovered " << recordCount << " log records in " << elapsedTime << "s - Messages: " << messages.size()
+            << ", Requests: " << requests.size() << ", Retained: " << retainMessages.size() << std::endl;
+}
+
 MqttSNServer::~MqttSNServer()
 {
     cancelAndDelete(stateChangeEvent);
@@ -2226,6 +2656,8 @@ MqttSNServer::~MqttSNServer()
     cancelAndDelete(requestsCheckEvent);
     cancelAndDelete(registrationsCheckEvent);
     cancelAndDelete(messagesClearEvent);
+    cancelAndDelete(topicsCheckEvent);
+    cancelAndDelete(walCommitEvent);
 }
 
 } /* namespace mqttsn */
@@ -35,6 +35,10 @@
 #include "types/server/RegisterInfo.h"
 #include "types/server/SubscriberTopicInfo.h"
 #include "types/server/SubscriberInfo.h"
+#include "types/server/PacketView.h"
+#include "containers/IdSlab.h"
+#include "containers/RetainedStore.h"
+#include "persistence/WriteAheadLog.h"
 
 namespace mqttsn {
 
@@ -50,6 +54,13 @@ class MqttSNServer : public MqttSNApp
         double registrationsCheckInterval;
         double awakenSubscriberCheckInterval;
         double messagesClearInterval;
+        double topicsCheckInterval;
+        double topicIdleTimeout;
+        int retainedMemoryLimit;
+        int retainedMessageSizeLimit;
+        double retainedMessageTimeToLive;
+        double walCommitInterval;
+        int walCheckpointSize;
 
         // gateway state management
         inet::ClockEvent* stateChangeEvent = nullptr;
@@ -72,24 +83,24 @@ class MqttSNServer : public MqttSNApp
         std::set<uint16_t> topicIds;
         uint16_t currentTopicId = 0;
 
-        std::map<uint16_t, RetainMessageInfo> retainMessages;
-        std::set<uint16_t> retainMessageIds;
+        inet::ClockEvent* topicsCheckEvent = nullptr;
+        int evictedTopicsCounter = 0;
+
+        RetainedStore retainMessages;
+        omnetpp::cOutVector retainedBytesVector;
 
         inet::ClockEvent* pendingRetainCheckEvent = nullptr;
         std::map<std::pair<inet::L3Address, int>, MessageInfo> pendingRetainMessages;
 
-        std::map<uint16_t, MessageInfo> messages;
-        std::set<uint16_t> messageIds;
+        IdSlab<MessageInfo> messages;
         uint16_t currentMessageId = 0;
 
         inet::ClockEvent* requestsCheckEvent = nullptr;
-        std::map<uint16_t, RequestInfo> requests;
-        std::set<uint16_t> requestIds;
+        IdSlab<RequestInfo> requests;
         uint16_t currentRequestId = 0;
 
         inet::ClockEvent* registrationsCheckEvent = nullptr;
-        std::map<uint16_t, RegisterInfo> registrations;
-        std::set<uint16_t> registrationIds;
+        IdSlab<RegisterInfo> registrations;
         uint16_t currentRegistrationId = 0;
 
         std::map<std::pair<inet::L3Address, int>, SubscriberInfo> subscribers;
@@ -99,6 +110,15 @@ class MqttSNServer : public MqttSNApp
         // clear events
         inet::ClockEvent* messagesClearEvent = nullptr;
 
+        // persistence of the QoS 1/2 and retained state
+        WriteAheadLog writeAheadLog;
+        inet::ClockEvent* walCommitEvent = nullptr;
+        bool recoveryPending = false;
+
+        int walRecoveries = 0;
+        double walRecoveryTime = 0;
+        uint64_t walRecoveredRecords = 0;
+
     protected:
         // initialization
         virtual void levelOneInit() override;
@@ -134,29 +154,29 @@ class MqttSNServer : public MqttSNApp
         // incoming packet handling
         virtual void processPacket(inet::Packet* pk) override;
 
-        virtual void processPacketByMessageType(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType,
+        virtual void processPacketByMessageType(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType,
                                                 ClientInfo* clientInfo);
 
         virtual bool isValidPacket(const inet::L3Address& srcAddress, const int& srcPort, MsgType msgType, ClientInfo*& clientInfo);
 
         // incoming packet type methods
         virtual void processSearchGw();
-        virtual void processConnect(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processWillTopic(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate = false);
-        virtual void processWillMsg(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate = false);
-        virtual void processPingReq(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo);
+        virtual void processConnect(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processWillTopic(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate = false);
+        virtual void processWillMsg(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, bool isDirectUpdate = false);
+        virtual void processPingReq(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo);
         virtual void processPingResp(const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo);
-        virtual void processDisconnect(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo);
-        virtual void processRegister(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processPublish(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processPublishMinusOne(inet::Packet* pk);
-        virtual void processPubRel(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processSubscribe(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processUnsubscribe(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processRegAck(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processPubAck(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processPubRec(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
-        virtual void processPubComp(inet::Packet* pk, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processDisconnect(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort, ClientInfo* clientInfo);
+        virtual void processRegister(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processPublish(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processPublishMinusOne(const PacketView& packet);
+        virtual void processPubRel(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processSubscribe(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processUnsubscribe(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processRegAck(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processPubAck(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processPubRec(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
+        virtual void processPubComp(const PacketView& packet, const inet::L3Address& srcAddress, const int& srcPort);
 
         // outgoing packet handling
         virtual void sendAdvertise();
@@ -188,6 +208,8 @@ class MqttSNServer : public MqttSNApp
         virtual void handleAwakenSubscriberCheckEvent(omnetpp::cMessage* msg);
 
         virtual void handleMessagesClearEvent();
+        virtual void handleTopicsCheckEvent();
+        virtual void handleWalCommitEvent();
 
         // client methods
         virtual void cleanClientSession(const inet::L3Address& clientAddress, const int& clientPort, ClientType clientType);
@@ -205,15 +227,20 @@ class MqttSNServer : public MqttSNApp
         virtual uint16_t getTopicByName(const std::string& topicName);
         virtual TopicInfo getTopicById(uint16_t topicId);
         virtual TopicIdType getTopicIdType(uint16_t topicLength);
+        virtual void acquireTopic(uint16_t topicId);
+        virtual void releaseTopic(uint16_t topicId);
+        virtual void updateTopicUsage(uint16_t topicId);
+        virtual void deleteTopic(uint16_t topicId);
 
         // retain message methods
         virtual void addNewRetainMessage(uint16_t topicId, bool dup, QoS qos, TopicIdType topicIdType, const std::string& data);
+        virtual void releaseRetainedTopics(const std::vector<uint16_t>& topicIds);
         virtual void addNewPendingRetainMessage(const inet::L3Address& subscriberAddress, const int& subscriberPort, uint16_t topicId, QoS qos);
 
         // message methods
         virtual void addNewMessage(const MessageInfo& messageInfo);
         virtual void addAndMarkMessage(const MessageInfo& messageInfo, bool& isMessageAdded);
-        virtual void deleteMessage(std::map<uint16_t, MessageInfo>::iterator& messageIt, std::set<uint16_t>::iterator& messageIdIt);
+        virtual void deleteMessage(uint16_t messageId);
         virtual void deleteAllocatedMessages(const std::vector<MessageInfo*>& messages);
 
         // request message methods
@@ -237,10 +264,8 @@ class MqttSNServer : public MqttSNApp
         virtual void addNewRequest(const inet::L3Address& subscriberAddress, const int& subscriberPort, MsgType messageType, bool sendAtLeastOnce,
                                    uint16_t messagesKey = 0, uint16_t retainMessagesKey = 0);
 
-        virtual void deleteRequest(std::map<uint16_t, RequestInfo>::iterator& requestIt, std::set<uint16_t>::iterator& requestIdIt);
-
-        virtual bool isValidRequest(uint16_t requestId, MsgType messageType, std::map<uint16_t, RequestInfo>::iterator& requestIt,
-                                    std::set<uint16_t>::iterator& requestIdIt);
+        virtual void deleteRequest(uint16_t requestId);
+        virtual RequestInfo* getValidRequest(uint16_t requestId, MsgType messageType);
 
         virtual bool processRequestAck(uint16_t requestId, MsgType messageType);
 
@@ -250,7 +275,7 @@ class MqttSNServer : public MqttSNApp
         virtual void addNewRegistration(const inet::L3Address& subscriberAddress, const int& subscriberPort, const std::string& topicName,
                                         uint16_t topicId);
 
-        virtual void deleteRegistration(std::map<uint16_t, RegisterInfo>::iterator& registrationIt, std::set<uint16_t>::iterator& registrationIdIt);
+        virtual void deleteRegistration(uint16_t registrationId);
         virtual bool processRegistrationAck(uint16_t registrationId);
 
         // subscriber methods
@@ -286,13 +311,29 @@ class MqttSNServer : public MqttSNApp
 
         // congestion methods
         virtual bool checkClientsCongestion();
-        virtual bool checkIDSpaceCongestion(const std::set<uint16_t>& usedIds, bool allowMaxValue = true);
         virtual bool checkPublishCongestion(QoS qos, bool retain);
 
         // clear methods
         virtual void clearPublishersData();
         virtual void clearSubscribersData();
 
+        // persistence methods
+        virtual void initializePersistence();
+        virtual void persistMessage(uint16_t messageId, const MessageInfo& messageInfo);
+        virtual void persistMessageDeletion(uint16_t messageId);
+        virtual void persistRequest(uint16_t requestId, const RequestInfo& requestInfo);
+        virtual void persistRequestDeletion(uint16_t requestId);
+
+        virtual void persistPublisherMessage(const inet::L3Address& publisherAddress, const int& publisherPort, uint16_t msgId,
+                                             const DataInfo& dataInfo);
+
+        virtual void persistPublisherMessageDeletion(const inet::L3Address& publisherAddress, const int& publisherPort, uint16_t msgId);
+        virtual void persistRetainMessage(uint16_t topicId, const RetainMessageInfo& retainMessageInfo, const std::string& data);
+        virtual void persistRetainMessageDeletion(uint16_t topicId);
+        virtual void checkpointState();
+        virtual void clearPersistentState();
+        virtual void recoverState();
+
     public:
         MqttSNServer() {};
         ~MqttSNServer();
@@ -0,0 +1,55 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef PERSISTENCE_WALFORMAT_H_
+#define PERSISTENCE_WALFORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mqttsn {
+
+// A write-ahead log is the magic followed by commit blocks. A block is a uint32_t
+// payload length, a uint32_t payload checksum and the payload, made of records:
+// a uint8_t WalRecordType, a uint32_t field length and the fields. Replay stops at
+// the first incomplete or corrupted block.
+static constexpr char WAL_MAGIC[8] = {'M', 'Q', 'S', 'N', 'W', 'A', 'L', '2'};
+
+enum WalRecordType : uint8_t {
+    MESSAGE_PUT = 1,
+    MESSAGE_DELETE = 2,
+    REQUEST_PUT = 3,
+    REQUEST_DELETE = 4,
+    PUBLISHER_MESSAGE_PUT = 5,
+    PUBLISHER_MESSAGE_DELETE = 6,
+    RETAINED_PUT = 7,
+    RETAINED_DELETE = 8
+};
+
+// FNV-1a hash of a block payload
+inline uint32_t getWalChecksum(const char* data, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t) data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+} /* namespace mqttsn */
+
+#endif /* PERSISTENCE_WALFORMAT_H_ */
@@ -0,0 +1,229 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "WriteAheadLog.h"
+#include <omnetpp.h>
+#include <cstdio>
+
+namespace mqttsn {
+
+void WriteAheadLog::writeBlock(std::ofstream& output)
+{
+    uint32_t length = (uint32_t) buffer.size();
+    uint32_t checksum = getWalChecksum(buffer.data(), buffer.size());
+
+    output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    output.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    output.write(buffer.data(), buffer.size());
+    output.flush();
+
+    if (!output) {
+        throw omnetpp::cRuntimeError("Failed to write the write-ahead log: %s", fileName.c_str());
+    }
+
+    fileBytes += sizeof(length) + sizeof(checksum) + buffer.size();
+}
+
+void WriteAheadLog::open(const std::string& fileName)
+{
+    stream.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw omnetpp::cRuntimeError("Failed to open write-ahead log file: %s", fileName.c_str());
+    }
+
+    stream.write(WAL_MAGIC, sizeof(WAL_MAGIC));
+    stream.flush();
+
+    this->fileName = fileName;
+    fileBytes = sizeof(WAL_MAGIC);
+
+    buffer.clear();
+    pendingRecords = 0;
+}
+
+void WriteAheadLog::close()
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    commit();
+    stream.close();
+}
+
+void WriteAheadLog::beginRecord(WalRecordType type)
+{
+    buffer.push_back((char) type);
+
+    // the field length is patched once the record is complete
+    recordStart = buffer.size();
+    buffer.resize(buffer.size() + sizeof(uint32_t));
+}
+
+void WriteAheadLog::endRecord()
+{
+    uint32_t length = (uint32_t) (buffer.size() - recordStart - sizeof(uint32_t));
+    std::memcpy(buffer.data() + recordStart, &length, sizeof(length));
+
+    pendingRecords++;
+}
+
+void WriteAheadLog::writeString(const std::string& value)
+{
+    write<uint32_t>((uint32_t) value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+void WriteAheadLog::commit()
+{
+    if (pendingRecords == 0) {
+        return;
+    }
+
+    writeBlock(stream);
+
+    commits++;
+    committedRecords += pendingRecords;
+
+    buffer.clear();
+    pendingRecords = 0;
+}
+
+void WriteAheadLog::discardPending()
+{
+    buffer.clear();
+    pendingRecords = 0;
+}
+
+void WriteAheadLog::checkpoint()
+{
+    // write the new log next to the current one and swap them once it is complete
+    std::string checkpointFileName = fileName + ".checkpoint";
+
+    std::ofstream output(checkpointFileName, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw omnetpp::cRuntimeError("Failed to open write-ahead log checkpoint: %s", checkpointFileName.c_str());
+    }
+
+    output.write(WAL_MAGIC, sizeof(WAL_MAGIC));
+    fileBytes = sizeof(WAL_MAGIC);
+
+    if (!buffer.empty()) {
+        writeBlock(output);
+    }
+
+    output.close();
+    stream.close();
+
+    if (std::rename(checkpointFileName.c_str(), fileName.c_str()) != 0) {
+        throw omnetpp::cRuntimeError("Failed to replace the write-ahead log: %s", fileName.c_str());
+    }
+
+    stream.open(fileName, std::ios::binary | std::ios::app);
+    if (!stream) {
+        throw omnetpp::cRuntimeError("Failed to reopen write-ahead log file: %s", fileName.c_str());
+    }
+
+    checkpoints++;
+
+    buffer.clear();
+    pendingRecords = 0;
+}
+
+bool WriteAheadLog::load(const std::string& fileName, std::vector<char>& records)
+{
+    std::ifstream input(fileName, std::ios::binary);
+    if (!input) {
+        return false;
+    }
+
+    char magic[sizeof(WAL_MAGIC)];
+    if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, WAL_MAGIC, sizeof(magic)) != 0) {
+        throw omnetpp::cRuntimeError("Not a write-ahead log file: %s", fileName.c_str());
+    }
+
+    // block lengths are checked against the bytes left before anything is allocated for them
+    input.seekg(0, std::ios::end);
+    std::streamoff fileSize = input.tellg();
+    input.seekg(sizeof(WAL_MAGIC));
+
+    uint32_t length;
+    uint32_t checksum;
+
+    while (input.read(reinterpret_cast<char*>(&length), sizeof(length)) &&
+           input.read(reinterpret_cast<char*>(&checksum), sizeof(checksum))) {
+
+        // a length beyond the end of the file comes from a torn or corrupted header and ends the log
+        if ((std::streamoff) length > fileSize - (std::streamoff) input.tellg()) {
+            break;
+        }
+
+        size_t start = records.size();
+        records.resize(start + length);
+
+        // an incomplete or corrupted block ends the log
+        if (!input.read(records.data() + start, length) || getWalChecksum(records.data() + start, length) != checksum) {
+            records.resize(start);
+            break;
+        }
+    }
+
+    return true;
+}
+
+void WalReader::checkRemaining(size_t length) const
+{
+    if (position + length > recordEnd) {
+        throw omnetpp::cRuntimeError("Write-ahead log record is truncated");
+    }
+}
+
+bool WalReader::next(WalRecordType& type)
+{
+    // skip the fields left unread in the previous record
+    if (recordEnd != nullptr) {
+        position = recordEnd;
+    }
+
+    if (position + sizeof(uint8_t) + sizeof(uint32_t) > end) {
+        return false;
+    }
+
+    type = (WalRecordType) (uint8_t) *position;
+
+    uint32_t length;
+    std::memcpy(&length, position + sizeof(uint8_t), sizeof(length));
+    position += sizeof(uint8_t) + sizeof(length);
+
+    if (position + length > end) {
+        throw omnetpp::cRuntimeError("Write-ahead log record exceeds its block");
+    }
+
+    recordEnd = position + length;
+    return true;
+}
+
+std::string WalReader::readString()
+{
+    uint32_t length = read<uint32_t>();
+    checkRemaining(length);
+
+    std::string value(position, length);
+    position += length;
+
+    return value;
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,126 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef PERSISTENCE_WRITEAHEADLOG_H_
+#define PERSISTENCE_WRITEAHEADLOG_H_
+
+#include "WalFormat.h"
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// Append-only log with group commit. Records accumulate in memory and are written
+// as one checksummed block per commit; records not yet committed are lost on a crash.
+class WriteAheadLog
+{
+    protected:
+        std::string fileName;
+        std::ofstream stream;
+
+        // records of the open commit group
+        std::vector<char> buffer;
+        size_t recordStart = 0;
+        uint64_t pendingRecords = 0;
+
+        uint64_t fileBytes = 0;
+
+        // statistics
+        uint64_t commits = 0;
+        uint64_t committedRecords = 0;
+        uint64_t checkpoints = 0;
+
+    protected:
+        void writeBlock(std::ofstream& output);
+
+    public:
+        WriteAheadLog() {};
+
+        bool isEnabled() const { return stream.is_open(); }
+
+        // creates an empty log, replacing any previous file
+        void open(const std::string& fileName);
+        void close();
+
+        void beginRecord(WalRecordType type);
+        void endRecord();
+
+        template<typename T>
+        void write(const T& value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+
+        void writeString(const std::string& value);
+
+        bool hasPending() const { return pendingRecords > 0; }
+
+        // writes the open group as one block and flushes it
+        void commit();
+
+        // drops the records that were not committed, as a crash would
+        void discardPending();
+
+        // replaces the log with the records of the open group, which must describe the whole live state
+        void checkpoint();
+
+        // appends the records of every valid block of the log to the given vector
+        static bool load(const std::string& fileName, std::vector<char>& records);
+
+        const std::string& getFileName() const { return fileName; }
+        uint64_t getFileBytes() const { return fileBytes; }
+        uint64_t getCommits() const { return commits; }
+        uint64_t getCommittedRecords() const { return committedRecords; }
+        uint64_t getCheckpoints() const { return checkpoints; }
+};
+
+// Sequential reader over the records returned by WriteAheadLog::load
+class WalReader
+{
+    protected:
+        const char* position;
+        const char* end;
+        const char* recordEnd = nullptr;
+
+    protected:
+        void checkRemaining(size_t length) const;
+
+    public:
+        WalReader(const std::vector<char>& records) : position(records.data()), end(records.data() + records.size()) {};
+
+        // moves to the next record; returns false once all records are read
+        bool next(WalRecordType& type);
+
+        template<typename T>
+        T read()
+        {
+            T value;
+
+            checkRemaining(sizeof(T));
+            std::memcpy(&value, position, sizeof(T));
+            position += sizeof(T);
+
+            return value;
+        }
+
+        std::string readString();
+};
+
+} /* namespace mqttsn */
+
+#endif /* PERSISTENCE_WRITEAHEADLOG_H_ */
@@ -0,0 +1,267 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "SimulationFork.h"
+#include "helpers/StringHelper.h"
+#include <omnetpp.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace mqttsn {
+
+bool SimulationFork::forked = false;
+int SimulationFork::variantIndex = 0;
+std::vector<std::map<std::string, std::string>> SimulationFork::variants;
+std::vector<int> SimulationFork::childProcesses;
+SimulationFork::RunListener SimulationFork::runListener;
+bool SimulationFork::runListenerAdded = false;
+
+void SimulationFork::RunListener::lifecycleEvent(omnetpp::SimulationLifecycleEventType eventType, omnetpp::cObject* details)
+{
+    if (eventType == omnetpp::LF_PRE_NETWORK_SETUP) {
+        handleNextRun();
+    }
+}
+
+std::vector<std::map<std::string, std::string>> SimulationFork::parseVariants(const std::string& definition)
+{
+    std::vector<std::map<std::string, std::string>> result;
+
+    // variants are separated by semicolons, their parameter assignments by commas
+    for (const std::string& variant : StringHelper::splitString(definition, ';')) {
+        std::map<std::string, std::string> assignments;
+
+        for (const std::string& assignment : StringHelper::splitString(variant, ',')) {
+            if (StringHelper::sanitizeSpaces(assignment).empty()) {
+                continue;
+            }
+
+            size_t separator = assignment.find('=');
+            if (separator == std::string::npos) {
+                throw omnetpp::cRuntimeError("Invalid fork variant assignment: %s", assignment.c_str());
+            }
+
+            assignments[StringHelper::sanitizeSpaces(assignment.substr(0, separator))] = assignment.substr(separator + 1);
+        }
+
+        if (!assignments.empty()) {
+            result.push_back(assignments);
+        }
+    }
+
+    return result;
+}
+
+void SimulationFork::fork(const std::string& definition)
+{
+    if (forked) {
+        return;
+    }
+
+    forked = true;
+    variants = parseVariants(definition);
+
+    if (!runListenerAdded) {
+        omnetpp::getEnvir()->addLifecycleListener(&runListener);
+        runListenerAdded = true;
+    }
+
+#if defined(__linux__)
+    // buffered output would otherwise be written once by every process
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    for (int index = 1; index <= (int) variants.size(); index++) {
+        int readyPipe[2];
+        if (pipe(readyPipe) != 0) {
+            throw omnetpp::cRuntimeError("Failed to create the fork pipe: %s", std::strerror(errno));
+        }
+
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            throw omnetpp::cRuntimeError("Failed to fork variant %d: %s", index, std::strerror(errno));
+        }
+
+        if (pid == 0) {
+            close(readyPipe[0]);
+
+            variantIndex = index;
+            childProcesses.clear();
+            redirectOutputFiles(index);
+
+            // the parent may write to the shared files only once the copies are taken
+            char ready = 1;
+            ssize_t written = write(readyPipe[1], &ready, sizeof(ready));
+            (void) written;
+            close(readyPipe[1]);
+
+            return;
+        }
+
+        close(readyPipe[1]);
+
+        char ready;
+        ssize_t received = read(readyPipe[0], &ready, sizeof(ready));
+        close(readyPipe[0]);
+
+        if (received != sizeof(ready)) {
+            throw omnetpp::cRuntimeError("Variant %d failed before taking over its output files", index);
+        }
+
+        childProcesses.push_back(pid);
+    }
+#else
+    throw omnetpp::cRuntimeError("Forking the simulation is only supported on Linux");
+#endif
+}
+
+void SimulationFork::redirectOutputFiles(int variantIndex)
+{
+#if defined(__linux__)
+    DIR* directory = opendir("/proc/self/fd");
+    if (directory == nullptr) {
+        throw omnetpp::cRuntimeError("Failed to list the open files of variant %d", variantIndex);
+    }
+
+    std::vector<int> descriptors;
+    while (dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] != '.') {
+            descriptors.push_back(std::atoi(entry->d_name));
+        }
+    }
+    closedir(directory);
+
+    for (int descriptor : descriptors) {
+        int flags = fcntl(descriptor, F_GETFL);
+        struct stat status;
+
+        // only regular files open for writing are shared with the parent
+        if (flags < 0 || (flags & O_ACCMODE) == O_RDONLY || fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+            continue;
+        }
+
+        char path[4096];
+        ssize_t length = readlink(("/proc/self/fd/" + std::to_string(descriptor)).c_str(), path, sizeof(path) - 1);
+        if (length <= 0) {
+            continue;
+        }
+        path[length] = '\0';
+
+        std::string source(path);
+        std::string target = addVariantSuffix(source, variantIndex);
+
+        int input = open(source.c_str(), O_RDONLY);
+        int output = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | (flags & O_APPEND), status.st_mode & 0777);
+        if (input < 0 || output < 0) {
+            throw omnetpp::cRuntimeError("Failed to copy %s for variant %d", source.c_str(), variantIndex);
+        }
+
+        // the variant continues from the content written before the fork
+        char buffer[65536];
+        ssize_t count;
+        while ((count = read(input, buffer, sizeof(buffer))) > 0) {
+            if (write(output, buffer, count) != count) {
+                throw omnetpp::cRuntimeError("Failed to copy %s for variant %d", source.c_str(), variantIndex);
+            }
+        }
+
+        close(input);
+
+        // the descriptor keeps its number, so the open streams write to the copy from now on
+        dup2(output, descriptor);
+        close(output);
+    }
+#endif
+}
+
+std::string SimulationFork::addVariantSuffix(const std::string& fileName, int variantIndex)
+{
+    // results/General-#0.vec becomes results/General-#0-variant1.vec
+    size_t extension = fileName.find_last_of('.');
+    size_t slash = fileName.find_last_of('/');
+    if (extension == std::string::npos || (slash != std::string::npos && extension < slash)) {
+        extension = fileName.size();
+    }
+
+    return fileName.substr(0, extension) + "-variant" + std::to_string(variantIndex) + fileName.substr(extension);
+}
+
+std::string SimulationFork::getVariantFileName(const std::string& fileName)
+{
+    if (variantIndex == 0 || fileName.empty()) {
+        return fileName;
+    }
+
+    return addVariantSuffix(fileName, variantIndex);
+}
+
+const std::map<std::string, std::string>* SimulationFork::getVariant()
+{
+    if (variantIndex == 0) {
+        return nullptr;
+    }
+
+    return &variants[variantIndex - 1];
+}
+
+void SimulationFork::waitForVariants()
+{
+#if defined(__linux__)
+    for (int pid : childProcesses) {
+        int status;
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Fork variant process " << pid << " did not finish successfully" << std::endl;
+        }
+    }
+#endif
+
+    childProcesses.clear();
+}
+
+void SimulationFork::handleNextRun()
+{
+    if (!forked) {
+        return;
+    }
+
+#if defined(__linux__)
+    // a variant ends with its run; going on would write the next run under the file names of the parent
+    if (variantIndex != 0) {
+        std::cout.flush();
+        std::fflush(nullptr);
+        _exit(0);
+    }
+#endif
+
+    // the parent forks the next run from scratch, after the variants of a run that ended early
+    waitForVariants();
+
+    forked = false;
+    variants.clear();
+}
+
+} /* namespace mqttsn */
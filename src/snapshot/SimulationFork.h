@@ -0,0 +1,75 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef SNAPSHOT_SIMULATIONFORK_H_
+#define SNAPSHOT_SIMULATIONFORK_H_
+
+#include <omnetpp.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// Process wide fork of a warmed-up simulation into parameter variants. The first module
+// reaching the fork time forks one child process per variant; the copy-on-write children
+// inherit the whole simulation state, including the future event set, and continue with
+// their variant applied while the parent continues as the unmodified baseline. A variant
+// belongs to the run it was forked from: its process ends when the next run of the process
+// starts, and the parent may fork again in that run.
+class SimulationFork
+{
+    protected:
+        // tells the fork about the start of every run after the one it was forked in
+        class RunListener : public omnetpp::cISimulationLifecycleListener
+        {
+            public:
+                virtual void lifecycleEvent(omnetpp::SimulationLifecycleEventType eventType, omnetpp::cObject* details) override;
+        };
+
+        static bool forked;
+        static int variantIndex;
+        static std::vector<std::map<std::string, std::string>> variants;
+        static std::vector<int> childProcesses;
+
+        static RunListener runListener;
+        static bool runListenerAdded;
+
+    protected:
+        static void redirectOutputFiles(int variantIndex);
+        static void handleNextRun();
+        static std::string addVariantSuffix(const std::string& fileName, int variantIndex);
+
+    public:
+        // variants separated by semicolons, each a comma-separated list of parameter=value assignments
+        static std::vector<std::map<std::string, std::string>> parseVariants(const std::string& definition);
+
+        // forking an already forked process is a no-op so that every module can request it
+        static void fork(const std::string& definition);
+
+        // zero in the parent, the one based variant number in a child
+        static int getVariantIndex() { return variantIndex; }
+        static const std::map<std::string, std::string>* getVariant();
+
+        // the file name with the variant suffix in a child, for files opened after the fork
+        static std::string getVariantFileName(const std::string& fileName);
+
+        // waits for the children so that the parent exits once every variant has finished
+        static void waitForVariants();
+};
+
+} /* namespace mqttsn */
+
+#endif /* SNAPSHOT_SIMULATIONFORK_H_ */
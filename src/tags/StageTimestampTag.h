@@ -0,0 +1,44 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TAGS_STAGETIMESTAMPTAG_H_
+#define TAGS_STAGETIMESTAMPTAG_H_
+
+#include "inet/common/TagBase_m.h"
+#include "inet/common/clock/ClockUserModuleMixin.h"
+#include "types/shared/Stage.h"
+#include <array>
+
+namespace mqttsn {
+
+class StageTimestampTag : public inet::TagBase
+{
+    private:
+        std::array<inet::clocktime_t, Stage::STAGE_COUNT> timestamps;
+
+    public:
+        StageTimestampTag() {};
+
+        virtual StageTimestampTag* dup() const override { return new StageTimestampTag(*this); }
+
+        void setTimestamps(const std::array<inet::clocktime_t, Stage::STAGE_COUNT>& timestamps);
+        const std::array<inet::clocktime_t, Stage::STAGE_COUNT>& getTimestamps() const;
+
+        ~StageTimestampTag() {};
+};
+
+} /* namespace mqttsn */
+
+#endif /* TAGS_STAGETIMESTAMPTAG_H_ */
@@ -0,0 +1,144 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "MessageTracer.h"
+#include <omnetpp.h>
+#include <algorithm>
+
+namespace mqttsn {
+
+bool MessageTracer::enabled = false;
+bool MessageTracer::streaming = true;
+std::string MessageTracer::fileName;
+std::ofstream MessageTracer::stream;
+
+std::vector<TraceRecord> MessageTracer::buffer;
+size_t MessageTracer::head = 0;
+size_t MessageTracer::count = 0;
+
+void MessageTracer::open(const std::string& fileName, size_t bufferSize, bool streaming)
+{
+    if (enabled) {
+        if (fileName != MessageTracer::fileName) {
+            throw omnetpp::cRuntimeError("Message trace already open on file: %s", MessageTracer::fileName.c_str());
+        }
+
+        return;
+    }
+
+    if (bufferSize == 0) {
+        throw omnetpp::cRuntimeError("Message trace buffer size must be positive");
+    }
+
+    stream.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw omnetpp::cRuntimeError("Failed to open message trace file: %s", fileName.c_str());
+    }
+
+    stream.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+
+    MessageTracer::fileName = fileName;
+    MessageTracer::streaming = streaming;
+
+    buffer.assign(bufferSize, TraceRecord());
+    head = 0;
+    count = 0;
+
+    enabled = true;
+}
+
+void MessageTracer::registerModule(int moduleId, const std::string& modulePath)
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint8_t blockType = TraceBlockType::MODULE_BLOCK;
+    int32_t id = moduleId;
+    uint16_t length = (uint16_t) modulePath.size();
+
+    stream.write(reinterpret_cast<const char*>(&blockType), sizeof(blockType));
+    stream.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    stream.write(modulePath.data(), length);
+}
+
+void MessageTracer::record(TraceEvent event, int64_t timestamp, uint32_t identifier, int32_t moduleId, uint32_t value, uint8_t qos,
+                           bool dup)
+{
+    if (!enabled) {
+        return;
+    }
+
+    if (count == buffer.size()) {
+        if (streaming) {
+            writeRecords();
+        }
+        else {
+            // ring buffer mode; drop the oldest record
+            head = (head + 1) % buffer.size();
+            count--;
+        }
+    }
+
+    TraceRecord& traceRecord = buffer[(head + count) % buffer.size()];
+    traceRecord.timestamp = timestamp;
+    traceRecord.identifier = identifier;
+    traceRecord.moduleId = moduleId;
+    traceRecord.value = value;
+    traceRecord.event = event;
+    traceRecord.qos = qos;
+    traceRecord.dup = dup ? 1 : 0;
+
+    count++;
+}
+
+void MessageTracer::writeRecords()
+{
+    if (count == 0) {
+        return;
+    }
+
+    uint8_t blockType = TraceBlockType::RECORD_BLOCK;
+    uint32_t recordCount = (uint32_t) count;
+
+    stream.write(reinterpret_cast<const char*>(&blockType), sizeof(blockType));
+    stream.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
+
+    // the buffered records may wrap around the end of the buffer
+    size_t firstPart = std::min(count, buffer.size() - head);
+    stream.write(reinterpret_cast<const char*>(&buffer[head]), firstPart * sizeof(TraceRecord));
+    stream.write(reinterpret_cast<const char*>(&buffer[0]), (count - firstPart) * sizeof(TraceRecord));
+
+    head = 0;
+    count = 0;
+}
+
+void MessageTracer::close()
+{
+    if (!enabled) {
+        return;
+    }
+
+    writeRecords();
+    stream.close();
+
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    enabled = false;
+}
+
+} /* namespace mqttsn */
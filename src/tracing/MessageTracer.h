@@ -0,0 +1,60 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TRACING_MESSAGETRACER_H_
+#define TRACING_MESSAGETRACER_H_
+
+#include "TraceFormat.h"
+#include "types/shared/TraceEvent.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mqttsn {
+
+// Process wide recorder of PUBLISH lifecycle events. Records are kept in a fixed size
+// ring buffer; in streaming mode a full buffer is written to the trace file, otherwise
+// the oldest records are overwritten and only the most recent ones are written on close.
+class MessageTracer
+{
+    protected:
+        static bool enabled;
+        static bool streaming;
+        static std::string fileName;
+        static std::ofstream stream;
+
+        static std::vector<TraceRecord> buffer;
+        static size_t head;
+        static size_t count;
+
+    protected:
+        static void writeRecords();
+
+    public:
+        static bool isEnabled() { return enabled; }
+
+        // opening an already open trace is a no-op so that every module can request it
+        static void open(const std::string& fileName, size_t bufferSize, bool streaming);
+        static void registerModule(int moduleId, const std::string& modulePath);
+
+        static void record(TraceEvent event, int64_t timestamp, uint32_t identifier, int32_t moduleId, uint32_t value, uint8_t qos,
+                           bool dup);
+
+        static void close();
+};
+
+} /* namespace mqttsn */
+
+#endif /* TRACING_MESSAGETRACER_H_ */
@@ -0,0 +1,49 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TRACING_TRACEFORMAT_H_
+#define TRACING_TRACEFORMAT_H_
+
+#include <cstdint>
+
+namespace mqttsn {
+
+// Layout of message trace files, shared by the simulation and the offline converter.
+// A file starts with TRACE_MAGIC followed by blocks in native byte order; each block
+// starts with a one byte TraceBlockType:
+//   MODULE_BLOCK: int32 module id, uint16 path length, path characters
+//   RECORD_BLOCK: uint32 record count, packed TraceRecord entries
+static constexpr char TRACE_MAGIC[8] = {'M', 'Q', 'S', 'N', 'T', 'R', 'C', '1'};
+
+enum TraceBlockType : uint8_t {
+    MODULE_BLOCK = 1,
+    RECORD_BLOCK = 2
+};
+
+struct TraceRecord {
+    int64_t timestamp = 0; // simulation time in nanoseconds
+    uint32_t identifier = 0; // message identifier tag
+    int32_t moduleId = 0;
+    uint32_t value = 0; // message ID, or number of subscribers for a fan-out
+    uint16_t event = 0;
+    uint8_t qos = 0; // QoS flag as encoded in PUBLISH messages
+    uint8_t dup = 0;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "Trace records must stay packed");
+
+} /* namespace mqttsn */
+
+#endif /* TRACING_TRACEFORMAT_H_ */
@@ -22,6 +22,7 @@ struct LastPublishInfo {
     ItemInfo* itemInfo = nullptr;
     DataInfo* dataInfo = nullptr;
     TagInfo tagInfo;
+    int payloadSize = -1;
     bool retry = false;
 };
 
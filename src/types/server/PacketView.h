@@ -0,0 +1,39 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TYPES_SERVER_PACKETVIEW_H_
+#define TYPES_SERVER_PACKETVIEW_H_
+
+#include "messages/MqttSNBase.h"
+
+// message decoded once on arrival and shared by all packet handlers
+struct PacketView {
+    inet::Ptr<const mqttsn::MqttSNBase> header;
+    MsgType msgType;
+
+    // the chunk already has the concrete message class; no further peek is needed
+    template<typename T>
+    inet::Ptr<const T> get() const
+    {
+        const auto& payload = inet::dynamicPtrCast<const T>(header);
+
+        if (payload == nullptr)
+            throw omnetpp::cRuntimeError("Packet does not hold the expected message class");
+
+        return payload;
+    }
+};
+
+#endif /* TYPES_SERVER_PACKETVIEW_H_ */
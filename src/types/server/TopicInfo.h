@@ -19,6 +19,8 @@
 struct TopicInfo {
     std::string topicName = "";
     TopicIdType topicIdType = TopicIdType::NORMAL_TOPIC_ID;
+    int references = 0; // subscriptions, pending registrations, retained and stored messages
+    inet::clocktime_t lastUsedTime = 0;
 };
 
 #endif /* TYPES_SERVER_TOPICINFO_H_ */
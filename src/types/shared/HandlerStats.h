@@ -0,0 +1,27 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TYPES_SHARED_HANDLERSTATS_H_
+#define TYPES_SHARED_HANDLERSTATS_H_
+
+#include <cstdint>
+
+struct HandlerStats {
+    uint64_t count = 0;
+    uint64_t totalTime = 0; // wall time in nanoseconds
+    uint64_t maxTime = 0;
+};
+
+#endif /* TYPES_SHARED_HANDLERSTATS_H_ */
@@ -0,0 +1,32 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TYPES_SHARED_LOGEVENT_H_
+#define TYPES_SHARED_LOGEVENT_H_
+
+// events written by the structured logging macros; the comments name the two journal values
+enum LogEvent : uint16_t {
+    PACKET_RECEIVED = 0, // message type, packet length in bytes
+    CLIENT_STATE_CHANGED, // new client state, unused
+    GATEWAY_STATE_CHANGED, // new gateway state, unused
+    CLIENT_CONNECTED, // gateway port, unused
+    PING_RESPONSE_RECEIVED, // source port, unused
+    PUBLISH_CREATED, // identifier tag, topic ID
+    PUBLISH_DELIVERED, // identifier tag, topic ID
+    END_TO_END_DELAY, // identifier tag, delay in nanoseconds
+    LOG_EVENT_COUNT
+};
+
+#endif /* TYPES_SHARED_LOGEVENT_H_ */
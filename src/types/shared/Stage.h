@@ -0,0 +1,31 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TYPES_SHARED_STAGE_H_
+#define TYPES_SHARED_STAGE_H_
+
+// stages of a PUBLISH message path, in the order they are traversed
+enum Stage {
+    PUBLISHER_CREATED = 0,
+    PUBLISHER_SENT,
+    GATEWAY_RECEIVED,
+    GATEWAY_BUFFERED, // delivery request queued; sent by the next requests check that finds the subscriber active or awake
+    GATEWAY_DISPATCHED,
+    SUBSCRIBER_RECEIVED,
+    SUBSCRIBER_DELIVERED,
+    STAGE_COUNT
+};
+
+#endif /* TYPES_SHARED_STAGE_H_ */
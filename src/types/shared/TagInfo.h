@@ -16,9 +16,13 @@
 #ifndef TYPES_SHARED_TAGINFO_H_
 #define TYPES_SHARED_TAGINFO_H_
 
+#include "types/shared/Stage.h"
+#include <array>
+
 struct TagInfo {
     inet::clocktime_t timestamp = 0;
     unsigned identifier = 0;
+    std::array<inet::clocktime_t, Stage::STAGE_COUNT> stageTimestamps;
 };
 
 #endif /* TYPES_SHARED_TAGINFO_H_ */
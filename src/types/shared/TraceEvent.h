@@ -0,0 +1,37 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef TYPES_SHARED_TRACEEVENT_H_
+#define TYPES_SHARED_TRACEEVENT_H_
+
+// points in the lifecycle of a PUBLISH message recorded by the message tracer;
+// every transmission records a SEND or DISPATCH event, retransmissions additionally record a RETRANSMIT event
+enum TraceEvent : uint16_t {
+    PUBLISHER_SEND = 0,
+    PUBLISHER_RETRANSMIT,
+    PUBLISHER_ACK,
+    PUBLISHER_PUBREC,
+    PUBLISHER_COMPLETE,
+    GATEWAY_ACCEPT,
+    GATEWAY_FANOUT,
+    GATEWAY_DISPATCH,
+    GATEWAY_RETRANSMIT,
+    GATEWAY_ACK,
+    SUBSCRIBER_RECEIVE,
+    SUBSCRIBER_DELIVER,
+    TRACE_EVENT_COUNT
+};
+
+#endif /* TYPES_SHARED_TRACEEVENT_H_ */
@@ -0,0 +1,41 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef WORKLOADS_BASEARRIVALPROCESS_H_
+#define WORKLOADS_BASEARRIVALPROCESS_H_
+
+#include <omnetpp.h>
+
+namespace mqttsn {
+
+class BaseArrivalProcess
+{
+    protected:
+        omnetpp::cRNG* rng;
+
+    public:
+        BaseArrivalProcess(omnetpp::cRNG* rng) : rng(rng) {};
+        virtual ~BaseArrivalProcess() {};
+
+        // time in seconds until the next arrival; a negative value means the process is exhausted
+        virtual double getNextInterArrivalTime() = 0;
+
+        // payload size imposed by the last arrival, -1 if the process does not define one
+        virtual int getPayloadSize() const { return -1; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* WORKLOADS_BASEARRIVALPROCESS_H_ */
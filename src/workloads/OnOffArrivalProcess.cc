@@ -0,0 +1,53 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "OnOffArrivalProcess.h"
+
+namespace mqttsn {
+
+OnOffArrivalProcess::OnOffArrivalProcess(omnetpp::cRNG* rng, double onRate, double meanOnDuration, double meanOffDuration)
+    : BaseArrivalProcess(rng)
+{
+    if (onRate <= 0 || meanOnDuration <= 0 || meanOffDuration < 0) {
+        throw omnetpp::cRuntimeError("Invalid on/off arrival process parameters");
+    }
+
+    this->onRate = onRate;
+    this->meanOnDuration = meanOnDuration;
+    this->meanOffDuration = meanOffDuration;
+
+    remainingOnDuration = omnetpp::exponential(rng, meanOnDuration);
+}
+
+double OnOffArrivalProcess::getNextInterArrivalTime()
+{
+    double elapsed = 0;
+
+    while (true) {
+        // poisson arrivals while the source is on
+        double gap = omnetpp::exponential(rng, 1 / onRate);
+
+        if (gap <= remainingOnDuration) {
+            remainingOnDuration -= gap;
+            return elapsed + gap;
+        }
+
+        // the on period ends before the next arrival; skip the off period and start a new burst
+        elapsed += remainingOnDuration + omnetpp::exponential(rng, meanOffDuration);
+        remainingOnDuration = omnetpp::exponential(rng, meanOnDuration);
+    }
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,41 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef WORKLOADS_ONOFFARRIVALPROCESS_H_
+#define WORKLOADS_ONOFFARRIVALPROCESS_H_
+
+#include "BaseArrivalProcess.h"
+
+namespace mqttsn {
+
+class OnOffArrivalProcess : public BaseArrivalProcess
+{
+    protected:
+        double onRate;
+        double meanOnDuration;
+        double meanOffDuration;
+
+        // time left in the current on period
+        double remainingOnDuration = 0;
+
+    public:
+        OnOffArrivalProcess(omnetpp::cRNG* rng, double onRate, double meanOnDuration, double meanOffDuration);
+
+        virtual double getNextInterArrivalTime() override;
+};
+
+} /* namespace mqttsn */
+
+#endif /* WORKLOADS_ONOFFARRIVALPROCESS_H_ */
@@ -0,0 +1,40 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "PeriodicArrivalProcess.h"
+
+namespace mqttsn {
+
+PeriodicArrivalProcess::PeriodicArrivalProcess(omnetpp::cRNG* rng, double period, double jitter) : BaseArrivalProcess(rng)
+{
+    if (period <= 0 || jitter < 0 || jitter > period) {
+        throw omnetpp::cRuntimeError("Invalid periodic arrival process parameters");
+    }
+
+    this->period = period;
+    this->jitter = jitter;
+}
+
+double PeriodicArrivalProcess::getNextInterArrivalTime()
+{
+    if (jitter == 0) {
+        return period;
+    }
+
+    // uniformly distributed deviation around the nominal period
+    return period + omnetpp::uniform(rng, -jitter, jitter);
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,37 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef WORKLOADS_PERIODICARRIVALPROCESS_H_
+#define WORKLOADS_PERIODICARRIVALPROCESS_H_
+
+#include "BaseArrivalProcess.h"
+
+namespace mqttsn {
+
+class PeriodicArrivalProcess : public BaseArrivalProcess
+{
+    protected:
+        double period;
+        double jitter;
+
+    public:
+        PeriodicArrivalProcess(omnetpp::cRNG* rng, double period, double jitter = 0);
+
+        virtual double getNextInterArrivalTime() override;
+};
+
+} /* namespace mqttsn */
+
+#endif /* WORKLOADS_PERIODICARRIVALPROCESS_H_ */
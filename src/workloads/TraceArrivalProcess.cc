@@ -0,0 +1,98 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "TraceArrivalProcess.h"
+#include <fstream>
+#include <sstream>
+
+namespace mqttsn {
+
+TraceArrivalProcess::TraceArrivalProcess(omnetpp::cRNG* rng, const std::string& traceFile) : BaseArrivalProcess(rng)
+{
+    loadTraceFile(traceFile);
+}
+
+void TraceArrivalProcess::loadTraceFile(const std::string& traceFile)
+{
+    std::ifstream file(traceFile);
+
+    if (!file.is_open()) {
+        throw omnetpp::cRuntimeError("Unable to open arrival trace file: %s", traceFile.c_str());
+    }
+
+    // each line holds an arrival time in seconds and an optional payload size in bytes, separated by a comma
+    std::string line;
+    int lineNumber = 0;
+    double lastTime = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        std::string timeField;
+        std::string sizeField;
+
+        std::getline(stream, timeField, ',');
+        std::getline(stream, sizeField, ',');
+
+        double time;
+        try {
+            time = std::stod(timeField);
+        }
+        catch (const std::exception&) {
+            // tolerate a header line
+            if (interArrivalTimes.empty()) {
+                continue;
+            }
+
+            throw omnetpp::cRuntimeError("Invalid arrival time in %s at line %d", traceFile.c_str(), lineNumber);
+        }
+
+        if (time < lastTime) {
+            throw omnetpp::cRuntimeError("Arrival times must be non-decreasing in %s at line %d", traceFile.c_str(), lineNumber);
+        }
+
+        int size = -1;
+        if (!sizeField.empty()) {
+            try {
+                size = std::stoi(sizeField);
+            }
+            catch (const std::exception&) {
+                throw omnetpp::cRuntimeError("Invalid payload size in %s at line %d", traceFile.c_str(), lineNumber);
+            }
+        }
+
+        interArrivalTimes.push_back(time - lastTime);
+        payloadSizes.push_back(size);
+
+        lastTime = time;
+    }
+}
+
+double TraceArrivalProcess::getNextInterArrivalTime()
+{
+    if (position >= interArrivalTimes.size()) {
+        return -1;
+    }
+
+    payloadSize = payloadSizes[position];
+    return interArrivalTimes[position++];
+}
+
+} /* namespace mqttsn */
@@ -0,0 +1,44 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef WORKLOADS_TRACEARRIVALPROCESS_H_
+#define WORKLOADS_TRACEARRIVALPROCESS_H_
+
+#include "BaseArrivalProcess.h"
+
+namespace mqttsn {
+
+class TraceArrivalProcess : public BaseArrivalProcess
+{
+    protected:
+        std::vector<double> interArrivalTimes;
+        std::vector<int> payloadSizes;
+
+        size_t position = 0;
+        int payloadSize = -1;
+
+    protected:
+        virtual void loadTraceFile(const std::string& traceFile);
+
+    public:
+        TraceArrivalProcess(omnetpp::cRNG* rng, const std::string& traceFile);
+
+        virtual double getNextInterArrivalTime() override;
+        virtual int getPayloadSize() const override { return payloadSize; }
+};
+
+} /* namespace mqttsn */
+
+#endif /* WORKLOADS_TRACEARRIVALPROCESS_H_ */
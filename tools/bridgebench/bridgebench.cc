@@ -0,0 +1,663 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Runs the aggregating MQTT-SN to MQTT bridge (src/core/MqttBridge) against an in-process
+// MQTT broker stand-in, in virtual time over upstream links with a fixed one-way delay.
+// Publications enter the broker core as MQTT-SN packets, go upstream through the bridge,
+// come back through its subscriptions and are counted at the MQTT-SN subscribers, so
+// every scenario also checks that nothing is lost or delivered twice where it must not be.
+//
+// The scenarios cover the levers of the bridge: pipelining depth and the number of
+// upstream connections, batching of subscription updates, backpressure towards the
+// MQTT-SN clients while the upstream is unavailable, and recovery after a reconnection.
+
+#include "core/BrokerCore.h"
+#include "core/MqttBridge.h"
+#include "core/MqttCodec.h"
+#include "core/WireCodec.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+class VirtualClock : public BrokerClock
+{
+    public:
+        double time = 0;
+
+        virtual double now() const override { return time; }
+};
+
+// Discrete events in time order; events at the same time run in scheduling order
+class EventQueue
+{
+    protected:
+        struct Event {
+            double time;
+            uint64_t sequence;
+            std::function<void()> action;
+
+            bool operator>(const Event& other) const { return time != other.time ? time > other.time : sequence > other.sequence; }
+        };
+
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+        uint64_t nextSequence = 0;
+
+    public:
+        void schedule(double time, std::function<void()> action) { events.push(Event{time, nextSequence++, std::move(action)}); }
+
+        bool isEmpty() const { return events.empty(); }
+        double getNextTime() const { return events.top().time; }
+
+        void runNext(VirtualClock& clock)
+        {
+            Event event = events.top();
+            events.pop();
+
+            clock.time = event.time;
+            event.action();
+        }
+};
+
+// MQTT 3.1.1 broker stand-in: persistent sessions, exact topic matching and QoS 0, 1 and 2
+// in both directions. Unacknowledged deliveries are sent again when a session resumes.
+class StandInBroker
+{
+    protected:
+        struct Session {
+            int connection = -1;
+            uint16_t nextPacketId = 0;
+            std::unordered_map<std::string, uint8_t> subscriptions;
+            std::unordered_set<uint16_t> receivedPacketIds;
+            std::unordered_map<uint16_t, MqttPacket> outbound;
+        };
+
+        std::unordered_map<std::string, Session> sessions;
+        std::unordered_map<std::string, std::unordered_set<std::string>> subscribers;
+
+        std::vector<Session*> connectionSessions;
+        std::vector<std::vector<uint8_t>> inputs;
+        std::vector<std::vector<uint8_t>> outputs;
+
+    protected:
+        void send(int connection, const MqttPacket& packet) { MqttCodec::append(packet, outputs[connection]); }
+
+        void route(const MqttPacket& publication)
+        {
+            auto it = subscribers.find(publication.topic);
+            if (it == subscribers.end()) {
+                return;
+            }
+
+            for (const std::string& clientId : it->second) {
+                Session& session = sessions[clientId];
+
+                MqttPacket delivery = publication;
+                delivery.qos = std::min(publication.qos, session.subscriptions[publication.topic]);
+                delivery.dup = false;
+                delivery.retain = false;
+                delivery.packetId = 0;
+
+                if (delivery.qos > 0) {
+                    session.nextPacketId = session.nextPacketId == UINT16_MAX ? 1 : session.nextPacketId + 1;
+                    delivery.packetId = session.nextPacketId;
+                    session.outbound[delivery.packetId] = delivery;
+                }
+
+                deliveredPublications++;
+                if (session.connection >= 0) {
+                    send(session.connection, delivery);
+                }
+            }
+        }
+
+        void handlePacket(int connection, const MqttPacket& packet)
+        {
+            if (packet.type == MqttPacketType::MQTT_CONNECT) {
+                bool sessionPresent = !packet.cleanSession && sessions.count(packet.clientId) > 0;
+                Session& session = sessions[packet.clientId];
+                session.connection = connection;
+                connectionSessions[connection] = &session;
+
+                MqttPacket connAck;
+                connAck.type = MqttPacketType::MQTT_CONNACK;
+                connAck.sessionPresent = sessionPresent;
+                send(connection, connAck);
+
+                for (auto& outbound : session.outbound) {
+                    outbound.second.dup = true;
+                    send(connection, outbound.second);
+                }
+                return;
+            }
+
+            Session* session = connectionSessions[connection];
+            if (session == nullptr) {
+                return;
+            }
+
+            MqttPacket reply;
+            reply.packetId = packet.packetId;
+
+            switch (packet.type) {
+                case MqttPacketType::MQTT_PUBLISH:
+                    receivedPublications++;
+
+                    // QoS 2 publications are routed on arrival and their ID kept until PUBREL
+                    if (packet.qos < 2 || session->receivedPacketIds.insert(packet.packetId).second) {
+                        route(packet);
+                    }
+
+                    if (packet.qos > 0) {
+                        reply.type = packet.qos == 1 ? MqttPacketType::MQTT_PUBACK : MqttPacketType::MQTT_PUBREC;
+                        send(connection, reply);
+                    }
+                    break;
+
+                case MqttPacketType::MQTT_PUBREL:
+                    session->receivedPacketIds.erase(packet.packetId);
+                    reply.type = MqttPacketType::MQTT_PUBCOMP;
+                    send(connection, reply);
+                    break;
+
+                case MqttPacketType::MQTT_PUBACK:
+                case MqttPacketType::MQTT_PUBCOMP:
+                    session->outbound.erase(packet.packetId);
+                    break;
+
+                case MqttPacketType::MQTT_PUBREC:
+                    session->outbound.erase(packet.packetId);
+                    reply.type = MqttPacketType::MQTT_PUBREL;
+                    send(connection, reply);
+                    break;
+
+                case MqttPacketType::MQTT_SUBSCRIBE:
+                    subscribePackets++;
+                    reply.type = MqttPacketType::MQTT_SUBACK;
+
+                    for (size_t i = 0; i < packet.topicFilters.size(); i++) {
+                        const std::string& clientId = findClientId(*session);
+                        session->subscriptions[packet.topicFilters[i]] = packet.qosLevels[i];
+                        subscribers[packet.topicFilters[i]].insert(clientId);
+                        reply.qosLevels.push_back(packet.qosLevels[i]);
+                    }
+
+                    send(connection, reply);
+                    break;
+
+                case MqttPacketType::MQTT_UNSUBSCRIBE:
+                    unsubscribePackets++;
+                    reply.type = MqttPacketType::MQTT_UNSUBACK;
+
+                    for (const std::string& topicFilter : packet.topicFilters) {
+                        session->subscriptions.erase(topicFilter);
+                        subscribers[topicFilter].erase(findClientId(*session));
+                    }
+
+                    send(connection, reply);
+                    break;
+
+                case MqttPacketType::MQTT_PINGREQ:
+                    reply.type = MqttPacketType::MQTT_PINGRESP;
+                    send(connection, reply);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        const std::string& findClientId(const Session& session)
+        {
+            for (const auto& entry : sessions) {
+                if (&entry.second == &session) {
+                    return entry.first;
+                }
+            }
+
+            static const std::string unknown;
+            return unknown;
+        }
+
+    public:
+        uint64_t receivedPublications = 0;
+        uint64_t deliveredPublications = 0;
+        uint64_t subscribePackets = 0;
+        uint64_t unsubscribePackets = 0;
+
+        StandInBroker(int connections) : connectionSessions(connections, nullptr), inputs(connections), outputs(connections) {}
+
+        void handleStream(int connection, const uint8_t* data, size_t length)
+        {
+            std::vector<uint8_t>& input = inputs[connection];
+            input.insert(input.end(), data, data + length);
+
+            size_t offset = 0;
+            MqttPacket packet;
+            size_t consumed = 0;
+
+            while (MqttCodec::decode(input.data() + offset, input.size() - offset, packet, consumed) == MqttCodec::COMPLETE) {
+                handlePacket(connection, packet);
+                offset += consumed;
+            }
+
+            input.erase(input.begin(), input.begin() + offset);
+        }
+
+        void disconnect(int connection)
+        {
+            if (connectionSessions[connection] != nullptr) {
+                connectionSessions[connection]->connection = -1;
+                connectionSessions[connection] = nullptr;
+            }
+
+            inputs[connection].clear();
+            outputs[connection].clear();
+        }
+
+        std::vector<uint8_t> takeOutput(int connection)
+        {
+            std::vector<uint8_t> output;
+            output.swap(outputs[connection]);
+            return output;
+        }
+};
+
+// MQTT-SN side of the core: counts the publications reaching subscribers by their sequence number
+class SubscriberTransport : public BrokerTransport
+{
+    public:
+        std::vector<uint32_t> receivedCounts;
+        uint64_t deliveries = 0;
+        uint64_t duplicates = 0;
+        uint64_t accepted = 0;
+        uint64_t rejected = 0;
+
+        virtual void send(EndpointId endpoint, const uint8_t* data, size_t length) override
+        {
+            CorePacket packet;
+            if (!WireCodec::decode(data, length, packet)) {
+                return;
+            }
+
+            if (packet.msgType == MsgType::PUBACK) {
+                (packet.returnCode == ReturnCode::ACCEPTED ? accepted : rejected)++;
+            }
+            else if (packet.msgType == MsgType::PUBLISH && packet.data.size() >= sizeof(uint32_t)) {
+                uint32_t sequence;
+                std::memcpy(&sequence, packet.data.data(), sizeof(sequence));
+
+                if (sequence >= receivedCounts.size()) {
+                    receivedCounts.resize(sequence + 1, 0);
+                }
+
+                if (receivedCounts[sequence]++ > 0) {
+                    duplicates++;
+                }
+                deliveries++;
+            }
+        }
+
+        uint64_t countMissing(uint32_t expected) const
+        {
+            uint64_t missing = 0;
+            for (uint32_t sequence = 0; sequence < expected; sequence++) {
+                if (sequence >= receivedCounts.size() || receivedCounts[sequence] == 0) {
+                    missing++;
+                }
+            }
+
+            return missing;
+        }
+};
+
+// Broker core, bridge and stand-in broker joined by links with a fixed one-way delay
+class Testbed : public UpstreamTransport
+{
+    protected:
+        static constexpr double TICK_INTERVAL = 0.01;
+
+        double delay;
+        std::vector<int> generations;
+
+    protected:
+        void deliverToBroker(int connection, int generation, std::vector<uint8_t> data)
+        {
+            if (generation != generations[connection]) {
+                return;
+            }
+
+            broker.handleStream(connection, data.data(), data.size());
+
+            std::vector<uint8_t> output = broker.takeOutput(connection);
+            if (!output.empty()) {
+                events.schedule(clock.time + delay, [this, connection, generation, output]() { deliverToBridge(connection, generation, output); });
+            }
+        }
+
+        void deliverToBridge(int connection, int generation, const std::vector<uint8_t>& data)
+        {
+            if (generation != generations[connection]) {
+                return;
+            }
+
+            bridge.handleStream(connection, data.data(), data.size());
+            bridge.flush();
+        }
+
+    public:
+        VirtualClock clock;
+        EventQueue events;
+        SubscriberTransport subscriberTransport;
+        BrokerCore core;
+        MqttBridge bridge;
+        StandInBroker broker;
+
+        Testbed(const BridgeConfig& config, double delay, const BrokerConfig& coreConfig = BrokerConfig()) :
+                delay(delay), generations(config.connections, 0), core(subscriberTransport, clock, coreConfig),
+                bridge(core, *this, clock, config), broker(config.connections)
+        {
+            core.setRelay(&bridge);
+        }
+
+        static BrokerConfig bridgedCore()
+        {
+            BrokerConfig config;
+            config.localDelivery = false;
+            return config;
+        }
+
+        virtual void write(int connection, const uint8_t* data, size_t length) override
+        {
+            int generation = generations[connection];
+            std::vector<uint8_t> bytes(data, data + length);
+            events.schedule(clock.time + delay, [this, connection, generation, bytes]() { deliverToBroker(connection, generation, bytes); });
+        }
+
+        void open(int connection)
+        {
+            bridge.connectionOpened(connection);
+            bridge.flush();
+        }
+
+        void close(int connection)
+        {
+            // bytes still on the link are lost with the connection
+            generations[connection]++;
+            bridge.connectionClosed(connection);
+            broker.disconnect(connection);
+        }
+
+        // advances virtual time, ticking the core and the bridge, until the condition holds or the time is up
+        double runUntil(const std::function<bool()>& done, double limit)
+        {
+            double nextTick = clock.time;
+
+            while (!done() && clock.time < limit) {
+                if (events.isEmpty() || events.getNextTime() >= nextTick) {
+                    clock.time = nextTick;
+                    core.tick();
+                    bridge.tick();
+                    bridge.flush();
+                    nextTick += TICK_INTERVAL;
+                    continue;
+                }
+
+                events.runNext(clock);
+            }
+
+            return clock.time;
+        }
+
+        void connectClient(EndpointId endpoint)
+        {
+            CorePacket connect;
+            connect.msgType = MsgType::CONNECT;
+            connect.flags = 1 << Flag::CLEAN_SESSION;
+            connect.text = "client" + std::to_string(endpoint);
+            core.handlePacket(endpoint, connect);
+        }
+
+        void subscribe(EndpointId endpoint, const std::string& topicName, bool subscribed = true)
+        {
+            CorePacket subscribe;
+            subscribe.msgType = subscribed ? MsgType::SUBSCRIBE : MsgType::UNSUBSCRIBE;
+            subscribe.setFlags(QoS::QOS_ZERO, TopicIdType::NORMAL_TOPIC_ID);
+            subscribe.msgId = 1;
+            subscribe.text = topicName;
+            core.handlePacket(endpoint, subscribe);
+        }
+
+        void publish(EndpointId endpoint, uint16_t topicId, QoS qos, uint32_t sequence, uint16_t msgId)
+        {
+            CorePacket publish;
+            publish.msgType = MsgType::PUBLISH;
+            publish.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID);
+            publish.topicId = topicId;
+            publish.msgId = msgId;
+            publish.data.assign(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+            core.handlePacket(endpoint, publish);
+
+            // the QoS 2 exchange with the MQTT-SN publisher completes at once
+            if (qos == QoS::QOS_TWO) {
+                CorePacket pubRel;
+                pubRel.msgType = MsgType::PUBREL;
+                pubRel.msgId = msgId;
+                core.handlePacket(endpoint, pubRel);
+            }
+        }
+};
+
+const EndpointId PUBLISHER = 1;
+const EndpointId FIRST_SUBSCRIBER = 1000;
+
+std::string topicName(int topic)
+{
+    return "bench/" + std::to_string(topic);
+}
+
+// one MQTT-SN subscriber per topic, subscribed upstream before the measurement starts
+std::vector<uint16_t> setUpTopics(Testbed& testbed, int topics)
+{
+    testbed.connectClient(PUBLISHER);
+    std::vector<uint16_t> topicIds;
+
+    for (int topic = 0; topic < topics; topic++) {
+        testbed.connectClient(FIRST_SUBSCRIBER + topic);
+        testbed.subscribe(FIRST_SUBSCRIBER + topic, topicName(topic));
+        topicIds.push_back(testbed.core.getTopicRegistry().findTopicId(topicName(topic)));
+    }
+
+    return topicIds;
+}
+
+void openAll(Testbed& testbed, int connections)
+{
+    for (int connection = 0; connection < connections; connection++) {
+        testbed.open(connection);
+    }
+
+    testbed.runUntil([&]() { return testbed.bridge.getStats().subscribePackets > 0 && testbed.events.isEmpty(); }, testbed.clock.time + 10);
+}
+
+void report(const std::string& name, const Testbed& testbed, uint32_t publications, double elapsed, double cpuSeconds)
+{
+    const BridgeStats& stats = testbed.bridge.getStats();
+
+    std::cout << name << ": " << publications << " publications in " << elapsed << " s of virtual time, "
+              << (uint64_t) (publications / elapsed) << " publications/s; delivered " << testbed.subscriberTransport.deliveries
+              << ", missing " << testbed.subscriberTransport.countMissing(publications) << ", duplicates "
+              << testbed.subscriberTransport.duplicates << "; upstream forwarded " << stats.forwardedPublications << ", received "
+              << stats.receivedPublications << "; " << (uint64_t) (publications / cpuSeconds) << " publications per CPU second" << std::endl;
+}
+
+// the upstream round trip bounds each connection to maxInflight publications per round trip
+void benchmarkPipelining(uint32_t publications, int connections, int maxInflight, QoS qos, double delay)
+{
+    BridgeConfig config;
+    config.connections = connections;
+    config.maxInflight = maxInflight;
+    config.maxQueued = publications;
+
+    Testbed testbed(config, delay, Testbed::bridgedCore());
+    const int topics = 64;
+    std::vector<uint16_t> topicIds = setUpTopics(testbed, topics);
+    openAll(testbed, connections);
+
+    auto cpuStart = std::chrono::steady_clock::now();
+    double start = testbed.clock.time;
+
+    for (uint32_t sequence = 0; sequence < publications; sequence++) {
+        testbed.publish(PUBLISHER, topicIds[sequence % topics], qos, sequence, (uint16_t) (sequence % UINT16_MAX + 1));
+    }
+    testbed.bridge.flush();
+
+    double end = testbed.runUntil([&]() { return testbed.subscriberTransport.deliveries >= publications; }, start + 3600);
+    double cpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - cpuStart).count();
+
+    report("pipelining qos " + std::to_string(qos == QoS::QOS_TWO ? 2 : 1) + ", " + std::to_string(connections) +
+           (connections == 1 ? " connection" : " connections") + ", window " + std::to_string(maxInflight),
+           testbed, publications, end - start, cpuSeconds);
+}
+
+// first subscribers of many topics arriving within a batch interval share SUBSCRIBE packets
+void benchmarkSubscriptionBatching(int topics, double batchInterval)
+{
+    BridgeConfig config;
+    config.connections = 2;
+    config.subscriptionBatchInterval = batchInterval;
+
+    Testbed testbed(config, 0.001, Testbed::bridgedCore());
+    openAll(testbed, config.connections);
+    testbed.runUntil([&]() { return testbed.bridge.isConnected(0) && testbed.bridge.isConnected(1); }, 1);
+
+    // a subscription every millisecond, and every other one withdrawn a millisecond later
+    for (int topic = 0; topic < topics; topic++) {
+        EndpointId endpoint = FIRST_SUBSCRIBER + topic;
+        testbed.connectClient(endpoint);
+        testbed.subscribe(endpoint, topicName(topic));
+
+        if (topic % 2 == 1) {
+            testbed.runUntil([]() { return false; }, testbed.clock.time + 0.001);
+            testbed.subscribe(endpoint, topicName(topic), false);
+        }
+
+        testbed.runUntil([]() { return false; }, testbed.clock.time + 0.001);
+    }
+
+    testbed.runUntil([]() { return false; }, testbed.clock.time + 1);
+
+    std::cout << "subscription batching over " << batchInterval << " s: " << topics << " subscriptions, " << topics / 2
+              << " withdrawn; upstream SUBSCRIBE packets " << testbed.broker.subscribePackets << ", UNSUBSCRIBE packets "
+              << testbed.broker.unsubscribePackets << std::endl;
+}
+
+// while the upstream is unavailable the queue fills and further publications are refused
+void benchmarkBackpressure(uint32_t attempts, size_t maxQueued)
+{
+    BridgeConfig config;
+    config.maxQueued = maxQueued;
+
+    Testbed testbed(config, 0.001, Testbed::bridgedCore());
+    std::vector<uint16_t> topicIds = setUpTopics(testbed, 8);
+
+    for (uint32_t sequence = 0; sequence < attempts; sequence++) {
+        testbed.publish(PUBLISHER, topicIds[sequence % topicIds.size()], QoS::QOS_ONE, sequence, (uint16_t) (sequence % UINT16_MAX + 1));
+    }
+
+    uint64_t accepted = testbed.subscriberTransport.accepted;
+    uint64_t rejected = testbed.subscriberTransport.rejected;
+
+    openAll(testbed, config.connections);
+    testbed.runUntil([&]() { return testbed.subscriberTransport.deliveries >= accepted; }, testbed.clock.time + 60);
+
+    std::cout << "backpressure with the upstream down: " << attempts << " QoS 1 publications, accepted " << accepted
+              << ", refused with REJECTED_CONGESTION " << rejected << "; delivered after connecting "
+              << testbed.subscriberTransport.deliveries << ", duplicates " << testbed.subscriberTransport.duplicates << std::endl;
+}
+
+// a connection dropped with publications in flight resumes its session and sends them again
+void benchmarkReconnection(uint32_t publications, QoS qos)
+{
+    BridgeConfig config;
+    config.connections = 2;
+    config.maxInflight = 16;
+    config.maxQueued = publications;
+    config.subscriptionQoS = qos == QoS::QOS_TWO ? 2 : 1;
+
+    Testbed testbed(config, 0.002, Testbed::bridgedCore());
+    std::vector<uint16_t> topicIds = setUpTopics(testbed, 16);
+    openAll(testbed, config.connections);
+
+    for (uint32_t sequence = 0; sequence < publications; sequence++) {
+        testbed.publish(PUBLISHER, topicIds[sequence % topicIds.size()], qos, sequence, (uint16_t) (sequence % UINT16_MAX + 1));
+    }
+    testbed.bridge.flush();
+
+    testbed.runUntil([&]() { return testbed.subscriberTransport.deliveries >= publications / 2; }, testbed.clock.time + 60);
+    testbed.close(0);
+    testbed.runUntil([]() { return false; }, testbed.clock.time + 0.1);
+    testbed.open(0);
+
+    testbed.runUntil([&]() { return testbed.subscriberTransport.countMissing(publications) == 0 && testbed.bridge.getInflightCount() == 0; },
+                     testbed.clock.time + 60);
+    testbed.runUntil([]() { return false; }, testbed.clock.time + 1);
+
+    std::cout << "reconnection at qos " << (qos == QoS::QOS_TWO ? 2 : 1) << ": " << publications << " publications, delivered "
+              << testbed.subscriberTransport.deliveries << ", missing " << testbed.subscriberTransport.countMissing(publications)
+              << ", duplicates " << testbed.subscriberTransport.duplicates << ", reconnections "
+              << testbed.bridge.getStats().reconnections << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // the scale multiplies every publication count
+    double scale = argc > 1 ? std::atof(argv[1]) : 1;
+    if (scale <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [scale]" << std::endl;
+        return 1;
+    }
+
+    const double delay = 0.001;
+    uint32_t publications = (uint32_t) (20000 * scale);
+
+    benchmarkPipelining(publications / 10, 1, 1, QoS::QOS_ONE, delay);
+    benchmarkPipelining(publications, 1, 8, QoS::QOS_ONE, delay);
+    benchmarkPipelining(publications, 1, 64, QoS::QOS_ONE, delay);
+    benchmarkPipelining(publications, 4, 64, QoS::QOS_ONE, delay);
+    benchmarkPipelining(publications, 4, 64, QoS::QOS_TWO, delay);
+
+    benchmarkSubscriptionBatching(1000, 0);
+    benchmarkSubscriptionBatching(1000, 0.05);
+
+    benchmarkBackpressure(publications, 5000);
+
+    benchmarkReconnection(publications, QoS::QOS_ONE);
+    benchmarkReconnection(publications, QoS::QOS_TWO);
+
+    return 0;
+}
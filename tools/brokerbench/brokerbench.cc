@@ -0,0 +1,288 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Microbenchmarks of the standalone broker of src/core, the one tools/gateway runs: wire
+// codec, PUBLISH fan-out at QoS 0 and 1, subscribe churn and retransmission sweeps. Packets
+// go through the same datagram entry point the gateway uses. The simulation does not run
+// this broker, so the figures say nothing about the MqttSNServer module.
+
+#include "core/BrokerCore.h"
+#include "core/WireCodec.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+class CountingTransport : public BrokerTransport
+{
+    public:
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+
+        // message IDs of the QoS 1/2 PUBLISH packets sent since the last clear
+        bool capture = false;
+        std::vector<std::pair<EndpointId, uint16_t>> publishes;
+
+        virtual void send(EndpointId endpoint, const uint8_t* data, size_t length) override
+        {
+            packets++;
+            bytes += length;
+
+            if (capture && length >= 7 && data[1] == MsgType::PUBLISH) {
+                publishes.emplace_back(endpoint, (uint16_t) ((data[5] << 8) | data[6]));
+            }
+        }
+};
+
+class ManualClock : public BrokerClock
+{
+    public:
+        double time = 0;
+
+        virtual double now() const override { return time; }
+};
+
+struct Fixture {
+    CountingTransport transport;
+    ManualClock clock;
+    BrokerCore broker;
+
+    Fixture(const BrokerConfig& config = BrokerConfig()) : broker(transport, clock, config) {}
+
+    void input(EndpointId endpoint, const CorePacket& packet)
+    {
+        std::vector<uint8_t> buffer;
+        WireCodec::encode(packet, buffer);
+        broker.handleDatagram(endpoint, buffer.data(), buffer.size());
+    }
+
+    void connect(EndpointId endpoint)
+    {
+        CorePacket packet;
+        packet.msgType = MsgType::CONNECT;
+        packet.flags = 1 << Flag::CLEAN_SESSION;
+        packet.text = "client" + std::to_string(endpoint);
+        input(endpoint, packet);
+    }
+
+    void subscribe(EndpointId endpoint, const std::string& topicName, QoS qos, uint16_t msgId = 1)
+    {
+        CorePacket packet;
+        packet.msgType = MsgType::SUBSCRIBE;
+        packet.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID);
+        packet.msgId = msgId;
+        packet.text = topicName;
+        input(endpoint, packet);
+    }
+
+    void unsubscribe(EndpointId endpoint, const std::string& topicName, uint16_t msgId = 1)
+    {
+        CorePacket packet;
+        packet.msgType = MsgType::UNSUBSCRIBE;
+        packet.msgId = msgId;
+        packet.text = topicName;
+        input(endpoint, packet);
+    }
+
+    uint16_t registerTopic(EndpointId endpoint, const std::string& topicName)
+    {
+        CorePacket packet;
+        packet.msgType = MsgType::REGISTER;
+        packet.msgId = 1;
+        packet.text = topicName;
+        input(endpoint, packet);
+
+        // topic IDs are handed out in order
+        return (uint16_t) broker.getTopicCount();
+    }
+};
+
+template<typename Function>
+void measure(const std::string& name, uint64_t operations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << operations << " ops in " << elapsed << " s, " << (uint64_t) (operations / elapsed) << " ops/s"
+              << std::endl;
+}
+
+void benchmarkCodec(uint64_t iterations)
+{
+    CorePacket publish;
+    publish.msgType = MsgType::PUBLISH;
+    publish.setFlags(QoS::QOS_ONE, TopicIdType::NORMAL_TOPIC_ID);
+    publish.topicId = 7;
+    publish.msgId = 42;
+    publish.data = std::string(64, 'x');
+
+    std::vector<uint8_t> buffer;
+    CorePacket decoded;
+    uint64_t checksum = 0;
+
+    measure("codec publish round trip", iterations, [&]() {
+        for (uint64_t i = 0; i < iterations; i++) {
+            publish.msgId = (uint16_t) i;
+            WireCodec::encode(publish, buffer);
+            WireCodec::decode(buffer.data(), buffer.size(), decoded);
+            checksum += decoded.msgId;
+        }
+    });
+
+    if (checksum == 0) {
+        std::cout << "unexpected checksum" << std::endl;
+    }
+}
+
+void benchmarkDispatch(uint64_t publishes, int subscribers, QoS qos)
+{
+    Fixture fixture;
+    EndpointId publisher = 0;
+
+    fixture.connect(publisher);
+    uint16_t topicId = fixture.registerTopic(publisher, "sensors/temperature");
+
+    for (int i = 1; i <= subscribers; i++) {
+        fixture.connect(i);
+        fixture.subscribe(i, "sensors/temperature", qos);
+    }
+
+    CorePacket publish;
+    publish.msgType = MsgType::PUBLISH;
+    publish.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID);
+    publish.topicId = topicId;
+    publish.data = std::string(32, 'x');
+
+    std::vector<uint8_t> datagram;
+    std::vector<uint8_t> ack;
+    CorePacket pubAck;
+    pubAck.msgType = MsgType::PUBACK;
+    pubAck.topicId = topicId;
+
+    fixture.transport.capture = qos != QoS::QOS_ZERO;
+
+    measure("dispatch qos " + std::to_string(qos) + " to " + std::to_string(subscribers) + " subscribers", publishes * subscribers, [&]() {
+        for (uint64_t i = 0; i < publishes; i++) {
+            publish.msgId = (uint16_t) (i % UINT16_MAX + 1);
+            WireCodec::encode(publish, datagram);
+            fixture.broker.handleDatagram(publisher, datagram.data(), datagram.size());
+
+            // every subscriber acknowledges right away
+            for (const auto& sent : fixture.transport.publishes) {
+                pubAck.msgId = sent.second;
+                WireCodec::encode(pubAck, ack);
+                fixture.broker.handleDatagram(sent.first, ack.data(), ack.size());
+            }
+            fixture.transport.publishes.clear();
+        }
+    });
+
+    std::cout << "  delivered " << fixture.broker.getStats().deliveredMessages << ", pending " << fixture.broker.getOutboundCount()
+              << std::endl;
+}
+
+void benchmarkSubscribeChurn(uint64_t operations, int clients, int topics)
+{
+    Fixture fixture;
+
+    for (int i = 0; i < clients; i++) {
+        fixture.connect(i);
+    }
+
+    std::vector<std::string> topicNames;
+    for (int i = 0; i < topics; i++) {
+        topicNames.push_back("churn/topic/" + std::to_string(i));
+    }
+
+    measure("subscribe churn over " + std::to_string(clients) + " clients and " + std::to_string(topics) + " topics", operations, [&]() {
+        for (uint64_t i = 0; i < operations; i++) {
+            EndpointId endpoint = i % clients;
+            const std::string& topicName = topicNames[(i / clients) % topics];
+
+            if ((i / clients / topics) % 2 == 0) {
+                fixture.subscribe(endpoint, topicName, QoS::QOS_ONE, (uint16_t) (i % UINT16_MAX + 1));
+            }
+            else {
+                fixture.unsubscribe(endpoint, topicName, (uint16_t) (i % UINT16_MAX + 1));
+            }
+        }
+    });
+}
+
+void benchmarkRetransmissionSweep(int sweeps, int subscribers, int pendingPerSubscriber)
+{
+    BrokerConfig config;
+    config.retransmissionInterval = 1;
+    config.retransmissionCounter = sweeps;
+
+    Fixture fixture(config);
+    fixture.connect(0);
+    uint16_t topicId = fixture.registerTopic(0, "alerts");
+
+    for (int i = 1; i <= subscribers; i++) {
+        fixture.connect(i);
+        fixture.subscribe(i, "alerts", QoS::QOS_ONE);
+    }
+
+    // unacknowledged deliveries build up the outbound table
+    CorePacket publish;
+    publish.msgType = MsgType::PUBLISH;
+    publish.setFlags(QoS::QOS_ONE, TopicIdType::NORMAL_TOPIC_ID);
+    publish.topicId = topicId;
+    publish.data = "alert";
+
+    for (int i = 1; i <= pendingPerSubscriber; i++) {
+        publish.msgId = (uint16_t) i;
+        fixture.input(0, publish);
+    }
+
+    size_t pending = fixture.broker.getOutboundCount();
+
+    measure("retransmission sweep over " + std::to_string(pending) + " pending messages", (uint64_t) sweeps * pending, [&]() {
+        for (int i = 0; i < sweeps; i++) {
+            fixture.clock.time += config.retransmissionInterval;
+            fixture.broker.tick();
+        }
+    });
+
+    std::cout << "  retransmitted " << fixture.broker.getStats().retransmittedMessages << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // the scale multiplies every operation count
+    double scale = argc > 1 ? std::atof(argv[1]) : 1;
+    if (scale <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [scale]" << std::endl;
+        return 1;
+    }
+
+    benchmarkCodec((uint64_t) (2000000 * scale));
+    benchmarkDispatch((uint64_t) (200000 * scale), 10, QoS::QOS_ZERO);
+    benchmarkDispatch((uint64_t) (20000 * scale), 100, QoS::QOS_ZERO);
+    benchmarkDispatch((uint64_t) (100000 * scale), 10, QoS::QOS_ONE);
+    benchmarkSubscribeChurn((uint64_t) (1000000 * scale), 1000, 100);
+    benchmarkRetransmissionSweep((int) (10 * scale) + 1, 1000, 50);
+
+    return 0;
+}
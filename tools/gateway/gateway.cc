@@ -0,0 +1,1232 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// MQTT-SN gateway over real UDP on Linux, driving the standalone broker of src/core from an
+// epoll loop. That broker is a subset of the MqttSNServer module, written separately: will
+// messages, sleeping clients and wildcard subscriptions are not supported. Datagrams are received with recvmmsg and the replies of a whole batch are
+// sent with sendmmsg. Client addresses are interned into dense endpoint IDs through an
+// open addressing hash table. Parameters are named after the MqttSNServer NED parameters and are
+// read from a "name = value" config file; see gateway.conf.
+//
+// With threads > 1 the gateway runs one shard per thread. Every shard binds its own
+// SO_REUSEPORT socket, so the kernel hashes each client address to a fixed shard that
+// owns its session, subscriptions and pending messages. All shards share one topic
+// registry, written under a lock and read without one. A publish accepted by a shard is
+// delivered to its own subscribers and passed to every other shard through a lock-free
+// single producer, single consumer queue per pair of shards.
+//
+// With an upstreamAddress the gateway is an aggregating bridge to an MQTT broker instead
+// (src/core/MqttBridge): each shard multiplexes its clients over a few TCP connections of
+// its own, publications go upstream pipelined and subscriptions follow in batches. The
+// upstream broker delivers back to every shard with subscribers, so shards do not relay.
+
+#include "core/BrokerCore.h"
+#include "core/MqttBridge.h"
+#include "core/SharedTopicRegistry.h"
+#include "containers/SpscQueue.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+struct GatewayConfig {
+    std::string localAddress = "0.0.0.0";
+    int localPort = 1883;
+    int batchSize = 64;
+    double tickInterval = 0.1;
+    double statsInterval = 5;
+    int socketBufferSize = 4 << 20;
+    int threads = 1;
+    bool pinThreads = false;
+    size_t queueCapacity = 4096;
+    std::string upstreamAddress; // empty for a self-contained broker
+    int upstreamPort = 1883;
+    double reconnectInterval = 1;
+    BrokerConfig broker;
+    BridgeConfig bridge;
+    std::vector<std::pair<std::string, uint16_t>> predefinedTopics;
+};
+
+std::string trim(const std::string& value)
+{
+    size_t begin = value.find_first_not_of(" \t\r\"");
+    size_t end = value.find_last_not_of(" \t\r\"");
+
+    return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+}
+
+// durations accept the NED units s and ms
+double parseSeconds(const std::string& value)
+{
+    size_t consumed = 0;
+    double number = std::stod(value, &consumed);
+    std::string unit = trim(value.substr(consumed));
+
+    if (unit.empty() || unit == "s") {
+        return number;
+    }
+
+    if (unit == "ms") {
+        return number / 1000;
+    }
+
+    throw std::invalid_argument("unknown time unit " + unit);
+}
+
+GatewayConfig loadConfig(const std::string& fileName)
+{
+    GatewayConfig config;
+
+    std::ifstream file(fileName);
+    if (!file) {
+        throw std::runtime_error("cannot open config file " + fileName);
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        line = line.substr(0, line.find('#'));
+        size_t separator = line.find('=');
+
+        if (trim(line).empty()) {
+            continue;
+        }
+
+        if (separator == std::string::npos) {
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": expected name = value");
+        }
+
+        std::string name = trim(line.substr(0, separator));
+        std::string value = trim(line.substr(separator + 1));
+
+        if (name == "localAddress") {
+            config.localAddress = value;
+        }
+        else if (name == "localPort") {
+            config.localPort = std::stoi(value);
+        }
+        else if (name == "gatewayId") {
+            config.broker.gatewayId = (uint8_t) std::stoi(value);
+        }
+        else if (name == "retransmissionInterval") {
+            config.broker.retransmissionInterval = parseSeconds(value);
+        }
+        else if (name == "retransmissionCounter") {
+            config.broker.retransmissionCounter = std::stoi(value);
+        }
+        else if (name == "keepAliveFactor") {
+            config.broker.keepAliveFactor = std::stod(value);
+        }
+        else if (name == "maximumTopics") {
+            config.broker.maximumTopics = (uint16_t) std::stoi(value);
+        }
+        else if (name == "batchSize") {
+            config.batchSize = std::max(1, std::stoi(value));
+        }
+        else if (name == "tickInterval") {
+            config.tickInterval = parseSeconds(value);
+        }
+        else if (name == "statsInterval") {
+            config.statsInterval = parseSeconds(value);
+        }
+        else if (name == "socketBufferSize") {
+            config.socketBufferSize = std::stoi(value);
+        }
+        else if (name == "threads") {
+            // 0 starts one shard per available core
+            config.threads = std::stoi(value) > 0 ? std::stoi(value) : std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (name == "pinThreads") {
+            config.pinThreads = value == "true";
+        }
+        else if (name == "queueCapacity") {
+            config.queueCapacity = std::max(2, std::stoi(value));
+        }
+        else if (name == "upstreamAddress") {
+            config.upstreamAddress = value;
+        }
+        else if (name == "upstreamPort") {
+            config.upstreamPort = std::stoi(value);
+        }
+        else if (name == "upstreamClientId") {
+            config.bridge.clientId = value;
+        }
+        else if (name == "upstreamConnections") {
+            config.bridge.connections = std::max(1, std::stoi(value));
+        }
+        else if (name == "upstreamKeepAlive") {
+            config.bridge.keepAlive = (uint16_t) parseSeconds(value);
+        }
+        else if (name == "upstreamMaxInflight") {
+            config.bridge.maxInflight = std::max(1, std::stoi(value));
+        }
+        else if (name == "upstreamMaxQueued") {
+            config.bridge.maxQueued = std::max(1, std::stoi(value));
+        }
+        else if (name == "upstreamSubscriptionQoS") {
+            config.bridge.subscriptionQoS = (uint8_t) std::min(2, std::max(0, std::stoi(value)));
+        }
+        else if (name == "subscriptionBatchInterval") {
+            config.bridge.subscriptionBatchInterval = parseSeconds(value);
+        }
+        else if (name == "reconnectInterval") {
+            config.reconnectInterval = parseSeconds(value);
+        }
+        else if (name == "predefinedTopic") {
+            // predefinedTopic = name:id, once per topic
+            size_t colon = value.rfind(':');
+            if (colon == std::string::npos) {
+                throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": expected predefinedTopic = name:id");
+            }
+
+            config.predefinedTopics.emplace_back(value.substr(0, colon), (uint16_t) std::stoi(value.substr(colon + 1)));
+        }
+        else {
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": unknown parameter " + name);
+        }
+    }
+
+    // the upstream broker routes between shards, and the core must not deliver a publication twice
+    config.broker.localDelivery = config.upstreamAddress.empty();
+
+    return config;
+}
+
+// Maps client socket addresses to dense endpoint IDs with linear probing
+class EndpointTable
+{
+    protected:
+        struct Slot {
+            uint64_t hash = 0;
+            int32_t endpoint = -1;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<sockaddr_storage> addresses;
+        std::vector<socklen_t> addressLengths;
+
+        static uint64_t hashAddress(const sockaddr_storage& address, socklen_t length)
+        {
+            // FNV-1a over the address and port bytes
+            const uint8_t* bytes;
+            size_t count;
+
+            if (address.ss_family == AF_INET) {
+                const sockaddr_in& in = reinterpret_cast<const sockaddr_in&>(address);
+                bytes = reinterpret_cast<const uint8_t*>(&in.sin_addr);
+                count = sizeof(in.sin_addr);
+            }
+            else {
+                const sockaddr_in6& in6 = reinterpret_cast<const sockaddr_in6&>(address);
+                bytes = reinterpret_cast<const uint8_t*>(&in6.sin6_addr);
+                count = sizeof(in6.sin6_addr);
+            }
+
+            uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < count; i++) {
+                hash = (hash ^ bytes[i]) * 1099511628211ULL;
+            }
+
+            uint16_t port = address.ss_family == AF_INET ? reinterpret_cast<const sockaddr_in&>(address).sin_port
+                                                         : reinterpret_cast<const sockaddr_in6&>(address).sin6_port;
+
+            return ((hash ^ port) * 1099511628211ULL) | 1;
+        }
+
+        static bool isSameAddress(const sockaddr_storage& first, const sockaddr_storage& second)
+        {
+            if (first.ss_family != second.ss_family) {
+                return false;
+            }
+
+            if (first.ss_family == AF_INET) {
+                const sockaddr_in& a = reinterpret_cast<const sockaddr_in&>(first);
+                const sockaddr_in& b = reinterpret_cast<const sockaddr_in&>(second);
+                return a.sin_port == b.sin_port && a.sin_addr.s_addr == b.sin_addr.s_addr;
+            }
+
+            const sockaddr_in6& a = reinterpret_cast<const sockaddr_in6&>(first);
+            const sockaddr_in6& b = reinterpret_cast<const sockaddr_in6&>(second);
+            return a.sin6_port == b.sin6_port && std::memcmp(&a.sin6_addr, &b.sin6_addr, sizeof(a.sin6_addr)) == 0;
+        }
+
+        void grow()
+        {
+            std::vector<Slot> previous(slots.size() * 2);
+            previous.swap(slots);
+
+            for (const Slot& slot : previous) {
+                if (slot.endpoint >= 0) {
+                    size_t index = slot.hash & (slots.size() - 1);
+                    while (slots[index].endpoint >= 0) {
+                        index = (index + 1) & (slots.size() - 1);
+                    }
+                    slots[index] = slot;
+                }
+            }
+        }
+
+    public:
+        EndpointTable() : slots(1024) {}
+
+        EndpointId intern(const sockaddr_storage& address, socklen_t length)
+        {
+            uint64_t hash = hashAddress(address, length);
+            size_t index = hash & (slots.size() - 1);
+
+            while (slots[index].endpoint >= 0) {
+                if (slots[index].hash == hash && isSameAddress(addresses[slots[index].endpoint], address)) {
+                    return slots[index].endpoint;
+                }
+
+                index = (index + 1) & (slots.size() - 1);
+            }
+
+            int32_t endpoint = (int32_t) addresses.size();
+            addresses.push_back(address);
+            addressLengths.push_back(length);
+            slots[index] = Slot{hash, endpoint};
+
+            // keep the load factor at or below one half
+            if (addresses.size() * 2 > slots.size()) {
+                grow();
+            }
+
+            return endpoint;
+        }
+
+        const sockaddr_storage& getAddress(EndpointId endpoint) const { return addresses[endpoint]; }
+        socklen_t getAddressLength(EndpointId endpoint) const { return addressLengths[endpoint]; }
+        size_t size() const { return addresses.size(); }
+};
+
+// Collects the datagrams of one batch and sends them with a single sendmmsg
+class BatchTransport : public BrokerTransport
+{
+    protected:
+        static constexpr size_t MAX_DATAGRAM = 65536;
+
+        int socket;
+        const EndpointTable& endpoints;
+
+        std::vector<mmsghdr> messages;
+        std::vector<iovec> vectors;
+        std::vector<std::vector<uint8_t>> buffers;
+        size_t count = 0;
+
+    public:
+        uint64_t sentDatagrams = 0;
+        uint64_t sentBytes = 0;
+        uint64_t sendCalls = 0;
+        uint64_t droppedDatagrams = 0;
+
+        BatchTransport(int socket, const EndpointTable& endpoints, size_t batchSize) :
+                socket(socket), endpoints(endpoints), messages(batchSize), vectors(batchSize), buffers(batchSize) {}
+
+        virtual void send(EndpointId endpoint, const uint8_t* data, size_t length) override
+        {
+            if (count == messages.size()) {
+                flush();
+            }
+
+            buffers[count].assign(data, data + std::min(length, MAX_DATAGRAM));
+            vectors[count].iov_base = buffers[count].data();
+            vectors[count].iov_len = buffers[count].size();
+
+            msghdr& header = messages[count].msg_hdr;
+            std::memset(&header, 0, sizeof(header));
+            header.msg_name = const_cast<sockaddr_storage*>(&endpoints.getAddress(endpoint));
+            header.msg_namelen = endpoints.getAddressLength(endpoint);
+            header.msg_iov = &vectors[count];
+            header.msg_iovlen = 1;
+
+            count++;
+        }
+
+        void flush()
+        {
+            size_t offset = 0;
+
+            while (offset < count) {
+                int sent = sendmmsg(socket, messages.data() + offset, count - offset, 0);
+                sendCalls++;
+
+                if (sent < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    // a full socket buffer or an unreachable client loses the rest of the batch, as UDP would
+                    droppedDatagrams += count - offset;
+                    break;
+                }
+
+                for (int i = 0; i < sent; i++) {
+                    sentBytes += vectors[offset + i].iov_len;
+                }
+
+                sentDatagrams += sent;
+                offset += sent;
+            }
+
+            count = 0;
+        }
+};
+
+class SteadyClock : public BrokerClock
+{
+    protected:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    public:
+        virtual double now() const override
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+};
+
+socklen_t parseAddress(const std::string& name, const std::string& host, int port, sockaddr_storage& address)
+{
+    address = sockaddr_storage{};
+
+    if (host.find(':') != std::string::npos) {
+        sockaddr_in6& in6 = reinterpret_cast<sockaddr_in6&>(address);
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+
+        if (inet_pton(AF_INET6, host.c_str(), &in6.sin6_addr) != 1) {
+            throw std::runtime_error("invalid " + name + " " + host);
+        }
+
+        return sizeof(in6);
+    }
+
+    sockaddr_in& in = reinterpret_cast<sockaddr_in&>(address);
+    in.sin_family = AF_INET;
+    in.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, host.c_str(), &in.sin_addr) != 1) {
+        throw std::runtime_error("invalid " + name + " " + host);
+    }
+
+    return sizeof(in);
+}
+
+int openSocket(const GatewayConfig& config)
+{
+    sockaddr_storage address;
+    socklen_t length = parseAddress("localAddress", config.localAddress, config.localPort, address);
+
+    int fd = socket(address.ss_family, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config.socketBufferSize, sizeof(config.socketBufferSize));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &config.socketBufferSize, sizeof(config.socketBufferSize));
+
+    // every shard binds the same address; the kernel spreads clients by their address hash
+    if (config.threads > 1) {
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0) {
+        throw std::runtime_error(std::string("bind: ") + std::strerror(errno));
+    }
+
+    return fd;
+}
+
+int openTimer(double interval)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+
+    itimerspec spec{};
+    spec.it_interval.tv_sec = (time_t) interval;
+    spec.it_interval.tv_nsec = (long) ((interval - (time_t) interval) * 1e9);
+    spec.it_value = spec.it_interval;
+    timerfd_settime(fd, 0, &spec, nullptr);
+
+    return fd;
+}
+
+void addToEpoll(int epollFd, int fd, uint32_t events = EPOLLIN, int operation = EPOLL_CTL_ADD)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, operation, fd, &event);
+}
+
+// Non-blocking TCP connections of one shard to the upstream MQTT broker. Output the kernel
+// does not take at once waits here, with EPOLLOUT armed until it is written; a connection
+// that fails or closes is opened again after reconnectInterval.
+class UpstreamConnections : public UpstreamTransport
+{
+    protected:
+        static constexpr size_t READ_SIZE = 65536;
+
+        struct Link {
+            int fd = -1;
+            bool connecting = false;
+            double retryTime = 0;
+            std::vector<uint8_t> pending;
+        };
+
+        const GatewayConfig& config;
+        const BrokerClock& clock;
+        int epollFd;
+        sockaddr_storage address;
+        socklen_t addressLength;
+
+        std::vector<Link> links;
+        std::vector<uint8_t> readBuffer;
+        MqttBridge* bridge = nullptr;
+
+    protected:
+        void open(int connection)
+        {
+            Link& link = links[connection];
+
+            link.fd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (link.fd < 0) {
+                link.retryTime = clock.now() + config.reconnectInterval;
+                return;
+            }
+
+            // publications are already batched per event loop pass
+            int enable = 1;
+            setsockopt(link.fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+            if (connect(link.fd, reinterpret_cast<sockaddr*>(&address), addressLength) == 0) {
+                addToEpoll(epollFd, link.fd);
+                bridge->connectionOpened(connection);
+            }
+            else if (errno == EINPROGRESS) {
+                link.connecting = true;
+                addToEpoll(epollFd, link.fd, EPOLLOUT);
+            }
+            else {
+                close(link.fd);
+                link.fd = -1;
+                link.retryTime = clock.now() + config.reconnectInterval;
+            }
+        }
+
+        void drop(int connection)
+        {
+            Link& link = links[connection];
+            bool wasOpen = !link.connecting;
+
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, link.fd, nullptr);
+            close(link.fd);
+
+            link.fd = -1;
+            link.connecting = false;
+            link.pending.clear();
+            link.retryTime = clock.now() + config.reconnectInterval;
+
+            if (wasOpen) {
+                bridge->connectionClosed(connection);
+            }
+        }
+
+        void writePending(int connection)
+        {
+            Link& link = links[connection];
+
+            while (!link.pending.empty()) {
+                ssize_t written = send(link.fd, link.pending.data(), link.pending.size(), MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        drop(connection);
+                    }
+                    return;
+                }
+
+                link.pending.erase(link.pending.begin(), link.pending.begin() + written);
+            }
+
+            addToEpoll(epollFd, link.fd, EPOLLIN, EPOLL_CTL_MOD);
+        }
+
+    public:
+        UpstreamConnections(const GatewayConfig& config, const BrokerClock& clock, int epollFd) :
+                config(config), clock(clock), epollFd(epollFd), links(config.bridge.connections), readBuffer(READ_SIZE)
+        {
+            addressLength = parseAddress("upstreamAddress", config.upstreamAddress, config.upstreamPort, address);
+        }
+
+        ~UpstreamConnections()
+        {
+            for (Link& link : links) {
+                if (link.fd >= 0) {
+                    close(link.fd);
+                }
+            }
+        }
+
+        void setBridge(MqttBridge* bridge) { this->bridge = bridge; }
+
+        // opens the connections that are down once their retry time has come
+        void reconnect()
+        {
+            double now = clock.now();
+
+            for (size_t i = 0; i < links.size(); i++) {
+                if (links[i].fd < 0 && links[i].retryTime <= now) {
+                    open(i);
+                }
+            }
+        }
+
+        int findConnection(int fd) const
+        {
+            for (size_t i = 0; i < links.size(); i++) {
+                if (links[i].fd == fd) {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+
+        void handleEvent(int connection, uint32_t events)
+        {
+            Link& link = links[connection];
+
+            if (link.connecting) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(link.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+
+                if (error != 0) {
+                    drop(connection);
+                    return;
+                }
+
+                link.connecting = false;
+                addToEpoll(epollFd, link.fd, EPOLLIN, EPOLL_CTL_MOD);
+                bridge->connectionOpened(connection);
+                return;
+            }
+
+            if (events & EPOLLOUT) {
+                writePending(connection);
+            }
+
+            if (links[connection].fd < 0 || !(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                return;
+            }
+
+            while (true) {
+                ssize_t received = recv(link.fd, readBuffer.data(), readBuffer.size(), 0);
+
+                if (received > 0) {
+                    if (!bridge->handleStream(connection, readBuffer.data(), received)) {
+                        drop(connection);
+                        return;
+                    }
+                }
+                else {
+                    if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        drop(connection);
+                    }
+                    return;
+                }
+            }
+        }
+
+        virtual void write(int connection, const uint8_t* data, size_t length) override
+        {
+            Link& link = links[connection];
+            if (link.fd < 0 || link.connecting) {
+                return;
+            }
+
+            // keeps the stream in order behind output that is still waiting
+            if (link.pending.empty()) {
+                ssize_t written = send(link.fd, data, length, MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        drop(connection);
+                        return;
+                    }
+                    written = 0;
+                }
+
+                if ((size_t) written == length) {
+                    return;
+                }
+
+                data += written;
+                length -= written;
+                addToEpoll(epollFd, link.fd, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+            }
+
+            link.pending.insert(link.pending.end(), data, data + length);
+        }
+};
+
+// publish accepted by another shard
+struct RemotePublish {
+    uint16_t topicId = 0;
+    QoS qos = QoS::QOS_ZERO;
+    bool retain = false;
+    std::string data;
+};
+
+// counters a shard exports on every tick for the stats reporter
+struct ShardCounters {
+    std::atomic<uint64_t> receivedDatagrams{0};
+    std::atomic<uint64_t> receiveCalls{0};
+    std::atomic<uint64_t> sentDatagrams{0};
+    std::atomic<uint64_t> sendCalls{0};
+    std::atomic<uint64_t> droppedDatagrams{0};
+    std::atomic<uint64_t> malformedPackets{0};
+    std::atomic<uint64_t> publishedMessages{0};
+    std::atomic<uint64_t> deliveredMessages{0};
+    std::atomic<uint64_t> retransmittedMessages{0};
+    std::atomic<uint64_t> relayedMessages{0};
+    std::atomic<uint64_t> forwardedPublications{0};
+    std::atomic<uint64_t> receivedPublications{0};
+    std::atomic<uint64_t> queuedPublications{0};
+    std::atomic<uint64_t> endpoints{0};
+    std::atomic<uint64_t> sessions{0};
+};
+
+// One broker core with its socket, clients and event loop, run by a single thread
+class Shard : public BrokerRelay
+{
+    protected:
+        static constexpr size_t DATAGRAM_SIZE = 65536;
+        static constexpr int MAX_BATCHES_PER_WAKEUP = 16;
+
+        size_t index;
+        const GatewayConfig& config;
+        std::vector<std::unique_ptr<Shard>>& shards;
+
+        int socketFd;
+        int wakeFd;
+        int tickFd;
+        int epollFd;
+
+        EndpointTable endpoints;
+        BatchTransport transport;
+        BrokerCore broker;
+
+        // set in bridge mode only
+        std::unique_ptr<UpstreamConnections> upstream;
+        std::unique_ptr<MqttBridge> bridge;
+
+        // incoming[i] is written by shard i only
+        std::vector<std::unique_ptr<SpscQueue<RemotePublish>>> incoming;
+
+        // publishes for each shard that did not fit into its queue yet
+        std::vector<std::deque<RemotePublish>> overflow;
+        std::vector<bool> pendingWakes;
+        size_t overflowCount = 0;
+        uint64_t relayedMessages = 0;
+
+        // receive buffers of one batch
+        std::vector<uint8_t> receiveBuffer;
+        std::vector<mmsghdr> messages;
+        std::vector<iovec> vectors;
+        std::vector<sockaddr_storage> addresses;
+        uint64_t receivedDatagrams = 0;
+        uint64_t receiveCalls = 0;
+
+    protected:
+        void receiveDatagrams()
+        {
+            // drain the socket one batch at a time; replies go out once per batch. The socket stays
+            // readable after the last batch allowed here, so a saturated shard still gets to its timers.
+            for (int batch = 0; batch < MAX_BATCHES_PER_WAKEUP; batch++) {
+                for (int i = 0; i < config.batchSize; i++) {
+                    vectors[i].iov_base = receiveBuffer.data() + i * DATAGRAM_SIZE;
+                    vectors[i].iov_len = DATAGRAM_SIZE;
+
+                    std::memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+                    messages[i].msg_hdr.msg_name = &addresses[i];
+                    messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+                    messages[i].msg_hdr.msg_iov = &vectors[i];
+                    messages[i].msg_hdr.msg_iovlen = 1;
+                }
+
+                int received = recvmmsg(socketFd, messages.data(), config.batchSize, MSG_DONTWAIT, nullptr);
+                if (received <= 0) {
+                    break;
+                }
+
+                receiveCalls++;
+                receivedDatagrams += received;
+
+                for (int i = 0; i < received; i++) {
+                    EndpointId endpoint = endpoints.intern(addresses[i], messages[i].msg_hdr.msg_namelen);
+                    broker.handleDatagram(endpoint, static_cast<uint8_t*>(vectors[i].iov_base), messages[i].msg_len);
+                }
+
+                transport.flush();
+                flushRelays();
+                flushUpstream();
+
+                if (received < config.batchSize) {
+                    break;
+                }
+            }
+        }
+
+        void receiveRemotePublishes()
+        {
+            RemotePublish message;
+            bool delivered = false;
+
+            for (auto& queue : incoming) {
+                while (queue && queue->pop(message)) {
+                    broker.publish(message.topicId, message.qos, message.data, message.retain);
+                    delivered = true;
+                }
+            }
+
+            if (delivered) {
+                transport.flush();
+            }
+        }
+
+        // moves held back publishes into the queues and wakes every shard that got any, once per batch
+        void flushRelays()
+        {
+            for (size_t target = 0; overflowCount > 0 && target < shards.size(); target++) {
+                std::deque<RemotePublish>& held = overflow[target];
+                SpscQueue<RemotePublish>& queue = *shards[target]->incoming[index];
+
+                while (!held.empty() && queue.push(std::move(held.front()))) {
+                    held.pop_front();
+                    overflowCount--;
+                    pendingWakes[target] = true;
+                }
+            }
+
+            for (size_t target = 0; target < shards.size(); target++) {
+                if (pendingWakes[target]) {
+                    shards[target]->wake();
+                    pendingWakes[target] = false;
+                }
+            }
+        }
+
+        void flushUpstream()
+        {
+            if (bridge) {
+                bridge->flush();
+            }
+        }
+
+        void exportCounters()
+        {
+            const BrokerStats& stats = broker.getStats();
+
+            counters.receivedDatagrams.store(receivedDatagrams, std::memory_order_relaxed);
+            counters.receiveCalls.store(receiveCalls, std::memory_order_relaxed);
+            counters.sentDatagrams.store(transport.sentDatagrams, std::memory_order_relaxed);
+            counters.sendCalls.store(transport.sendCalls, std::memory_order_relaxed);
+            counters.droppedDatagrams.store(transport.droppedDatagrams, std::memory_order_relaxed);
+            counters.malformedPackets.store(stats.malformedPackets, std::memory_order_relaxed);
+            counters.publishedMessages.store(stats.publishedMessages, std::memory_order_relaxed);
+            counters.deliveredMessages.store(stats.deliveredMessages, std::memory_order_relaxed);
+            counters.retransmittedMessages.store(stats.retransmittedMessages, std::memory_order_relaxed);
+            counters.relayedMessages.store(relayedMessages, std::memory_order_relaxed);
+            counters.endpoints.store(endpoints.size(), std::memory_order_relaxed);
+
+            if (bridge) {
+                counters.forwardedPublications.store(bridge->getStats().forwardedPublications, std::memory_order_relaxed);
+                counters.receivedPublications.store(bridge->getStats().receivedPublications, std::memory_order_relaxed);
+                counters.queuedPublications.store(bridge->getQueuedCount(), std::memory_order_relaxed);
+            }
+            counters.sessions.store(broker.getSessionCount(), std::memory_order_relaxed);
+        }
+
+    public:
+        ShardCounters counters;
+
+        Shard(size_t index, const GatewayConfig& config, std::vector<std::unique_ptr<Shard>>& shards, SharedTopicRegistry& registry,
+              const BrokerClock& clock) :
+                index(index), config(config), shards(shards), socketFd(openSocket(config)), wakeFd(eventfd(0, EFD_NONBLOCK)),
+                tickFd(openTimer(config.tickInterval)), epollFd(epoll_create1(0)), transport(socketFd, endpoints, config.batchSize),
+                broker(transport, clock, config.broker, &registry), incoming(config.threads), overflow(config.threads),
+                pendingWakes(config.threads, false), receiveBuffer(config.batchSize * DATAGRAM_SIZE), messages(config.batchSize),
+                vectors(config.batchSize), addresses(config.batchSize)
+        {
+            for (int source = 0; source < config.threads; source++) {
+                if ((size_t) source != index) {
+                    incoming[source].reset(new SpscQueue<RemotePublish>(config.queueCapacity));
+                }
+            }
+
+            if (!config.upstreamAddress.empty()) {
+                // every shard has its own upstream sessions, told apart by the shard index
+                BridgeConfig bridgeConfig = config.bridge;
+                if (config.threads > 1) {
+                    bridgeConfig.clientId += "-s" + std::to_string(index);
+                }
+
+                upstream.reset(new UpstreamConnections(config, clock, epollFd));
+                bridge.reset(new MqttBridge(broker, *upstream, clock, bridgeConfig));
+                upstream->setBridge(bridge.get());
+                broker.setRelay(bridge.get());
+            }
+            else if (config.threads > 1) {
+                broker.setRelay(this);
+            }
+
+            for (int fd : {socketFd, wakeFd, tickFd}) {
+                addToEpoll(epollFd, fd);
+            }
+        }
+
+        ~Shard()
+        {
+            bridge.reset();
+            upstream.reset();
+
+            close(epollFd);
+            close(tickFd);
+            close(wakeFd);
+            close(socketFd);
+        }
+
+        virtual void relay(uint16_t topicId, QoS qos, const std::string& data, bool retain) override
+        {
+            for (size_t target = 0; target < shards.size(); target++) {
+                if (target == index) {
+                    continue;
+                }
+
+                // order per target is kept by queueing behind any held back publish
+                RemotePublish message{topicId, qos, retain, data};
+                if (!overflow[target].empty() || !shards[target]->incoming[index]->push(std::move(message))) {
+                    overflow[target].push_back(std::move(message));
+                    overflowCount++;
+                }
+
+                pendingWakes[target] = true;
+                relayedMessages++;
+            }
+        }
+
+        void wake()
+        {
+            uint64_t value = 1;
+            ssize_t count = write(wakeFd, &value, sizeof(value));
+            (void) count;
+        }
+
+        void run(const std::atomic<bool>& running)
+        {
+            if (config.pinThreads) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+            }
+
+            if (upstream) {
+                upstream->reconnect();
+            }
+
+            std::vector<epoll_event> events(3 + config.bridge.connections);
+
+            while (running.load(std::memory_order_relaxed)) {
+                // held back publishes are retried without waiting for the next event
+                int ready = epoll_wait(epollFd, events.data(), events.size(), overflowCount > 0 ? 1 : -1);
+
+                for (int e = 0; e < ready; e++) {
+                    int fd = events[e].data.fd;
+                    int connection = upstream ? upstream->findConnection(fd) : -1;
+
+                    if (fd == socketFd) {
+                        receiveDatagrams();
+                    }
+                    else if (connection >= 0) {
+                        // deliveries from upstream go out to the clients with the batch
+                        upstream->handleEvent(connection, events[e].events);
+                        transport.flush();
+                    }
+                    else {
+                        uint64_t value;
+                        ssize_t count = read(fd, &value, sizeof(value));
+                        (void) count;
+
+                        if (fd == tickFd) {
+                            broker.tick();
+
+                            if (bridge) {
+                                upstream->reconnect();
+                                bridge->tick();
+                            }
+
+                            transport.flush();
+                            exportCounters();
+                        }
+                    }
+                }
+
+                // queues are drained on every iteration, so a wake that raced with a drain is harmless
+                receiveRemotePublishes();
+                flushRelays();
+                flushUpstream();
+            }
+
+            exportCounters();
+        }
+};
+
+// totals of all shards, or the counters of a single one
+struct CounterSnapshot {
+    uint64_t receivedDatagrams = 0;
+    uint64_t receiveCalls = 0;
+    uint64_t sentDatagrams = 0;
+    uint64_t sendCalls = 0;
+    uint64_t droppedDatagrams = 0;
+    uint64_t malformedPackets = 0;
+    uint64_t publishedMessages = 0;
+    uint64_t deliveredMessages = 0;
+    uint64_t retransmittedMessages = 0;
+    uint64_t relayedMessages = 0;
+    uint64_t forwardedPublications = 0;
+    uint64_t receivedPublications = 0;
+    uint64_t queuedPublications = 0;
+    uint64_t endpoints = 0;
+    uint64_t sessions = 0;
+
+    void add(const ShardCounters& counters)
+    {
+        receivedDatagrams += counters.receivedDatagrams.load(std::memory_order_relaxed);
+        receiveCalls += counters.receiveCalls.load(std::memory_order_relaxed);
+        sentDatagrams += counters.sentDatagrams.load(std::memory_order_relaxed);
+        sendCalls += counters.sendCalls.load(std::memory_order_relaxed);
+        droppedDatagrams += counters.droppedDatagrams.load(std::memory_order_relaxed);
+        malformedPackets += counters.malformedPackets.load(std::memory_order_relaxed);
+        publishedMessages += counters.publishedMessages.load(std::memory_order_relaxed);
+        deliveredMessages += counters.deliveredMessages.load(std::memory_order_relaxed);
+        retransmittedMessages += counters.retransmittedMessages.load(std::memory_order_relaxed);
+        relayedMessages += counters.relayedMessages.load(std::memory_order_relaxed);
+        forwardedPublications += counters.forwardedPublications.load(std::memory_order_relaxed);
+        receivedPublications += counters.receivedPublications.load(std::memory_order_relaxed);
+        queuedPublications += counters.queuedPublications.load(std::memory_order_relaxed);
+        endpoints += counters.endpoints.load(std::memory_order_relaxed);
+        sessions += counters.sessions.load(std::memory_order_relaxed);
+    }
+
+    void add(const CounterSnapshot& snapshot)
+    {
+        receivedDatagrams += snapshot.receivedDatagrams;
+        receiveCalls += snapshot.receiveCalls;
+        sentDatagrams += snapshot.sentDatagrams;
+        sendCalls += snapshot.sendCalls;
+        droppedDatagrams += snapshot.droppedDatagrams;
+        malformedPackets += snapshot.malformedPackets;
+        publishedMessages += snapshot.publishedMessages;
+        deliveredMessages += snapshot.deliveredMessages;
+        retransmittedMessages += snapshot.retransmittedMessages;
+        relayedMessages += snapshot.relayedMessages;
+        forwardedPublications += snapshot.forwardedPublications;
+        receivedPublications += snapshot.receivedPublications;
+        queuedPublications += snapshot.queuedPublications;
+        endpoints += snapshot.endpoints;
+        sessions += snapshot.sessions;
+    }
+};
+
+// rates are taken over the interval since the previous snapshot
+void printStats(const std::string& label, const CounterSnapshot& current, const CounterSnapshot& previous, double interval,
+                size_t topics, bool bridged)
+{
+    uint64_t received = current.receivedDatagrams - previous.receivedDatagrams;
+    uint64_t sent = current.sentDatagrams - previous.sentDatagrams;
+    uint64_t receiveCalls = current.receiveCalls - previous.receiveCalls;
+    uint64_t sendCalls = current.sendCalls - previous.sendCalls;
+
+    std::cout << label << " rx " << current.receivedDatagrams << " (" << (uint64_t) (received / interval) << "/s, "
+              << (receiveCalls > 0 ? (double) received / receiveCalls : 0) << " per call), tx " << current.sentDatagrams << " ("
+              << (uint64_t) (sent / interval) << "/s, " << (sendCalls > 0 ? (double) sent / sendCalls : 0) << " per call), dropped "
+              << current.droppedDatagrams << ", malformed " << current.malformedPackets << ", published " << current.publishedMessages
+              << ", delivered " << current.deliveredMessages << ", retransmitted " << current.retransmittedMessages << ", relayed "
+              << current.relayedMessages << ", endpoints " << current.endpoints << ", sessions " << current.sessions << ", topics "
+              << topics;
+
+    if (bridged) {
+        std::cout << ", upstream forwarded " << current.forwardedPublications << ", received " << current.receivedPublications
+                  << ", queued " << current.queuedPublications;
+    }
+
+    std::cout << std::endl;
+}
+
+void printAllStats(const std::vector<std::unique_ptr<Shard>>& shards, std::vector<CounterSnapshot>& previous, double interval,
+                   size_t topics, bool bridged)
+{
+    CounterSnapshot total;
+    CounterSnapshot previousTotal;
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        CounterSnapshot current;
+        current.add(shards[i]->counters);
+
+        if (shards.size() > 1) {
+            printStats("shard " + std::to_string(i), current, previous[i], interval, topics, bridged);
+        }
+
+        total.add(current);
+        previousTotal.add(previous[i]);
+        previous[i] = current;
+    }
+
+    printStats(shards.size() > 1 ? "total" : "gateway", total, previousTotal, interval, topics, bridged);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <config file>" << std::endl;
+        return 1;
+    }
+
+    GatewayConfig config;
+    SteadyClock clock;
+    std::unique_ptr<SharedTopicRegistry> registry;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    try {
+        config = loadConfig(argv[1]);
+        registry.reset(new SharedTopicRegistry(config.broker.maximumTopics));
+
+        // predefined topics are in place before any reader starts
+        for (const auto& topic : config.predefinedTopics) {
+            registry->addPredefinedTopic(topic.first, topic.second);
+        }
+
+        for (int i = 0; i < config.threads; i++) {
+            shards.emplace_back(new Shard(i, config, shards, *registry, clock));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // SIGINT and SIGTERM end the loop through a signalfd; the shard threads inherit the blocked mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signalFd = signalfd(-1, &signals, SFD_NONBLOCK);
+
+    int statsFd = openTimer(config.statsInterval);
+
+    int epollFd = epoll_create1(0);
+    for (int fd : {signalFd, statsFd}) {
+        addToEpoll(epollFd, fd);
+    }
+
+    std::cout << "MQTT-SN gateway " << (int) config.broker.gatewayId << " listening on " << config.localAddress << ":" << config.localPort
+              << " with " << config.threads << (config.threads == 1 ? " thread" : " threads");
+
+    if (!config.upstreamAddress.empty()) {
+        std::cout << ", bridged to " << config.upstreamAddress << ":" << config.upstreamPort << " over " << config.bridge.connections
+                  << (config.bridge.connections == 1 ? " connection" : " connections") << " per thread";
+    }
+
+    std::cout << std::endl;
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+
+    for (auto& shard : shards) {
+        threads.emplace_back(&Shard::run, shard.get(), std::cref(running));
+    }
+
+    std::vector<CounterSnapshot> previous(shards.size());
+    double start = clock.now();
+    double last = start;
+    bool stopping = false;
+
+    while (!stopping) {
+        epoll_event events[2];
+        int ready = epoll_wait(epollFd, events, 2, -1);
+
+        for (int e = 0; e < ready; e++) {
+            int fd = events[e].data.fd;
+
+            if (fd == statsFd) {
+                uint64_t expirations;
+                ssize_t count = read(fd, &expirations, sizeof(expirations));
+                (void) count;
+
+                double now = clock.now();
+                printAllStats(shards, previous, now - last, registry->size(), !config.upstreamAddress.empty());
+                last = now;
+            }
+            else if (fd == signalFd) {
+                stopping = true;
+            }
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (size_t i = 0; i < shards.size(); i++) {
+        shards[i]->wake();
+        threads[i].join();
+    }
+
+    // the final line reports rates over the whole run
+    std::vector<CounterSnapshot> initial(shards.size());
+    printAllStats(shards, initial, clock.now() - start, registry->size(), !config.upstreamAddress.empty());
+
+    close(epollFd);
+    close(statsFd);
+    close(signalFd);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Prints a binary event journal written by EventJournal as one text line per event:
+// simulation time in seconds, module path, event name and the two event values.
+
+#include "logging/JournalFormat.h"
+#include "types/shared/LogEvent.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+const char* eventToString(uint16_t event)
+{
+    switch (event) {
+        case LogEvent::PACKET_RECEIVED:
+            return "packetReceived";
+        case LogEvent::CLIENT_STATE_CHANGED:
+            return "clientStateChanged";
+        case LogEvent::GATEWAY_STATE_CHANGED:
+            return "gatewayStateChanged";
+        case LogEvent::CLIENT_CONNECTED:
+            return "clientConnected";
+        case LogEvent::PING_RESPONSE_RECEIVED:
+            return "pingResponseReceived";
+        case LogEvent::PUBLISH_CREATED:
+            return "publishCreated";
+        case LogEvent::PUBLISH_DELIVERED:
+            return "publishDelivered";
+        case LogEvent::END_TO_END_DELAY:
+            return "endToEndDelay";
+        default:
+            return "unknown";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <journal file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    char magic[sizeof(JOURNAL_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not an event journal file" << std::endl;
+        return 1;
+    }
+
+    std::map<int32_t, std::string> modules;
+    std::vector<JournalRecord> records;
+
+    uint8_t blockType;
+    while (in.read(reinterpret_cast<char*>(&blockType), sizeof(blockType))) {
+        if (blockType == TraceBlockType::MODULE_BLOCK) {
+            int32_t moduleId;
+            uint16_t length;
+            in.read(reinterpret_cast<char*>(&moduleId), sizeof(moduleId));
+            in.read(reinterpret_cast<char*>(&length), sizeof(length));
+
+            std::string path(length, '\0');
+            in.read(&path[0], length);
+            modules[moduleId] = path;
+        }
+        else if (blockType == TraceBlockType::RECORD_BLOCK) {
+            uint32_t count;
+            in.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+            records.resize(count);
+            in.read(reinterpret_cast<char*>(records.data()), count * sizeof(JournalRecord));
+            if (!in) {
+                break;
+            }
+
+            // module blocks always precede the records of their module
+            for (const JournalRecord& record : records) {
+                auto module = modules.find(record.moduleId);
+                std::string modulePath = module != modules.end() ? module->second : std::to_string(record.moduleId);
+
+                printf("%" PRId64 ".%09" PRId64 " %s %s %" PRId64 " %" PRId64 "\n", record.timestamp / 1000000000,
+                       record.timestamp % 1000000000, modulePath.c_str(), eventToString(record.event), record.value1, record.value2);
+            }
+        }
+        else {
+            std::cerr << "Unknown block type " << (int) blockType << std::endl;
+            return 1;
+        }
+
+        if (!in) {
+            std::cerr << "Truncated event journal file" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,1094 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// MQTT-SN load generator and latency prober over UDP. It emulates many clients, each
+// with its own socket: publishers CONNECT, REGISTER their topic and PUBLISH at QoS -1, 0,
+// 1 or 2; subscribers CONNECT, SUBSCRIBE and acknowledge what they receive, including the
+// PUBREC/PUBREL/PUBCOMP exchange. Packets are built with the wire codec of the broker core.
+//
+// Every payload starts with the time its publication was due, so subscribers measure the
+// end-to-end delay and publishers the delay until PUBACK or PUBCOMP. With a fixed rate the
+// due time is the scheduled one, so a saturated gateway or a full in-flight window shows up
+// as latency instead of silently lowering the offered load. Only publications due inside
+// the measurement window, after the warm-up, are counted. Parameters are read from a
+// "name = value" config file; see loadgen.conf.
+
+#include "core/CorePacket.h"
+#include "core/WireCodec.h"
+#include "metrics/LatencyHistogram.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+struct LoadConfig {
+    std::string destAddress = "127.0.0.1";
+    int destPort = 1883;
+    std::string localAddress = "127.0.0.1";
+
+    int publishers = 100;
+    int subscribers = 10;
+    int topics = 10;
+    int topicsPerSubscriber = 1;
+    uint16_t predefinedTopicId = 0;
+
+    int qos = 0;
+    int subscriptionQoS = 0;
+    std::string arrivalProcess = "periodic";
+    double publishRate = 10;
+    int payloadSize = 32;
+    int maxInflight = 1;
+
+    uint16_t keepAlive = 60;
+    double retransmissionInterval = 1;
+    int retransmissionCounter = 3;
+    double setupTimeout = 30;
+
+    double warmup = 2;
+    double duration = 10;
+    double drainTime = 2;
+    double statsInterval = 1;
+
+    int threads = 1;
+    uint64_t seed = 1;
+};
+
+std::string trim(const std::string& value)
+{
+    size_t begin = value.find_first_not_of(" \t\r\"");
+    size_t end = value.find_last_not_of(" \t\r\"");
+
+    return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+}
+
+// durations accept the NED units s and ms
+double parseSeconds(const std::string& value)
+{
+    size_t consumed = 0;
+    double number = std::stod(value, &consumed);
+    std::string unit = trim(value.substr(consumed));
+
+    if (unit.empty() || unit == "s") {
+        return number;
+    }
+
+    if (unit == "ms") {
+        return number / 1000;
+    }
+
+    throw std::invalid_argument("unknown time unit " + unit);
+}
+
+LoadConfig loadConfig(const std::string& fileName)
+{
+    LoadConfig config;
+
+    std::ifstream file(fileName);
+    if (!file) {
+        throw std::runtime_error("cannot open config file " + fileName);
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        line = line.substr(0, line.find('#'));
+        size_t separator = line.find('=');
+
+        if (trim(line).empty()) {
+            continue;
+        }
+
+        if (separator == std::string::npos) {
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": expected name = value");
+        }
+
+        std::string name = trim(line.substr(0, separator));
+        std::string value = trim(line.substr(separator + 1));
+
+        if (name == "destAddress") {
+            config.destAddress = value;
+        }
+        else if (name == "destPort") {
+            config.destPort = std::stoi(value);
+        }
+        else if (name == "localAddress") {
+            config.localAddress = value;
+        }
+        else if (name == "publishers") {
+            config.publishers = std::max(0, std::stoi(value));
+        }
+        else if (name == "subscribers") {
+            config.subscribers = std::max(0, std::stoi(value));
+        }
+        else if (name == "topics") {
+            config.topics = std::max(1, std::stoi(value));
+        }
+        else if (name == "topicsPerSubscriber") {
+            config.topicsPerSubscriber = std::max(1, std::stoi(value));
+        }
+        else if (name == "predefinedTopicId") {
+            config.predefinedTopicId = (uint16_t) std::stoi(value);
+        }
+        else if (name == "qos") {
+            config.qos = std::stoi(value);
+        }
+        else if (name == "subscriptionQoS") {
+            config.subscriptionQoS = std::stoi(value);
+        }
+        else if (name == "arrivalProcess") {
+            config.arrivalProcess = value;
+        }
+        else if (name == "publishRate") {
+            config.publishRate = std::stod(value);
+        }
+        else if (name == "payloadSize") {
+            config.payloadSize = std::stoi(value);
+        }
+        else if (name == "maxInflight") {
+            config.maxInflight = std::max(1, std::stoi(value));
+        }
+        else if (name == "keepAlive") {
+            config.keepAlive = (uint16_t) parseSeconds(value);
+        }
+        else if (name == "retransmissionInterval") {
+            config.retransmissionInterval = parseSeconds(value);
+        }
+        else if (name == "retransmissionCounter") {
+            config.retransmissionCounter = std::stoi(value);
+        }
+        else if (name == "setupTimeout") {
+            config.setupTimeout = parseSeconds(value);
+        }
+        else if (name == "warmup") {
+            config.warmup = parseSeconds(value);
+        }
+        else if (name == "duration") {
+            config.duration = parseSeconds(value);
+        }
+        else if (name == "drainTime") {
+            config.drainTime = parseSeconds(value);
+        }
+        else if (name == "statsInterval") {
+            config.statsInterval = parseSeconds(value);
+        }
+        else if (name == "threads") {
+            config.threads = std::max(1, std::stoi(value));
+        }
+        else if (name == "seed") {
+            config.seed = std::stoull(value);
+        }
+        else {
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": unknown parameter " + name);
+        }
+    }
+
+    if (config.qos < -1 || config.qos > 2 || config.subscriptionQoS < 0 || config.subscriptionQoS > 2) {
+        throw std::runtime_error("qos must be -1, 0, 1 or 2 and subscriptionQoS 0, 1 or 2");
+    }
+
+    if (config.qos == -1 && config.predefinedTopicId == 0) {
+        throw std::runtime_error("qos -1 needs a predefinedTopicId, since such publishers never register");
+    }
+
+    if (config.arrivalProcess != "periodic" && config.arrivalProcess != "poisson") {
+        throw std::runtime_error("arrivalProcess must be periodic or poisson");
+    }
+
+    // the payload carries the due time of the publication
+    config.payloadSize = std::max(config.payloadSize, (int) sizeof(uint64_t));
+
+    return config;
+}
+
+QoS toQoS(int qos)
+{
+    switch (qos) {
+        case -1:
+            return QoS::QOS_MINUS_ONE;
+        case 1:
+            return QoS::QOS_ONE;
+        case 2:
+            return QoS::QOS_TWO;
+        default:
+            return QoS::QOS_ZERO;
+    }
+}
+
+enum Phase {
+    SETUP,
+    PUBLISHING,
+    DRAINING,
+    DONE
+};
+
+// state shared by the workers and the reporter
+struct Run {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::atomic<int> phase{SETUP};
+    std::atomic<int> readyClients{0};
+    std::atomic<bool> setupFailed{false};
+
+    // measurement window, set when publishing starts
+    std::atomic<double> measureStart{0};
+    std::atomic<double> measureEnd{0};
+
+    double now() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+// counters read by the reporter while the workers run
+struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> sentPublishes{0};
+    std::atomic<uint64_t> completedPublishes{0};
+    std::atomic<uint64_t> deliveries{0};
+    std::atomic<uint64_t> retransmissions{0};
+    std::atomic<uint64_t> failedPublishes{0};
+    std::atomic<uint64_t> rejections{0};
+    std::atomic<uint64_t> sendErrors{0};
+
+    // inside the measurement window only
+    std::atomic<uint64_t> measuredPublishes{0};
+    std::atomic<uint64_t> measuredCompletions{0};
+    std::atomic<uint64_t> measuredDeliveries{0};
+};
+
+class Worker
+{
+    protected:
+        enum ClientState {
+            CONNECTING,
+            REGISTERING,
+            SUBSCRIBING,
+            READY
+        };
+
+        // QoS 1/2 publication waiting for PUBACK, PUBREC or PUBCOMP
+        struct Inflight {
+            double dueTime;
+            double sentTime;
+            int retransmissions = 0;
+            bool released = false;
+            std::vector<uint8_t> datagram;
+        };
+
+        struct Client {
+            int socket = -1;
+            bool publisher = false;
+            ClientState state = CONNECTING;
+            std::string clientId;
+
+            // publishers use one topic, subscribers topicsPerSubscriber
+            std::vector<std::string> topicNames;
+            uint16_t topicId = 0;
+            size_t setupIndex = 0;
+            uint16_t setupMsgId = 0;
+            double setupSentTime = 0;
+            int setupAttempts = 0;
+
+            double lastSent = 0;
+            uint16_t nextMsgId = 0;
+            std::unordered_map<uint16_t, Inflight> inflight;
+
+            // due time of the next publication; a client with a full window waits off the schedule
+            double nextDueTime = 0;
+            bool blocked = false;
+        };
+
+        typedef std::pair<double, uint32_t> ScheduleEntry;
+
+        size_t index;
+        const LoadConfig& config;
+        Run& run;
+        QoS qos;
+
+        std::vector<Client> clients;
+        int epollFd = -1;
+
+        std::priority_queue<ScheduleEntry, std::vector<ScheduleEntry>, std::greater<ScheduleEntry>> schedule;
+        std::mt19937_64 random;
+        std::vector<uint8_t> encodeBuffer;
+        std::vector<uint8_t> receiveBuffer;
+
+    protected:
+        uint16_t nextMsgId(Client& client)
+        {
+            // message ID 0 is reserved
+            client.nextMsgId = client.nextMsgId == UINT16_MAX ? 1 : client.nextMsgId + 1;
+            return client.nextMsgId;
+        }
+
+        void send(Client& client, const uint8_t* data, size_t length, double now)
+        {
+            if (::send(client.socket, data, length, MSG_DONTWAIT) < 0) {
+                counters.sendErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            client.lastSent = now;
+        }
+
+        void send(Client& client, const CorePacket& packet, double now)
+        {
+            WireCodec::encode(packet, encodeBuffer);
+            send(client, encodeBuffer.data(), encodeBuffer.size(), now);
+        }
+
+        void sendAck(Client& client, MsgType msgType, uint16_t topicId, uint16_t msgId, double now)
+        {
+            CorePacket ack;
+            ack.msgType = msgType;
+            ack.topicId = topicId;
+            ack.msgId = msgId;
+            send(client, ack, now);
+        }
+
+        double nextInterval()
+        {
+            if (config.publishRate <= 0) {
+                return 0;
+            }
+
+            if (config.arrivalProcess == "poisson") {
+                return std::exponential_distribution<double>(config.publishRate)(random);
+            }
+
+            return 1 / config.publishRate;
+        }
+
+        // sends the packet of the current setup step again after a loss
+        void sendSetup(Client& client, double now)
+        {
+            CorePacket packet;
+
+            switch (client.state) {
+                case CONNECTING:
+                    packet.msgType = MsgType::CONNECT;
+                    packet.flags = 1 << Flag::CLEAN_SESSION;
+                    packet.duration = config.keepAlive;
+                    packet.text = client.clientId;
+                    break;
+
+                case REGISTERING:
+                    packet.msgType = MsgType::REGISTER;
+                    packet.msgId = client.setupMsgId;
+                    packet.text = client.topicNames[0];
+                    break;
+
+                case SUBSCRIBING:
+                    packet.msgType = MsgType::SUBSCRIBE;
+                    packet.msgId = client.setupMsgId;
+
+                    if (config.predefinedTopicId > 0) {
+                        packet.setFlags(toQoS(config.subscriptionQoS), TopicIdType::PRE_DEFINED_TOPIC_ID);
+                        packet.topicId = config.predefinedTopicId;
+                    }
+                    else {
+                        packet.setFlags(toQoS(config.subscriptionQoS), TopicIdType::NORMAL_TOPIC_ID);
+                        packet.text = client.topicNames[client.setupIndex];
+                    }
+                    break;
+
+                default:
+                    return;
+            }
+
+            client.setupSentTime = now;
+            client.setupAttempts++;
+            send(client, packet, now);
+        }
+
+        void advanceSetup(Client& client, double now)
+        {
+            if (client.state == CONNECTING) {
+                if (client.publisher) {
+                    client.state = config.predefinedTopicId > 0 ? READY : REGISTERING;
+                }
+                else {
+                    client.state = SUBSCRIBING;
+                }
+            }
+            else if (client.state == SUBSCRIBING && ++client.setupIndex < client.topicNames.size()) {
+                client.state = SUBSCRIBING;
+            }
+            else {
+                client.state = READY;
+            }
+
+            if (client.state == READY) {
+                run.readyClients.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            client.setupMsgId = nextMsgId(client);
+            client.setupAttempts = 0;
+            sendSetup(client, now);
+        }
+
+        bool isMeasured(double dueTime) const
+        {
+            return dueTime >= run.measureStart.load(std::memory_order_relaxed) && dueTime < run.measureEnd.load(std::memory_order_relaxed);
+        }
+
+        void completePublish(Client& client, uint16_t msgId, double now)
+        {
+            auto it = client.inflight.find(msgId);
+            if (it == client.inflight.end()) {
+                return;
+            }
+
+            counters.completedPublishes.fetch_add(1, std::memory_order_relaxed);
+
+            if (isMeasured(it->second.dueTime)) {
+                ackLatency.record(now - it->second.dueTime);
+                counters.measuredCompletions.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            client.inflight.erase(it);
+            unblock(client, now);
+        }
+
+        void unblock(Client& client, double now)
+        {
+            if (!client.blocked) {
+                return;
+            }
+
+            // a closed loop publisher sends as soon as the window opens
+            client.blocked = false;
+            if (config.publishRate <= 0) {
+                client.nextDueTime = now;
+            }
+
+            schedule.emplace(client.nextDueTime, &client - clients.data());
+        }
+
+        void publish(Client& client, double now)
+        {
+            // without a rate the publication is due when the window lets it out
+            double dueTime = config.publishRate > 0 ? client.nextDueTime : now;
+
+            CorePacket packet;
+            packet.msgType = MsgType::PUBLISH;
+
+            if (config.predefinedTopicId > 0) {
+                packet.setFlags(qos, TopicIdType::PRE_DEFINED_TOPIC_ID);
+                packet.topicId = config.predefinedTopicId;
+            }
+            else {
+                packet.setFlags(qos, TopicIdType::NORMAL_TOPIC_ID);
+                packet.topicId = client.topicId;
+            }
+
+            if (qos == QoS::QOS_ONE || qos == QoS::QOS_TWO) {
+                packet.msgId = nextMsgId(client);
+            }
+
+            uint64_t dueNanoseconds = (uint64_t) (dueTime * 1e9);
+            packet.data.assign(config.payloadSize, 'x');
+            std::memcpy(&packet.data[0], &dueNanoseconds, sizeof(dueNanoseconds));
+
+            WireCodec::encode(packet, encodeBuffer);
+            send(client, encodeBuffer.data(), encodeBuffer.size(), now);
+
+            counters.sentPublishes.fetch_add(1, std::memory_order_relaxed);
+            bool measured = isMeasured(dueTime);
+            if (measured) {
+                counters.measuredPublishes.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (packet.msgId > 0) {
+                Inflight& inflight = client.inflight[packet.msgId];
+                inflight.dueTime = dueTime;
+                inflight.sentTime = now;
+                inflight.datagram = encodeBuffer;
+            }
+            else if (measured) {
+                // fire and forget publications complete when sent
+                counters.measuredCompletions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void sendDuePublishes(double now)
+        {
+            double publishEnd = run.measureEnd.load(std::memory_order_relaxed);
+
+            // entries rescheduled in this pass wait for the next one, so the receive path is never starved
+            for (size_t budget = schedule.size(); budget > 0 && !schedule.empty() && schedule.top().first <= now; budget--) {
+                Client& client = clients[schedule.top().second];
+                schedule.pop();
+
+                if (client.nextDueTime >= publishEnd) {
+                    continue;
+                }
+
+                if ((int) client.inflight.size() >= config.maxInflight) {
+                    client.blocked = true;
+                    continue;
+                }
+
+                publish(client, now);
+
+                client.nextDueTime = config.publishRate > 0 ? client.nextDueTime + nextInterval() : now;
+
+                if ((int) client.inflight.size() >= config.maxInflight) {
+                    client.blocked = true;
+                }
+                else {
+                    schedule.emplace(client.nextDueTime, &client - clients.data());
+                }
+            }
+        }
+
+        void handlePublish(Client& client, const CorePacket& packet, double now)
+        {
+            QoS deliveredQoS = packet.getQoS();
+
+            if (deliveredQoS == QoS::QOS_ONE) {
+                sendAck(client, MsgType::PUBACK, packet.topicId, packet.msgId, now);
+            }
+            else if (deliveredQoS == QoS::QOS_TWO) {
+                CorePacket pubRec;
+                pubRec.msgType = MsgType::PUBREC;
+                pubRec.msgId = packet.msgId;
+                send(client, pubRec, now);
+            }
+
+            // retained messages sent on subscription and duplicates are not deliveries of this run
+            if (packet.getRetain() || packet.getDup() || packet.data.size() < sizeof(uint64_t)) {
+                return;
+            }
+
+            uint64_t dueNanoseconds;
+            std::memcpy(&dueNanoseconds, packet.data.data(), sizeof(dueNanoseconds));
+            double dueTime = dueNanoseconds / 1e9;
+
+            counters.deliveries.fetch_add(1, std::memory_order_relaxed);
+
+            if (isMeasured(dueTime)) {
+                deliveryLatency.record(now - dueTime);
+                counters.measuredDeliveries.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void handlePacket(Client& client, const CorePacket& packet, double now)
+        {
+            switch (packet.msgType) {
+                case MsgType::CONNACK:
+                    if (client.state == CONNECTING) {
+                        if (packet.returnCode != ReturnCode::ACCEPTED) {
+                            counters.rejections.fetch_add(1, std::memory_order_relaxed);
+                            return;
+                        }
+                        advanceSetup(client, now);
+                    }
+                    break;
+
+                case MsgType::REGACK:
+                    if (client.state == REGISTERING && packet.msgId == client.setupMsgId) {
+                        if (packet.returnCode != ReturnCode::ACCEPTED) {
+                            counters.rejections.fetch_add(1, std::memory_order_relaxed);
+                            return;
+                        }
+                        client.topicId = packet.topicId;
+                        advanceSetup(client, now);
+                    }
+                    break;
+
+                case MsgType::SUBACK:
+                    if (client.state == SUBSCRIBING && packet.msgId == client.setupMsgId) {
+                        if (packet.returnCode != ReturnCode::ACCEPTED) {
+                            counters.rejections.fetch_add(1, std::memory_order_relaxed);
+                            return;
+                        }
+                        advanceSetup(client, now);
+                    }
+                    break;
+
+                case MsgType::PUBACK:
+                    if (packet.returnCode != ReturnCode::ACCEPTED) {
+                        counters.rejections.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    completePublish(client, packet.msgId, now);
+                    break;
+
+                case MsgType::PUBREC: {
+                    auto it = client.inflight.find(packet.msgId);
+                    if (it != client.inflight.end()) {
+                        // from now on the PUBREL is what gets retransmitted
+                        CorePacket pubRel;
+                        pubRel.msgType = MsgType::PUBREL;
+                        pubRel.msgId = packet.msgId;
+                        WireCodec::encode(pubRel, it->second.datagram);
+
+                        it->second.released = true;
+                        it->second.sentTime = now;
+                        it->second.retransmissions = 0;
+                        send(client, it->second.datagram.data(), it->second.datagram.size(), now);
+                    }
+                    break;
+                }
+
+                case MsgType::PUBCOMP:
+                    completePublish(client, packet.msgId, now);
+                    break;
+
+                case MsgType::PUBLISH:
+                    handlePublish(client, packet, now);
+                    break;
+
+                case MsgType::PUBREL:
+                    sendAck(client, MsgType::PUBCOMP, 0, packet.msgId, now);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        void receive(Client& client, double now)
+        {
+            CorePacket packet;
+
+            while (true) {
+                ssize_t length = recv(client.socket, receiveBuffer.data(), receiveBuffer.size(), MSG_DONTWAIT);
+                if (length <= 0) {
+                    break;
+                }
+
+                if (WireCodec::decode(receiveBuffer.data(), length, packet)) {
+                    handlePacket(client, packet, now);
+                }
+            }
+        }
+
+        // setup retries, publication retransmissions and keep alive pings
+        void checkTimers(double now)
+        {
+            for (Client& client : clients) {
+                if (client.state != READY) {
+                    if (now - client.setupSentTime >= config.retransmissionInterval) {
+                        sendSetup(client, now);
+                    }
+                    continue;
+                }
+
+                for (auto it = client.inflight.begin(); it != client.inflight.end();) {
+                    Inflight& inflight = it->second;
+
+                    if (now - inflight.sentTime < config.retransmissionInterval) {
+                        ++it;
+                        continue;
+                    }
+
+                    if (inflight.retransmissions >= config.retransmissionCounter) {
+                        counters.failedPublishes.fetch_add(1, std::memory_order_relaxed);
+                        it = client.inflight.erase(it);
+                        continue;
+                    }
+
+                    // a PUBLISH is retransmitted with the DUP flag, which sits in the flags octet after length and type
+                    if (!inflight.released) {
+                        inflight.datagram[inflight.datagram[0] == 0x01 ? 4 : 2] |= 1 << Flag::DUP;
+                    }
+
+                    inflight.sentTime = now;
+                    inflight.retransmissions++;
+                    counters.retransmissions.fetch_add(1, std::memory_order_relaxed);
+
+                    send(client, inflight.datagram.data(), inflight.datagram.size(), now);
+                    ++it;
+                }
+
+                if ((int) client.inflight.size() < config.maxInflight) {
+                    unblock(client, now);
+                }
+
+                // QoS -1 publishers hold no session
+                bool connected = !(client.publisher && qos == QoS::QOS_MINUS_ONE);
+                if (connected && config.keepAlive > 0 && now - client.lastSent >= config.keepAlive / 2.0) {
+                    CorePacket pingReq;
+                    pingReq.msgType = MsgType::PINGREQ;
+                    send(client, pingReq, now);
+                }
+            }
+        }
+
+        int openSocket()
+        {
+            bool ipv6 = config.destAddress.find(':') != std::string::npos;
+            int fd = socket(ipv6 ? AF_INET6 : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+            }
+
+            sockaddr_storage local{};
+            sockaddr_storage remote{};
+            socklen_t length;
+
+            if (ipv6) {
+                sockaddr_in6& localIn6 = reinterpret_cast<sockaddr_in6&>(local);
+                sockaddr_in6& remoteIn6 = reinterpret_cast<sockaddr_in6&>(remote);
+                localIn6.sin6_family = remoteIn6.sin6_family = AF_INET6;
+                remoteIn6.sin6_port = htons(config.destPort);
+                length = sizeof(sockaddr_in6);
+
+                if (inet_pton(AF_INET6, config.localAddress.c_str(), &localIn6.sin6_addr) != 1 ||
+                    inet_pton(AF_INET6, config.destAddress.c_str(), &remoteIn6.sin6_addr) != 1) {
+                    throw std::runtime_error("invalid localAddress or destAddress");
+                }
+            }
+            else {
+                sockaddr_in& localIn = reinterpret_cast<sockaddr_in&>(local);
+                sockaddr_in& remoteIn = reinterpret_cast<sockaddr_in&>(remote);
+                localIn.sin_family = remoteIn.sin_family = AF_INET;
+                remoteIn.sin_port = htons(config.destPort);
+                length = sizeof(sockaddr_in);
+
+                if (inet_pton(AF_INET, config.localAddress.c_str(), &localIn.sin_addr) != 1 ||
+                    inet_pton(AF_INET, config.destAddress.c_str(), &remoteIn.sin_addr) != 1) {
+                    throw std::runtime_error("invalid localAddress or destAddress");
+                }
+            }
+
+            // each client gets its own ephemeral port, which is what the gateway tells clients apart by
+            if (bind(fd, reinterpret_cast<sockaddr*>(&local), length) != 0 || connect(fd, reinterpret_cast<sockaddr*>(&remote), length) != 0) {
+                int error = errno;
+                close(fd);
+                throw std::runtime_error(std::string("bind or connect: ") + std::strerror(error));
+            }
+
+            return fd;
+        }
+
+    public:
+        WorkerCounters counters;
+        LatencyHistogram deliveryLatency;
+        LatencyHistogram ackLatency;
+
+        Worker(size_t index, const LoadConfig& config, Run& run) :
+                index(index), config(config), run(run), qos(toQoS(config.qos)), random(config.seed + index), receiveBuffer(65536)
+        {
+            epollFd = epoll_create1(0);
+
+            // clients are dealt round robin, publishers first
+            int total = config.publishers + config.subscribers;
+            for (int i = index; i < total; i += config.threads) {
+                Client client;
+                client.publisher = i < config.publishers;
+                client.clientId = (client.publisher ? "pub" : "sub") + std::to_string(client.publisher ? i : i - config.publishers);
+
+                if (client.publisher) {
+                    client.topicNames.push_back("loadgen/" + std::to_string(i % config.topics));
+                }
+                else {
+                    int subscriber = i - config.publishers;
+                    int count = config.predefinedTopicId > 0 ? 1 : std::min(config.topicsPerSubscriber, config.topics);
+
+                    for (int k = 0; k < count; k++) {
+                        client.topicNames.push_back("loadgen/" + std::to_string((subscriber + k) % config.topics));
+                    }
+                }
+
+                clients.push_back(std::move(client));
+            }
+
+            for (size_t i = 0; i < clients.size(); i++) {
+                clients[i].socket = openSocket();
+
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.u32 = i;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].socket, &event);
+            }
+        }
+
+        ~Worker()
+        {
+            for (Client& client : clients) {
+                close(client.socket);
+            }
+
+            close(epollFd);
+        }
+
+        void operator()()
+        {
+            double now = run.now();
+
+            for (Client& client : clients) {
+                if (client.publisher && qos == QoS::QOS_MINUS_ONE) {
+                    client.state = READY;
+                    run.readyClients.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    sendSetup(client, now);
+                }
+            }
+
+            const int timerPeriodMs = 10;
+            double nextTimerCheck = now;
+            bool scheduled = false;
+            std::vector<epoll_event> events(256);
+
+            while (run.phase.load(std::memory_order_acquire) != DONE) {
+                now = run.now();
+                int phase = run.phase.load(std::memory_order_acquire);
+
+                if (phase == PUBLISHING && !scheduled) {
+                    // first publications are spread over one interval so the publishers do not move in lockstep
+                    double start = run.measureStart.load(std::memory_order_relaxed) - config.warmup;
+                    std::uniform_real_distribution<double> offset(0, config.publishRate > 0 ? 1 / config.publishRate : 0);
+
+                    for (size_t i = 0; i < clients.size(); i++) {
+                        if (clients[i].publisher) {
+                            clients[i].nextDueTime = start + offset(random);
+                            schedule.emplace(clients[i].nextDueTime, i);
+                        }
+                    }
+
+                    scheduled = true;
+                }
+
+                if (phase == PUBLISHING) {
+                    sendDuePublishes(now);
+                }
+
+                if (now >= nextTimerCheck) {
+                    checkTimers(now);
+                    nextTimerCheck = now + timerPeriodMs / 1000.0;
+                }
+
+                int timeout = timerPeriodMs;
+                if (phase == PUBLISHING && !schedule.empty()) {
+                    double wait = schedule.top().first - run.now();
+                    timeout = wait <= 0 ? 0 : std::min(timerPeriodMs, (int) (wait * 1000));
+                }
+
+                int ready = epoll_wait(epollFd, events.data(), events.size(), timeout);
+                now = run.now();
+
+                for (int e = 0; e < ready; e++) {
+                    receive(clients[events[e].data.u32], now);
+                }
+            }
+
+            now = run.now();
+            for (Client& client : clients) {
+                if (!(client.publisher && qos == QoS::QOS_MINUS_ONE)) {
+                    CorePacket disconnect;
+                    disconnect.msgType = MsgType::DISCONNECT;
+                    send(client, disconnect, now);
+                }
+            }
+        }
+};
+
+struct Totals {
+    uint64_t sentPublishes = 0;
+    uint64_t completedPublishes = 0;
+    uint64_t deliveries = 0;
+    uint64_t retransmissions = 0;
+    uint64_t failedPublishes = 0;
+    uint64_t rejections = 0;
+    uint64_t sendErrors = 0;
+    uint64_t measuredPublishes = 0;
+    uint64_t measuredCompletions = 0;
+    uint64_t measuredDeliveries = 0;
+
+    void add(const WorkerCounters& counters)
+    {
+        sentPublishes += counters.sentPublishes.load(std::memory_order_relaxed);
+        completedPublishes += counters.completedPublishes.load(std::memory_order_relaxed);
+        deliveries += counters.deliveries.load(std::memory_order_relaxed);
+        retransmissions += counters.retransmissions.load(std::memory_order_relaxed);
+        failedPublishes += counters.failedPublishes.load(std::memory_order_relaxed);
+        rejections += counters.rejections.load(std::memory_order_relaxed);
+        sendErrors += counters.sendErrors.load(std::memory_order_relaxed);
+        measuredPublishes += counters.measuredPublishes.load(std::memory_order_relaxed);
+        measuredCompletions += counters.measuredCompletions.load(std::memory_order_relaxed);
+        measuredDeliveries += counters.measuredDeliveries.load(std::memory_order_relaxed);
+    }
+};
+
+Totals sumCounters(const std::vector<std::unique_ptr<Worker>>& workers)
+{
+    Totals totals;
+    for (const auto& worker : workers) {
+        totals.add(worker->counters);
+    }
+
+    return totals;
+}
+
+void printLatency(const std::string& label, const LatencyHistogram& histogram)
+{
+    if (histogram.isEmpty()) {
+        std::cout << label << ": no samples" << std::endl;
+        return;
+    }
+
+    std::cout << label << " (ms): samples " << histogram.getCount() << ", mean " << histogram.getMean() * 1e3 << ", p50 "
+              << histogram.getPercentile(50) * 1e3 << ", p90 " << histogram.getPercentile(90) * 1e3 << ", p99 "
+              << histogram.getPercentile(99) * 1e3 << ", p99.9 " << histogram.getPercentile(99.9) * 1e3 << ", max "
+              << histogram.getMax() * 1e3 << std::endl;
+}
+
+// raises the open file limit to the hard limit; every emulated client holds a socket
+void raiseFileLimit(int needed)
+{
+    rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+
+    if (limit.rlim_cur != RLIM_INFINITY && (rlim_t) needed > limit.rlim_cur) {
+        throw std::runtime_error("the open file limit of " + std::to_string(limit.rlim_cur) + " is below the " +
+                                 std::to_string(needed) + " sockets needed");
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <config file>" << std::endl;
+        return 1;
+    }
+
+    LoadConfig config;
+    Run run;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    try {
+        config = loadConfig(argv[1]);
+        raiseFileLimit(config.publishers + config.subscribers + config.threads + 16);
+
+        for (int i = 0; i < config.threads; i++) {
+            workers.emplace_back(new Worker(i, config, run));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int clientCount = config.publishers + config.subscribers;
+    std::cout << std::fixed << std::setprecision(3) << "emulating " << config.publishers << " publishers and " << config.subscribers
+              << " subscribers against " << config.destAddress << ":" << config.destPort << " with " << config.threads
+              << (config.threads == 1 ? " thread" : " threads") << std::endl;
+
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back(std::ref(*worker));
+    }
+
+    // every client connects, registers and subscribes before the first publication
+    double setupStart = run.now();
+    while (run.readyClients.load(std::memory_order_relaxed) < clientCount && run.now() - setupStart < config.setupTimeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int readyClients = run.readyClients.load(std::memory_order_relaxed);
+    if (readyClients < clientCount) {
+        std::cerr << "only " << readyClients << " of " << clientCount << " clients completed the setup within " << config.setupTimeout
+                  << " s" << std::endl;
+
+        run.phase.store(DONE, std::memory_order_release);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        return 1;
+    }
+
+    std::cout << "setup of " << clientCount << " clients took " << run.now() - setupStart << " s" << std::endl;
+
+    double publishStart = run.now();
+    run.measureStart.store(publishStart + config.warmup, std::memory_order_relaxed);
+    run.measureEnd.store(publishStart + config.warmup + config.duration, std::memory_order_relaxed);
+    run.phase.store(PUBLISHING, std::memory_order_release);
+
+    Totals previous;
+    double last = publishStart;
+    double end = publishStart + config.warmup + config.duration + config.drainTime;
+
+    while (run.now() < end) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(config.statsInterval, std::max(0.0, end - run.now()))));
+
+        if (run.now() >= run.measureEnd.load(std::memory_order_relaxed)) {
+            run.phase.store(DRAINING, std::memory_order_release);
+        }
+
+        double now = run.now();
+        Totals current = sumCounters(workers);
+        double interval = now - last;
+
+        std::cout << "t " << now - publishStart << " s: published " << (current.sentPublishes - previous.sentPublishes) / interval
+                  << "/s, completed " << (current.completedPublishes - previous.completedPublishes) / interval << "/s, delivered "
+                  << (current.deliveries - previous.deliveries) / interval << "/s, retransmitted " << current.retransmissions
+                  << ", failed " << current.failedPublishes << std::endl;
+
+        previous = current;
+        last = now;
+    }
+
+    run.phase.store(DONE, std::memory_order_release);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Totals totals = sumCounters(workers);
+    LatencyHistogram deliveryLatency;
+    LatencyHistogram ackLatency;
+
+    for (const auto& worker : workers) {
+        deliveryLatency.merge(worker->deliveryLatency);
+        ackLatency.merge(worker->ackLatency);
+    }
+
+    std::cout << "measured over " << config.duration << " s: offered " << totals.measuredPublishes / config.duration
+              << " publications/s, completed " << totals.measuredCompletions / config.duration << "/s, delivered "
+              << totals.measuredDeliveries / config.duration << "/s; retransmitted " << totals.retransmissions << ", failed "
+              << totals.failedPublishes << ", rejected " << totals.rejections << ", send errors " << totals.sendErrors << std::endl;
+
+    printLatency("end-to-end delay", deliveryLatency);
+    if (config.qos == 1 || config.qos == 2) {
+        printLatency(config.qos == 1 ? "PUBACK delay" : "PUBCOMP delay", ackLatency);
+    }
+
+    return 0;
+}
@@ -0,0 +1,513 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Runs the simulation configurations of omnetpp.ini in parallel, one Cmdenv process per
+// run, and merges the per-run results into one dataset indexed by run.
+//
+// The runs of every configuration are expanded by the simulation itself (-q runs), then
+// crossed with the parameter values given with -s. Each run writes into its own directory
+// under <output>/runs, passed as the result directory: the per-run output files of
+// omnetpp.ini (traces, journals, write-ahead logs) are placed under ${resultdir}, and the
+// csv results files are overridden. The replications file of a series stays shared. A run whose directory holds a done marker for the same
+// command line is skipped, so an interrupted sweep resumes where it stopped. The runs are
+// spread over per-worker queues and idle workers steal from the back of the others.
+//
+// Scalar recording is switched on for every run so that scalars.csv holds the scalars the
+// modules record in finish(); the statistics of the @statistic properties stay off.
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Variable {
+    std::string name;
+    std::vector<std::string> values;
+};
+
+struct Job {
+    std::string id;
+    std::string config;
+    int runNumber;
+    std::string iterationVariables;
+    std::vector<std::string> values;
+    fs::path directory;
+    std::vector<std::string> command;
+    bool succeeded = false;
+};
+
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+};
+
+std::mutex outputMutex;
+
+std::string quoteCsv(const std::string& field)
+{
+    if (field.find_first_of(",\"\n") == std::string::npos) {
+        return field;
+    }
+
+    std::string quoted = "\"";
+    for (char c : field) {
+        quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+    }
+
+    return quoted + "\"";
+}
+
+std::string joinCommand(const std::vector<std::string>& command)
+{
+    std::string line;
+    for (const std::string& argument : command) {
+        line += (line.empty() ? "" : " ") + argument;
+    }
+
+    return line;
+}
+
+std::vector<std::string> splitValues(const std::string& values)
+{
+    std::vector<std::string> result;
+    std::stringstream stream(values);
+    std::string value;
+
+    while (std::getline(stream, value, ',')) {
+        if (!value.empty()) {
+            result.push_back(value);
+        }
+    }
+
+    return result;
+}
+
+// asks the simulation for the runs of a configuration and their iteration variables
+bool queryRuns(const std::vector<std::string>& launcher, const std::string& config, std::vector<std::pair<int, std::string>>& runs)
+{
+    std::string command = joinCommand(launcher) + " -s -u Cmdenv -c " + config + " -q runs 2>&1";
+
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        std::cerr << "Failed to run " << command << std::endl;
+        return false;
+    }
+
+    std::string output;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        output += buffer;
+    }
+
+    int status = pclose(pipe);
+
+    // lines look like "Run 3: $packetBER=1e-05, $repetition=0"
+    std::stringstream stream(output);
+    std::string line;
+    while (std::getline(stream, line)) {
+        int runNumber;
+        int consumed = 0;
+
+        if (std::sscanf(line.c_str(), " Run %d:%n", &runNumber, &consumed) == 1 && consumed > 0) {
+            std::string variables = line.substr(consumed);
+            variables.erase(0, variables.find_first_not_of(' '));
+            runs.emplace_back(runNumber, variables);
+        }
+    }
+
+    if (status != 0 || runs.empty()) {
+        std::cerr << "Failed to expand the runs of " << config << ":" << std::endl << output;
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<Job> expandJobs(const std::vector<std::string>& launcher, const std::vector<std::string>& configs,
+                            const std::vector<Variable>& variables, const fs::path& outputDirectory)
+{
+    std::vector<Job> jobs;
+
+    // number of value combinations of the swept parameters
+    size_t combinations = 1;
+    for (const Variable& variable : variables) {
+        combinations *= variable.values.size();
+    }
+
+    for (const std::string& config : configs) {
+        std::vector<std::pair<int, std::string>> runs;
+        if (!queryRuns(launcher, config, runs)) {
+            std::exit(1);
+        }
+
+        for (const auto& run : runs) {
+            for (size_t combination = 0; combination < combinations; combination++) {
+                Job job;
+                job.config = config;
+                job.runNumber = run.first;
+                job.iterationVariables = run.second;
+                job.id = config + "-" + std::to_string(run.first) + (variables.empty() ? "" : "-v" + std::to_string(combination));
+                job.directory = outputDirectory / "runs" / job.id;
+
+                job.command = launcher;
+                job.command.insert(job.command.end(), {"-u", "Cmdenv", "-c", config, "-r", std::to_string(run.first),
+                                                       "--cmdenv-express-mode=true",
+                                                       "--result-dir=" + job.directory.string(),
+                                                       "--**.scalar-recording=true",
+                                                       "--**.resultsFile=\"" + (job.directory / "results.csv").string() + "\"",
+                                                       "--**.latencyResultsFile=\"" + (job.directory / "latency.csv").string() + "\""});
+
+                // the combination index is a mixed radix number over the value lists
+                size_t remainder = combination;
+                for (const Variable& variable : variables) {
+                    const std::string& value = variable.values[remainder % variable.values.size()];
+                    remainder /= variable.values.size();
+
+                    job.values.push_back(value);
+                    job.command.push_back("--" + variable.name + "=" + value);
+                }
+
+                jobs.push_back(job);
+            }
+        }
+    }
+
+    return jobs;
+}
+
+bool isDone(const Job& job)
+{
+    std::ifstream marker(job.directory / "done");
+    std::string command;
+
+    return marker && std::getline(marker, command) && command == joinCommand(job.command);
+}
+
+bool runJob(Job& job)
+{
+    // previous partial output would be appended to, or a write-ahead log recovered from
+    fs::remove_all(job.directory);
+    fs::create_directories(job.directory);
+
+    // everything the child needs is prepared before the fork, which may not allocate
+    std::string logPath = (job.directory / "output.log").string();
+
+    std::vector<char*> arguments;
+    for (std::string& argument : job.command) {
+        arguments.push_back(&argument[0]);
+    }
+    arguments.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+
+    if (pid == 0) {
+        int log = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+
+        execvp(arguments[0], arguments.data());
+        _exit(127);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return false;
+    }
+
+    // the marker is renamed into place so that a killed sweep never leaves a partial one
+    std::ofstream((job.directory / "done.tmp").string()) << joinCommand(job.command) << "\n";
+    fs::rename(job.directory / "done.tmp", job.directory / "done");
+
+    return true;
+}
+
+void runWorker(size_t index, std::vector<WorkerQueue>& queues, std::vector<Job>& jobs, std::atomic<size_t>& finished, size_t total)
+{
+    while (true) {
+        size_t jobIndex = SIZE_MAX;
+
+        // own queue from the front, then steal from the back of the others
+        for (size_t offset = 0; offset < queues.size() && jobIndex == SIZE_MAX; offset++) {
+            WorkerQueue& queue = queues[(index + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.jobs.empty()) {
+                if (offset == 0) {
+                    jobIndex = queue.jobs.front();
+                    queue.jobs.pop_front();
+                }
+                else {
+                    jobIndex = queue.jobs.back();
+                    queue.jobs.pop_back();
+                }
+            }
+        }
+
+        // no job is ever added, so empty queues mean the sweep is over
+        if (jobIndex == SIZE_MAX) {
+            return;
+        }
+
+        Job& job = jobs[jobIndex];
+
+        auto start = std::chrono::steady_clock::now();
+        job.succeeded = runJob(job);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "[" << ++finished << "/" << total << "] " << job.id << (job.succeeded ? " done" : " FAILED") << " in "
+                  << elapsed << "s" << (job.succeeded ? "" : ", see " + (job.directory / "output.log").string()) << std::endl;
+    }
+}
+
+// appends the rows of a per-run csv file, prefixed with the run columns
+void mergeCsv(const Job& job, const fs::path& file, const std::string& prefix, std::string& header, std::ofstream& out)
+{
+    std::ifstream in(file);
+    std::string line;
+
+    if (!in || !std::getline(in, line)) {
+        return;
+    }
+
+    if (header.empty()) {
+        header = line;
+        out << "id,config,run,iterationVariables" << prefix << "," << header << "\n";
+    }
+
+    std::string runColumns = quoteCsv(job.id) + "," + quoteCsv(job.config) + "," + std::to_string(job.runNumber) + ","
+            + quoteCsv(job.iterationVariables);
+
+    for (const std::string& value : job.values) {
+        runColumns += "," + quoteCsv(value);
+    }
+
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            out << runColumns << "," << line << "\n";
+        }
+    }
+}
+
+// appends the scalars of the OMNeT++ scalar files of a run
+void mergeScalars(const Job& job, std::ofstream& out)
+{
+    for (const auto& entry : fs::directory_iterator(job.directory)) {
+        if (entry.path().extension() != ".sca") {
+            continue;
+        }
+
+        std::ifstream in(entry.path());
+        std::string line;
+
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string keyword, module, name, value;
+
+            if (!(fields >> keyword) || keyword != "scalar") {
+                continue;
+            }
+
+            fields >> module;
+
+            // scalar names containing spaces are quoted
+            fields >> std::ws;
+            if (fields.peek() == '"') {
+                fields.get();
+                std::getline(fields, name, '"');
+            }
+            else {
+                fields >> name;
+            }
+
+            if (fields >> value) {
+                out << quoteCsv(job.id) << "," << quoteCsv(module) << "," << quoteCsv(name) << "," << value << "\n";
+            }
+        }
+    }
+}
+
+void mergeResults(const std::vector<Job>& jobs, const std::vector<Variable>& variables, const fs::path& outputDirectory)
+{
+    std::string prefix;
+    for (const Variable& variable : variables) {
+        prefix += "," + quoteCsv(variable.name);
+    }
+
+    std::ofstream index(outputDirectory / "index.csv");
+    index << "id,config,run,iterationVariables" << prefix << ",status,directory\n";
+
+    std::ofstream results(outputDirectory / "results.csv");
+    std::ofstream latency(outputDirectory / "latency.csv");
+    std::ofstream scalars(outputDirectory / "scalars.csv");
+    scalars << "id,module,name,value\n";
+
+    std::string resultsHeader;
+    std::string latencyHeader;
+
+    for (const Job& job : jobs) {
+        index << quoteCsv(job.id) << "," << quoteCsv(job.config) << "," << job.runNumber << "," << quoteCsv(job.iterationVariables);
+        for (const std::string& value : job.values) {
+            index << "," << quoteCsv(value);
+        }
+        index << "," << (job.succeeded ? "done" : "failed") << "," << quoteCsv(job.directory.string()) << "\n";
+
+        if (!job.succeeded) {
+            continue;
+        }
+
+        mergeCsv(job, job.directory / "results.csv", prefix, resultsHeader, results);
+        mergeCsv(job, job.directory / "latency.csv", prefix, latencyHeader, latency);
+        mergeScalars(job, scalars);
+    }
+}
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [-c config]... [-s parameter=value1,value2,...]... [-j jobs] [-o output directory]"
+              << " [-- launcher [arguments]]" << std::endl
+              << "Run from the simulations directory; the launcher defaults to ./run" << std::endl
+              << "A parameter is a full path pattern such as **.app[*].packetBER; a bare name is matched as **.name" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> configs;
+    std::vector<Variable> variables;
+    std::vector<std::string> launcher;
+    fs::path outputDirectory = "results/sweep";
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+
+        if (option == "--") {
+            launcher.assign(argv + i + 1, argv + argc);
+            break;
+        }
+
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+
+        if (option == "-c") {
+            configs.push_back(value);
+        }
+        else if (option == "-s") {
+            size_t separator = value.find('=');
+            if (separator == std::string::npos || splitValues(value.substr(separator + 1)).empty()) {
+                std::cerr << "Invalid sweep variable: " << value << std::endl;
+                return 1;
+            }
+
+            // a bare parameter name applies to every module that has it
+            std::string name = value.substr(0, separator);
+            if (name.find('.') == std::string::npos) {
+                name = "**." + name;
+            }
+
+            variables.push_back(Variable{name, splitValues(value.substr(separator + 1))});
+        }
+        else if (option == "-j") {
+            workers = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (option == "-o") {
+            outputDirectory = value;
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (configs.empty()) {
+        configs.push_back("General");
+    }
+
+    if (launcher.empty()) {
+        launcher.push_back("./run");
+    }
+
+    std::vector<Job> jobs = expandJobs(launcher, configs, variables, outputDirectory);
+    fs::create_directories(outputDirectory / "runs");
+
+    // finished runs are kept from a previous sweep
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].succeeded = isDone(jobs[i]);
+        if (!jobs[i].succeeded) {
+            pending.push_back(i);
+        }
+    }
+
+    std::cout << jobs.size() << " runs, " << jobs.size() - pending.size() << " already done, " << pending.size() << " to run on "
+              << workers << " workers" << std::endl;
+
+    // round robin keeps the runs of one configuration spread over the workers
+    std::vector<WorkerQueue> queues(std::min(workers, std::max<size_t>(pending.size(), 1)));
+    for (size_t i = 0; i < pending.size(); i++) {
+        queues[i % queues.size()].jobs.push_back(pending[i]);
+    }
+
+    std::atomic<size_t> finished(0);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < queues.size(); i++) {
+        threads.emplace_back(runWorker, i, std::ref(queues), std::ref(jobs), std::ref(finished), pending.size());
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    mergeResults(jobs, variables, outputDirectory);
+
+    size_t failed = std::count_if(jobs.begin(), jobs.end(), [](const Job& job) { return !job.succeeded; });
+    std::cout << "Merged results into " << outputDirectory.string() << (failed > 0 ? ", " + std::to_string(failed) + " runs failed" : "")
+              << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
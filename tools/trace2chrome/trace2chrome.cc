@@ -0,0 +1,246 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+// Converts a binary message trace written by MessageTracer into the Chrome trace
+// event format, which can be opened with chrome://tracing or https://ui.perfetto.dev.
+//
+// Every simulation module becomes a process; each PUBLISH message becomes an async
+// span per module it visits, plus an overall lifecycle span in the "messages" process.
+
+#include "tracing/TraceFormat.h"
+#include "types/shared/TraceEvent.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace mqttsn;
+
+namespace {
+
+struct Span {
+    int64_t begin;
+    int64_t end;
+};
+
+const char* eventToString(uint16_t event)
+{
+    switch (event) {
+        case TraceEvent::PUBLISHER_SEND:
+            return "publisher send";
+        case TraceEvent::PUBLISHER_RETRANSMIT:
+            return "publisher retransmit";
+        case TraceEvent::PUBLISHER_ACK:
+            return "publisher puback";
+        case TraceEvent::PUBLISHER_PUBREC:
+            return "publisher pubrec";
+        case TraceEvent::PUBLISHER_COMPLETE:
+            return "publisher pubcomp";
+        case TraceEvent::GATEWAY_ACCEPT:
+            return "gateway accept";
+        case TraceEvent::GATEWAY_FANOUT:
+            return "gateway fan-out";
+        case TraceEvent::GATEWAY_DISPATCH:
+            return "gateway dispatch";
+        case TraceEvent::GATEWAY_RETRANSMIT:
+            return "gateway retransmit";
+        case TraceEvent::GATEWAY_ACK:
+            return "gateway subscriber ack";
+        case TraceEvent::SUBSCRIBER_RECEIVE:
+            return "subscriber receive";
+        case TraceEvent::SUBSCRIBER_DELIVER:
+            return "subscriber deliver";
+        default:
+            return "unknown";
+    }
+}
+
+int qosToInt(uint8_t qos)
+{
+    // QoS -1 is encoded with both flag bits set
+    return qos == 0b11 ? -1 : qos;
+}
+
+std::string escape(const std::string& text)
+{
+    std::string escaped;
+
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+// microseconds with nanosecond precision
+std::string toMicroseconds(int64_t nanoseconds)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%lld.%03lld", (long long) (nanoseconds / 1000), (long long) (nanoseconds % 1000));
+
+    return text;
+}
+
+bool readTrace(std::istream& in, std::map<int32_t, std::string>& modules, std::vector<TraceRecord>& records)
+{
+    char magic[sizeof(TRACE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a message trace file" << std::endl;
+        return false;
+    }
+
+    uint8_t blockType;
+    while (in.read(reinterpret_cast<char*>(&blockType), sizeof(blockType))) {
+        if (blockType == TraceBlockType::MODULE_BLOCK) {
+            int32_t moduleId;
+            uint16_t length;
+            in.read(reinterpret_cast<char*>(&moduleId), sizeof(moduleId));
+            in.read(reinterpret_cast<char*>(&length), sizeof(length));
+
+            std::string path(length, '\0');
+            in.read(&path[0], length);
+            modules[moduleId] = path;
+        }
+        else if (blockType == TraceBlockType::RECORD_BLOCK) {
+            uint32_t count;
+            in.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+            size_t offset = records.size();
+            records.resize(offset + count);
+            in.read(reinterpret_cast<char*>(&records[offset]), count * sizeof(TraceRecord));
+        }
+        else {
+            std::cerr << "Unknown block type " << (int) blockType << std::endl;
+            return false;
+        }
+
+        if (!in) {
+            std::cerr << "Truncated message trace file" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void writeMetadata(std::ostream& out, int32_t pid, const std::string& name, bool& first)
+{
+    out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"tid\":0,"
+        << "\"args\":{\"name\":\"" << escape(name) << "\"}}";
+    first = false;
+}
+
+void writeSpanEvent(std::ostream& out, char phase, int32_t pid, uint32_t identifier, int64_t timestamp)
+{
+    out << ",\n{\"ph\":\"" << phase << "\",\"cat\":\"publish\",\"name\":\"PUBLISH " << identifier << "\",\"id\":" << identifier
+        << ",\"pid\":" << pid << ",\"tid\":0,\"ts\":" << toMicroseconds(timestamp) << "}";
+}
+
+void writeStepEvent(std::ostream& out, int32_t pid, const TraceRecord& record, const std::string& modulePath)
+{
+    const char* valueName = record.event == TraceEvent::GATEWAY_FANOUT ? "subscribers" : "msgId";
+
+    out << ",\n{\"ph\":\"n\",\"cat\":\"publish\",\"name\":\"" << eventToString(record.event) << "\",\"id\":" << record.identifier
+        << ",\"pid\":" << pid << ",\"tid\":0,\"ts\":" << toMicroseconds(record.timestamp) << ",\"args\":{"
+        << "\"module\":\"" << escape(modulePath) << "\",\"" << valueName << "\":" << record.value << ",\"qos\":" << qosToInt(record.qos)
+        << ",\"dup\":" << (int) record.dup << "}}";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [output json file]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::map<int32_t, std::string> modules;
+    std::vector<TraceRecord> records;
+
+    if (!readTrace(in, modules, records)) {
+        return 1;
+    }
+
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Failed to open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc == 3 ? file : std::cout;
+
+    // module ids are positive, so pid 0 is free for the lifecycle of whole messages
+    const int32_t lifecyclePid = 0;
+
+    std::map<uint32_t, Span> lifecycles;
+    std::map<std::pair<int32_t, uint32_t>, Span> moduleSpans;
+
+    for (const TraceRecord& record : records) {
+        auto lifecycle = lifecycles.emplace(record.identifier, Span{record.timestamp, record.timestamp}).first;
+        lifecycle->second.begin = std::min(lifecycle->second.begin, record.timestamp);
+        lifecycle->second.end = std::max(lifecycle->second.end, record.timestamp);
+
+        auto moduleSpan = moduleSpans.emplace(std::make_pair(record.moduleId, record.identifier), Span{record.timestamp, record.timestamp}).first;
+        moduleSpan->second.begin = std::min(moduleSpan->second.begin, record.timestamp);
+        moduleSpan->second.end = std::max(moduleSpan->second.end, record.timestamp);
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    bool first = true;
+    writeMetadata(out, lifecyclePid, "messages", first);
+    for (const auto& module : modules) {
+        writeMetadata(out, module.first, module.second, first);
+    }
+
+    for (const auto& lifecycle : lifecycles) {
+        writeSpanEvent(out, 'b', lifecyclePid, lifecycle.first, lifecycle.second.begin);
+        writeSpanEvent(out, 'e', lifecyclePid, lifecycle.first, lifecycle.second.end);
+    }
+
+    for (const auto& moduleSpan : moduleSpans) {
+        writeSpanEvent(out, 'b', moduleSpan.first.first, moduleSpan.first.second, moduleSpan.second.begin);
+        writeSpanEvent(out, 'e', moduleSpan.first.first, moduleSpan.first.second, moduleSpan.second.end);
+    }
+
+    for (const TraceRecord& record : records) {
+        auto module = modules.find(record.moduleId);
+        const std::string& modulePath = module != modules.end() ? module->second : std::to_string(record.moduleId);
+
+        writeStepEvent(out, lifecyclePid, record, modulePath);
+        writeStepEvent(out, record.moduleId, record, modulePath);
+    }
+
+    out << "\n]}\n";
+
+    std::cerr << "Converted " << records.size() << " records of " << lifecycles.size() << " messages" << std::endl;
+    return 0;
+}